@@ -0,0 +1,81 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "client/posix/udp_client.h"
+#include "server/posix/udp_server.h"
+
+/*
+Loopback UDP ping-pong against the POSIX UdpServer, once with blocking loops and once in
+busy-poll mode, printing the receive-to-callback latency the server and the client measured.
+
+run => ./busy_poll_latency [port] [server cpu] [client cpu]
+*/
+
+namespace {
+
+    constexpr int kPings = 5000;
+
+    void print(const char* name, const LatencyStats& stats) {
+        auto us = [](std::chrono::nanoseconds ns) { return ns.count() / 1000.0; };
+        std::cout << name << " n=" << stats.count << " p50=" << us(stats.p50)
+                  << "us p99=" << us(stats.p99) << "us p99.9=" << us(stats.p999)
+                  << "us max=" << us(stats.max) << "us\n";
+    }
+
+    void run(int port, BusyPollOptions busy, int client_cpu) {
+        UdpServerOptions options;
+        options.busy_poll = busy;
+        UdpServer server(port, [](int, const std::string& req) { return req; }, options);
+        if (server.start().code() != ErrorCode::NO_ERROR) {
+            std::cout << "server start failed\n";
+            return;
+        }
+
+        NetworkConfig cfg{"127.0.0.1", port};
+        cfg.connection_type = ClientType::UDP;
+        busy.cpu = client_cpu;
+        cfg.busy_poll = busy;
+        UdpClientPosix client(cfg);
+        std::atomic<int> replies{0};
+        client.recieve_async([&](const std::vector<uint8_t>&, Error) { ++replies; });
+        client.connect();
+
+        // One ping in flight at a time, with a pause now and then so quiet periods occur
+        for (int i = 0; i < kPings; ++i) {
+            client.send_sync({'p'});
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(100);
+            while (replies <= i && std::chrono::steady_clock::now() < deadline) {
+            }
+            if (i % 100 == 99)
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+
+        print("  server", server.latency_stats());
+        client.disconnect();
+        server.stop();
+    }
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const int port = argc > 1 ? std::stoi(argv[1]) : 9400;
+
+    BusyPollOptions blocking;
+    blocking.measure_latency = true;
+
+    BusyPollOptions busy = blocking;
+    busy.enabled = true;
+    busy.spin_window = std::chrono::milliseconds(1);
+    busy.cpu = argc > 2 ? std::stoi(argv[2]) : -1;
+    const int client_cpu = argc > 3 ? std::stoi(argv[3]) : -1;
+
+    std::cout << "blocking loops:\n";
+    run(port, blocking, -1);
+    std::cout << "busy poll (spin 1 ms, then block):\n";
+    run(port, busy, client_cpu);
+    return 0;
+}
@@ -0,0 +1,94 @@
+#include <asio.hpp>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "client/asio/tcp_client.h"
+#include "rpc/rpc_client.h"
+#include "rpc/rpc_server.h"
+#include "server/asio/tcp_server.h"
+
+/*
+Calls per second over a single connection to an echoing RpcServer, with 1 call outstanding
+at a time (one round trip per call) and with more kept in flight by RpcClient.
+
+run => ./rpc_pipeline [port]
+*/
+
+namespace {
+
+    constexpr int kCalls = 100000;
+
+    double calls_per_second(const std::shared_ptr<RpcClient>& rpc, int window) {
+        const std::vector<uint8_t> request(64, 'r');
+        std::promise<void> done;
+        std::atomic<int> issued{0};
+        std::atomic<int> completed{0};
+
+        // Every reply sends the next call, so window calls stay outstanding
+        std::function<void(RpcReply)> on_reply = [&](RpcReply) {
+            if (issued++ < kCalls)
+                rpc->call_async(request, on_reply);
+            if (++completed == kCalls)
+                done.set_value();
+        };
+
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < window; ++i) {
+            ++issued;
+            rpc->call_async(request, on_reply);
+        }
+        done.get_future().wait();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return kCalls / elapsed.count();
+    }
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    ServerConfig cfg;
+    cfg.port = argc > 1 ? std::stoi(argv[1]) : 9200;
+    cfg.backend_type = ServerConfig::BackendType::ASIO;
+
+    RpcServer rpc_server([](int, std::span<const uint8_t> request, RpcServer::Responder reply) {
+        reply.reply(request);
+    });
+    TcpServerAsio server(
+        cfg, rpc_server.receive_callback(), [](int, const std::string&) {},
+        rpc_server.disconnect_callback());
+    rpc_server.attach(&server);
+    if (server.listen().code() != ErrorCode::NO_ERROR) {
+        std::cerr << "listen failed on port " << cfg.port << "\n";
+        return 1;
+    }
+
+    auto io = std::make_shared<asio::io_context>();
+    auto work = asio::make_work_guard(*io);
+    std::thread runner([&]() { io->run(); });
+
+    auto tcp = std::make_shared<TcpClientAsio>(NetworkConfig{"127.0.0.1", cfg.port}, io);
+    if (tcp->connect().code() != ErrorCode::NO_ERROR) {
+        std::cerr << "connect failed\n";
+        return 1;
+    }
+    auto rpc = RpcClient::create(tcp);
+
+    for (int window : {1, 16, 256}) {
+        const long rate = static_cast<long>(calls_per_second(rpc, window));
+        std::cout << "in flight " << window << ": " << rate << " calls/s\n";
+    }
+
+    rpc.reset();
+    tcp->disconnect();
+    server.gracefull_shutdown();
+    work.reset();
+    io->stop();
+    runner.join();
+    return 0;
+}
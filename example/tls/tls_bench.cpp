@@ -0,0 +1,142 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "client/asio/tcp_client.h"
+#include "server/posix/tcp_server.h"
+
+/*
+Loopback benchmark of the TLS transport: connect rate (plain, full and resumed TLS) and client to
+server throughput (plain vs TLS) against the POSIX server.
+
+create keys that place in folder keys:
+    openssl req -x509 -newkey ec -pkeyopt ec_paramgen_curve:P-256 -nodes -days 365 \
+        -subj "/CN=localhost" -addext "subjectAltName=IP:127.0.0.1" \
+        -keyout keys/key.pem -out keys/cert.pem
+
+run => ./tls_bench keys/cert.pem keys/key.pem
+*/
+
+namespace {
+
+    using Clock = std::chrono::steady_clock;
+
+    constexpr int kHandshakes = 200;
+    constexpr size_t kChunk = 64 * 1024;
+    constexpr auto kThroughputTime = std::chrono::seconds(2);
+
+    double seconds_since(Clock::time_point start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    // One byte round trip, so the client also reads the session ticket of the connection
+    bool ping(TcpClientAsio& client) {
+        if (client.send_sync({'p'}).code() != ErrorCode::NO_ERROR)
+            return false;
+        std::vector<uint8_t> reply;
+        return client.recieve_sync(reply).code() == ErrorCode::NO_ERROR && !reply.empty();
+    }
+
+    // Connects per second; a fresh client every time forces full TLS handshakes
+    double handshake_rate(const NetworkConfig& cfg, std::shared_ptr<asio::io_context> io,
+                          bool resume) {
+        auto shared = std::make_shared<TcpClientAsio>(cfg, io);
+        auto start = Clock::now();
+        for (int i = 0; i < kHandshakes; ++i) {
+            auto client = resume ? shared : std::make_shared<TcpClientAsio>(cfg, io);
+            if (client->connect().code() != ErrorCode::NO_ERROR || !ping(*client)) {
+                std::cout << "handshake " << i << " failed\n";
+                return 0;
+            }
+            client->disconnect();
+        }
+        return kHandshakes / seconds_since(start);
+    }
+
+    // MB/s the server receives from one client sending kChunk blocks
+    double throughput(const NetworkConfig& cfg, std::shared_ptr<asio::io_context> io,
+                      std::atomic<uint64_t>& received) {
+        TcpClientAsio client(cfg, io);
+        if (client.connect().code() != ErrorCode::NO_ERROR)
+            return 0;
+        const std::vector<uint8_t> chunk(kChunk, 'x');
+        const uint64_t base = received;
+        uint64_t sent = 0;
+        auto start = Clock::now();
+        while (Clock::now() - start < kThroughputTime) {
+            if (client.send_sync(chunk).code() != ErrorCode::NO_ERROR)
+                return 0;
+            sent += chunk.size();
+        }
+        while (received - base < sent)
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        const double elapsed = seconds_since(start);
+        client.disconnect();
+        return sent / elapsed / (1024 * 1024);
+    }
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cout << "usage: " << argv[0] << " <cert.pem> <key.pem> [port]\n";
+        return 1;
+    }
+    const int port = argc > 3 ? std::stoi(argv[3]) : 8443;
+
+    std::atomic<uint64_t> received{0};
+    std::atomic<bool> echo{true};
+    TcpServer* tls_server = nullptr;
+    TcpServer* plain_server = nullptr;
+    auto make_rx = [&](TcpServer*& server) {
+        return [&](int fd, const std::string&, const std::vector<uint8_t>& data) {
+            received += data.size();
+            if (echo)
+                server->send(fd, data);
+        };
+    };
+    auto on_con = [](int, const std::string&) {};
+    auto on_disc = [](int, const std::string&) {};
+
+    ServerConfig scfg;
+    scfg.port = port;
+    scfg.event_loop = ServerConfig::EventLoopType::EPOLL;
+    TcpServer plain(scfg, make_rx(plain_server), on_con, on_disc);
+    plain_server = &plain;
+
+    scfg.port = port + 1;
+    scfg.ssl_config.public_key = argv[1];
+    scfg.ssl_config.private_key = argv[2];
+    TcpServer secure(scfg, make_rx(tls_server), on_con, on_disc);
+    tls_server = &secure;
+
+    for (TcpServer* server : {&plain, &secure}) {
+        Error err = server->listen();
+        if (err.code() != ErrorCode::NO_ERROR) {
+            std::cout << "listen failed: " << err.message() << "\n";
+            return 1;
+        }
+    }
+
+    auto io = std::make_shared<asio::io_context>();
+    NetworkConfig plain_cfg{"127.0.0.1", port};
+    NetworkConfig tls_cfg{"127.0.0.1", port + 1};
+    tls_cfg.ssl_config.public_key = argv[1];
+
+    std::cout << "connects/s plain:     " << handshake_rate(plain_cfg, io, false) << "\n";
+    std::cout << "handshakes/s full:    " << handshake_rate(tls_cfg, io, false) << "\n";
+    std::cout << "handshakes/s resumed: " << handshake_rate(tls_cfg, io, true) << "\n";
+
+    echo = false;
+    std::cout << "MB/s plain: " << throughput(plain_cfg, io, received) << "\n";
+    std::cout << "MB/s TLS:   " << throughput(tls_cfg, io, received) << "\n";
+    std::cout << "server kTLS send connections: " << secure.tls_stats().ktls_send << "\n";
+
+    secure.gracefull_shutdown();
+    plain.gracefull_shutdown();
+    return 0;
+}
@@ -0,0 +1,250 @@
+#include "buffer/buffer_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
+namespace buffer_pool {
+
+    namespace {
+
+        constexpr size_t kThreadCacheDepth = 16;  // per class; half spills or refills at once
+        constexpr size_t kGlobalBytesPerClass = 4 * 1024 * 1024;
+
+        constexpr size_t class_size(size_t cls) { return kMinClassSize << (2 * cls); }
+
+        static_assert(class_size(kClassCount - 1) == kMaxClassSize);
+
+        // Smallest class holding `size` bytes
+        size_t class_for_size(size_t size) {
+            size_t cls = 0;
+            while (class_size(cls) < size)
+                ++cls;
+            return cls;
+        }
+
+        // Class a returned buffer fits, or kClassCount when it is not worth keeping
+        size_t class_for_capacity(size_t capacity) {
+            if (capacity < kMinClassSize)
+                return kClassCount;
+            size_t cls = kClassCount - 1;
+            while (class_size(cls) > capacity)
+                --cls;
+            return capacity < 2 * class_size(cls) ? cls : kClassCount;
+        }
+
+        using Storage = std::vector<uint8_t>;
+
+        struct ThreadCache;
+
+        struct FreeList {
+            std::mutex mutex;
+            std::vector<Storage> buffers;
+        };
+
+        struct Global {
+            FreeList lists[kClassCount];
+
+            std::mutex registry_mutex;  // guards caches
+            std::vector<ThreadCache*> caches;
+
+            // Counters of exited threads and of releases that happen during thread teardown
+            std::atomic<uint64_t> hits{0};
+            std::atomic<uint64_t> misses{0};
+            std::atomic<uint64_t> released{0};
+            std::atomic<uint64_t> dropped{0};
+        };
+
+        // Never destroyed: buffers can come back from handlers torn down at static destruction
+        Global& global() {
+            static Global* g = new Global;
+            return *g;
+        }
+
+        // Single-writer counter; readers only need a recent value
+        void bump(std::atomic<uint64_t>& counter) {
+            counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+
+        bool take_global(size_t cls, Storage& out) {
+            FreeList& list = global().lists[cls];
+            std::lock_guard<std::mutex> lock(list.mutex);
+            if (list.buffers.empty())
+                return false;
+            out = std::move(list.buffers.back());
+            list.buffers.pop_back();
+            return true;
+        }
+
+        // Moves buffers [first, end) of `from` to the free list, freeing what does not fit
+        size_t give_global(size_t cls, std::vector<Storage>& from, size_t first) {
+            FreeList& list = global().lists[cls];
+            const size_t limit = kGlobalBytesPerClass / class_size(cls);
+            size_t dropped = 0;
+            std::lock_guard<std::mutex> lock(list.mutex);
+            for (size_t i = first; i < from.size(); ++i) {
+                if (list.buffers.size() < limit)
+                    list.buffers.push_back(std::move(from[i]));
+                else
+                    ++dropped;
+            }
+            from.resize(first);
+            return dropped;
+        }
+
+        struct ThreadCache {
+            std::vector<Storage> free[kClassCount];
+
+            std::atomic<uint64_t> hits{0};
+            std::atomic<uint64_t> misses{0};
+            std::atomic<uint64_t> released{0};
+            std::atomic<uint64_t> dropped{0};
+
+            ThreadCache();
+            ~ThreadCache();
+
+            bool take(size_t cls, Storage& out) {
+                auto& list = free[cls];
+                if (list.empty()) {
+                    FreeList& shared = global().lists[cls];
+                    std::lock_guard<std::mutex> lock(shared.mutex);
+                    size_t n = std::min(shared.buffers.size(), kThreadCacheDepth / 2);
+                    for (size_t i = 0; i < n; ++i) {
+                        list.push_back(std::move(shared.buffers.back()));
+                        shared.buffers.pop_back();
+                    }
+                }
+                if (list.empty())
+                    return false;
+                out = std::move(list.back());
+                list.pop_back();
+                return true;
+            }
+
+            void give(size_t cls, Storage&& data) {
+                auto& list = free[cls];
+                if (list.size() >= kThreadCacheDepth)
+                    dropped.fetch_add(give_global(cls, list, kThreadCacheDepth / 2),
+                                      std::memory_order_relaxed);
+                list.push_back(std::move(data));
+                bump(released);
+            }
+        };
+
+        // Trivially destructible, so it stays readable while the thread's other
+        // thread_locals are being destroyed
+        thread_local bool t_cache_gone = false;
+
+        ThreadCache* local_cache() {
+            if (t_cache_gone)
+                return nullptr;
+            thread_local ThreadCache cache;
+            return &cache;
+        }
+
+        ThreadCache::ThreadCache() {
+            Global& g = global();
+            std::lock_guard<std::mutex> lock(g.registry_mutex);
+            g.caches.push_back(this);
+        }
+
+        ThreadCache::~ThreadCache() {
+            t_cache_gone = true;
+
+            Global& g = global();
+            uint64_t lost = dropped.load(std::memory_order_relaxed);
+            for (size_t cls = 0; cls < kClassCount; ++cls)
+                lost += give_global(cls, free[cls], 0);
+
+            std::lock_guard<std::mutex> lock(g.registry_mutex);
+            g.caches.erase(std::find(g.caches.begin(), g.caches.end(), this));
+            g.hits += hits.load(std::memory_order_relaxed);
+            g.misses += misses.load(std::memory_order_relaxed);
+            g.released += released.load(std::memory_order_relaxed);
+            g.dropped += lost;
+        }
+
+    }  // namespace
+
+    Buffer& Buffer::operator=(Buffer&& other) noexcept {
+        if (this != &other) {
+            release();
+            data_ = std::move(other.data_);
+            other.data_ = {};
+        }
+        return *this;
+    }
+
+    void Buffer::release() {
+        if (data_.capacity() == 0)
+            return;
+
+        Storage data = std::move(data_);
+        data_ = {};
+
+        const size_t cls = class_for_capacity(data.capacity());
+        ThreadCache* cache = local_cache();
+        if (cls == kClassCount) {
+            if (cache)
+                bump(cache->dropped);
+            else
+                ++global().dropped;
+            return;
+        }
+
+        if (cache) {
+            cache->give(cls, std::move(data));
+            return;
+        }
+
+        std::vector<Storage> one;
+        one.push_back(std::move(data));
+        const size_t dropped = give_global(cls, one, 0);
+        global().released += 1 - dropped;
+        global().dropped += dropped;
+    }
+
+    Buffer acquire(size_t size) {
+        ThreadCache* cache = local_cache();
+        auto count = [&](bool hit) {
+            if (cache)
+                bump(hit ? cache->hits : cache->misses);
+            else
+                ++(hit ? global().hits : global().misses);
+        };
+
+        Storage data;
+        if (size > kMaxClassSize) {
+            count(false);
+            data.resize(size);
+            return Buffer(std::move(data));
+        }
+
+        const size_t cls = class_for_size(size);
+        const bool hit = cache ? cache->take(cls, data) : take_global(cls, data);
+        count(hit);
+        if (!hit)
+            data.reserve(class_size(cls));
+        data.resize(size);
+        return Buffer(std::move(data));
+    }
+
+    Stats stats() {
+        Global& g = global();
+        std::lock_guard<std::mutex> lock(g.registry_mutex);
+
+        Stats out;
+        out.hits = g.hits.load();
+        out.misses = g.misses.load();
+        out.released = g.released.load();
+        out.dropped = g.dropped.load();
+        for (const ThreadCache* cache : g.caches) {
+            out.hits += cache->hits.load(std::memory_order_relaxed);
+            out.misses += cache->misses.load(std::memory_order_relaxed);
+            out.released += cache->released.load(std::memory_order_relaxed);
+            out.dropped += cache->dropped.load(std::memory_order_relaxed);
+        }
+        return out;
+    }
+
+}  // namespace buffer_pool
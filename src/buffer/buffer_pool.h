@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Recycled receive buffers for the asio read paths.
+//
+// Buffers come in four size classes (1K, 4K, 16K, 64K). Every thread keeps a small cache per
+// class and spills to / refills from a bounded process-wide free list, so a steady receive loop
+// runs without touching malloc. A Buffer goes back to the pool when it is destroyed, which for
+// an asio handler is right after the user callback returns.
+namespace buffer_pool {
+
+    constexpr size_t kMinClassSize = 1024;
+    constexpr size_t kMaxClassSize = 65536;
+    constexpr size_t kClassCount = 4;  // 1K, 4K, 16K, 64K
+
+    struct Stats {
+        uint64_t hits = 0;      // acquire() served from a thread cache or the free list
+        uint64_t misses = 0;    // acquire() had to allocate
+        uint64_t released = 0;  // buffers taken back into the pool
+        uint64_t dropped = 0;   // buffers freed because the pool was full or the size unpooled
+    };
+
+    class Buffer {
+      public:
+        Buffer() = default;
+        ~Buffer() { release(); }
+
+        Buffer(Buffer&& other) noexcept : data_(std::move(other.data_)) { other.data_ = {}; }
+        Buffer& operator=(Buffer&& other) noexcept;
+
+        Buffer(const Buffer&) = delete;
+        Buffer& operator=(const Buffer&) = delete;
+
+        // The underlying vector; resizing below the capacity keeps the buffer poolable
+        std::vector<uint8_t>& vec() { return data_; }
+        const std::vector<uint8_t>& vec() const { return data_; }
+
+        uint8_t* data() { return data_.data(); }
+        size_t size() const { return data_.size(); }
+        void resize(size_t n) { data_.resize(n); }
+
+      private:
+        friend Buffer acquire(size_t size);
+        explicit Buffer(std::vector<uint8_t>&& data) : data_(std::move(data)) {}
+        void release();
+
+      private:
+        std::vector<uint8_t> data_;
+    };
+
+    // Buffer of exactly `size` bytes. Sizes above kMaxClassSize are allocated unpooled.
+    Buffer acquire(size_t size);
+
+    // Totals over all threads, including threads that have exited
+    Stats stats();
+
+}  // namespace buffer_pool
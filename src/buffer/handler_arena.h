@@ -0,0 +1,116 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Recycling memory for asio completion handlers.
+//
+// asio allocates every pending operation through the handler's associated allocator. Wrapping
+// a handler with bind_arena() makes that allocator a small fixed-slot arena owned by the
+// connection, so a steady read/write loop keeps reusing the same few slots. Operations larger
+// than a slot, or arriving while all slots are taken, fall back to operator new.
+//
+// Slots are claimed with atomics: operations may be started from any thread and completed on
+// another. The arena must outlive every operation bound to it, which holds when the handler
+// keeps the owning connection alive.
+class HandlerArena {
+  public:
+    static constexpr size_t kSlotSize = 1024;  // a gathered write bound to a strand fits
+    static constexpr size_t kSlots = 4;
+
+    HandlerArena() = default;
+    HandlerArena(const HandlerArena&) = delete;
+    HandlerArena& operator=(const HandlerArena&) = delete;
+
+    void* allocate(size_t size) {
+        if (size <= kSlotSize) {
+            for (size_t i = 0; i < kSlots; ++i) {
+                if (!in_use_[i].load(std::memory_order_relaxed) &&
+                    !in_use_[i].exchange(true, std::memory_order_acquire))
+                    return slots_[i].bytes;
+            }
+        }
+        fallbacks_.fetch_add(1, std::memory_order_relaxed);
+        return ::operator new(size);
+    }
+
+    void deallocate(void* p) {
+        for (size_t i = 0; i < kSlots; ++i) {
+            if (p == slots_[i].bytes) {
+                in_use_[i].store(false, std::memory_order_release);
+                return;
+            }
+        }
+        ::operator delete(p);
+    }
+
+    // Allocations that did not fit the arena
+    size_t fallbacks() const { return fallbacks_.load(std::memory_order_relaxed); }
+
+  private:
+    struct Slot {
+        alignas(std::max_align_t) unsigned char bytes[kSlotSize];
+    };
+
+    Slot slots_[kSlots];
+    std::atomic<bool> in_use_[kSlots] = {};
+    std::atomic<size_t> fallbacks_{0};
+};
+
+template <typename T>
+class ArenaAllocator {
+  public:
+    using value_type = T;
+
+    explicit ArenaAllocator(HandlerArena& arena) noexcept : arena_(&arena) {}
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena_(other.arena_) {}
+
+    T* allocate(size_t n) { return static_cast<T*>(arena_->allocate(sizeof(T) * n)); }
+    void deallocate(T* p, size_t) { arena_->deallocate(p); }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const noexcept {
+        return arena_ == other.arena_;
+    }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const noexcept {
+        return arena_ != other.arena_;
+    }
+
+  private:
+    template <typename>
+    friend class ArenaAllocator;
+
+    HandlerArena* arena_;
+};
+
+// Completion handler whose associated allocator is an ArenaAllocator
+template <typename Handler>
+class ArenaHandler {
+  public:
+    using allocator_type = ArenaAllocator<Handler>;
+
+    ArenaHandler(HandlerArena& arena, Handler handler)
+        : arena_(&arena), handler_(std::move(handler)) {}
+
+    allocator_type get_allocator() const noexcept { return allocator_type(*arena_); }
+
+    template <typename... Args>
+    void operator()(Args&&... args) {
+        handler_(std::forward<Args>(args)...);
+    }
+
+  private:
+    HandlerArena* arena_;
+    Handler handler_;
+};
+
+template <typename Handler>
+ArenaHandler<std::decay_t<Handler>> bind_arena(HandlerArena& arena, Handler&& handler) {
+    return ArenaHandler<std::decay_t<Handler>>(arena, std::forward<Handler>(handler));
+}
@@ -1,7 +1,15 @@
 #include "client/asio/tcp_client.h"
 
 TcpClientAsio::TcpClientAsio(const NetworkConfig& cfg, std::shared_ptr<asio::io_context> io)
-    : ClientInterface(cfg), io_(std::move(io)), socket_(*io_), strand_(asio::make_strand(*io_)) {}
+    : ClientInterface(cfg), io_(std::move(io)), socket_(*io_), strand_(asio::make_strand(*io_)) {
+    if (cfg_.ssl_config.public_key.empty())
+        return;
+
+    tls_ = std::make_unique<TlsContext>();
+    tls_error_ = tls_->init_client(cfg_.ssl_config);
+    if (tls_error_.code() == ErrorCode::NO_ERROR)
+        ssl_context_ = std::make_unique<asio::ssl::context>(make_asio_context(*tls_));
+}
 
 TcpClientAsio::~TcpClientAsio() {
     disconnect();
@@ -12,8 +20,6 @@ TcpClientAsio::~TcpClientAsio() {
 Error TcpClientAsio::connect() {
     asio::error_code ec;
 
-    socket_ = asio::ip::tcp::socket(*io_);
-
     auto addr = asio::ip::make_address(cfg_.ip, ec);
     if (ec) {
         Error err;
@@ -21,7 +27,11 @@ Error TcpClientAsio::connect() {
         return err;
     }
 
+    if (tls_error_.code() != ErrorCode::NO_ERROR)
+        return tls_error_;
+
     asio::ip::tcp::endpoint ep(addr, cfg_.port);
+    reset_socket(ep);
     socket_.connect(ep, ec);
 
     if (ec) {
@@ -30,7 +40,24 @@ Error TcpClientAsio::connect() {
         return err;
     }
 
+    if (tls_) {
+        Error err = start_tls_session();
+        if (err.code() != ErrorCode::NO_ERROR)
+            return err;
+
+        tls_stream_->handshake(asio::ssl::stream_base::client, ec);
+        if (ec) {
+            err.set_code(ErrorCode::SSL_ERROR)
+                ->set_message("TLS handshake failed: " + ec.message());
+            socket_.close(ec);
+            return err;
+        }
+        tls_->on_handshake(tls_stream_->native_handle());
+    }
+
     is_connected_ = true;
+    if (streaming_)
+        asio::dispatch(strand_, [self = shared_from_this()]() { self->arm_stream_read(); });
     return Error{};
 }
 
@@ -47,9 +74,13 @@ Error TcpClientAsio::connect_async(AsyncCallback callback) {
         return err;
     }
 
-    asio::ip::tcp::endpoint ep(addr, cfg_.port);
+    if (tls_error_.code() != ErrorCode::NO_ERROR) {
+        callback(tls_error_);
+        return tls_error_;
+    }
 
-    socket_ = asio::ip::tcp::socket(*io_);
+    asio::ip::tcp::endpoint ep(addr, cfg_.port);
+    reset_socket(ep);
 
     auto self = shared_from_this();
     socket_.async_connect(
@@ -59,16 +90,72 @@ Error TcpClientAsio::connect_async(AsyncCallback callback) {
                 err.set_code(ErrorCode::CONNECTION_FAILED)->set_message("Async connect failed");
                 callback(err);
                 self->start_reconnect_loop();
-            } else {
-                self->reconnecting_ = false;
-                self->is_connected_ = true;
-                callback(Error{});
+                return;
             }
+            self->finish_connect([self, callback](Error err) {
+                if (err.code() != ErrorCode::NO_ERROR) {
+                    callback(err);
+                    self->start_reconnect_loop();
+                } else {
+                    self->reconnecting_ = false;
+                    callback(Error{});
+                }
+            });
         }));
 
     return Error{};
 }
 
+void TcpClientAsio::finish_connect(AsyncCallback done) {
+    if (!tls_) {
+        is_connected_ = true;
+        arm_stream_read();
+        done(Error{});
+        return;
+    }
+
+    Error err = start_tls_session();
+    if (err.code() != ErrorCode::NO_ERROR) {
+        done(err);
+        return;
+    }
+
+    auto self = shared_from_this();
+    auto stream = tls_stream_;
+    stream->async_handshake(
+        asio::ssl::stream_base::client,
+        asio::bind_executor(strand_, [self, stream, done = std::move(done)](
+                                         const asio::error_code& ec) {
+            if (ec) {
+                Error err;
+                err.set_code(ErrorCode::SSL_ERROR)
+                    ->set_message("TLS handshake failed: " + ec.message());
+                done(err);
+                return;
+            }
+            self->tls_->on_handshake(stream->native_handle());
+            self->is_connected_ = true;
+            self->arm_stream_read();
+            done(Error{});
+        }));
+}
+
+Error TcpClientAsio::start_tls_session() {
+    // A fresh SSL per connection; a previous stream stays alive in its pending handlers
+    tls_stream_ = std::make_shared<AsioTlsStream>(socket_, *ssl_context_);
+    const std::string& host =
+        cfg_.ssl_config.server_name.empty() ? cfg_.ip : cfg_.ssl_config.server_name;
+    return tls_->prepare_client(tls_stream_->native_handle(), host, description());
+}
+
+void TcpClientAsio::reset_socket(const asio::ip::tcp::endpoint& ep) {
+    socket_ = asio::ip::tcp::socket(*io_);
+    asio::error_code ec;
+    socket_.open(ep.protocol(), ec);
+    if (!ec)
+        cfg_.socket_options.apply(socket_.native_handle());
+}
+
 // ====================== RECONNECT LOOP ======================
 
 void TcpClientAsio::start_reconnect_loop() {
@@ -81,15 +168,25 @@ void TcpClientAsio::start_reconnect_loop() {
         struct State {
             int delay = 1;
             std::function<void()> attempt;
+            std::function<void()> retry;
         };
         auto state = std::make_shared<State>();
 
+        state->retry = [self, state]() {
+            state->delay = std::min(state->delay * 2, 30);
+            auto timer = std::make_shared<asio::steady_timer>(*self->io_,
+                                                              std::chrono::seconds(state->delay));
+
+            timer->async_wait(
+                asio::bind_executor(self->strand_, [state, timer](const asio::error_code&) mutable {
+                    state->attempt();
+                }));
+        };
+
         state->attempt = [self, state]() mutable {
             if (!self->reconnecting_)
                 return;
 
-            self->socket_ = asio::ip::tcp::socket(*self->io_);
-
             asio::error_code ec;
             auto addr = asio::ip::make_address(self->cfg_.ip, ec);
             if (ec) {
@@ -98,24 +195,21 @@ void TcpClientAsio::start_reconnect_loop() {
             }
 
             asio::ip::tcp::endpoint ep(addr, self->cfg_.port);
+            self->reset_socket(ep);
 
             self->socket_.async_connect(
                 ep, asio::bind_executor(
                         self->strand_, [self, state](const asio::error_code& ec2) mutable {
-                            if (!ec2) {
-                                self->reconnecting_ = false;
-                                self->is_connected_ = true;
+                            if (ec2) {
+                                state->retry();
                                 return;
                             }
-
-                            state->delay = std::min(state->delay * 2, 30);
-                            auto timer = std::make_shared<asio::steady_timer>(
-                                *self->io_, std::chrono::seconds(state->delay));
-
-                            timer->async_wait(asio::bind_executor(
-                                self->strand_, [state, timer](const asio::error_code&) mutable {
-                                    state->attempt();
-                                }));
+                            self->finish_connect([self, state](Error err) {
+                                if (err.code() == ErrorCode::NO_ERROR)
+                                    self->reconnecting_ = false;
+                                else
+                                    state->retry();
+                            });
                         }));
         };
 
@@ -127,7 +221,7 @@ void TcpClientAsio::start_reconnect_loop() {
 
 Error TcpClientAsio::send_sync(const std::vector<uint8_t>& data) {
     asio::error_code ec;
-    asio::write(socket_, asio::buffer(data), ec);
+    with_stream([&](auto& stream) { asio::write(stream, asio::buffer(data), ec); });
 
     if (ec) {
         Error err;
@@ -141,21 +235,111 @@ Error TcpClientAsio::send_sync(const std::vector<uint8_t>& data) {
 // ====================== SEND (ASYNC) ======================
 
 Error TcpClientAsio::send_async(const std::vector<uint8_t>& data, AsyncCallback callback) {
+    PendingSend msg;
+    msg.copy = buffer_pool::acquire(data.size());
+    std::copy(data.begin(), data.end(), msg.copy.data());
+    msg.callback = std::move(callback);
+    enqueue(std::move(msg));
+    return Error{};
+}
+
+Error TcpClientAsio::send_async(std::vector<uint8_t>&& data, AsyncCallback callback) {
+    PendingSend msg;
+    msg.owned = std::move(data);
+    msg.callback = std::move(callback);
+    enqueue(std::move(msg));
+    return Error{};
+}
+
+void TcpClientAsio::flush(AsyncCallback callback) {
     auto self = shared_from_this();
+    asio::dispatch(strand_, [self, callback = std::move(callback)]() mutable {
+        if (self->completed_messages_ == self->enqueued_messages_) {
+            callback(Error{});
+            return;
+        }
+        self->flush_waiters_.emplace_back(self->enqueued_messages_, std::move(callback));
+    });
+}
 
-    asio::async_write(
-        socket_, asio::buffer(data),
-        asio::bind_executor(strand_, [self, callback](const asio::error_code& ec, std::size_t) {
-            if (ec) {
-                Error err;
-                err.set_code(ErrorCode::SEND_FAILED)->set_message("Async send failed");
-                callback(err);
-            } else {
-                callback(Error{});
-            }
-        }));
+void TcpClientAsio::enqueue(PendingSend msg) {
+    queued_bytes_ += msg.bytes().size();
 
-    return Error{};
+    // The queue is only used on the strand; from its own handlers this runs inline
+    auto self = shared_from_this();
+    asio::dispatch(strand_, bind_arena(arena_, [self, msg = std::move(msg)]() mutable {
+                       self->send_queue_.push_back(std::move(msg));
+                       ++self->enqueued_messages_;
+                       if (!self->writing_)
+                           self->do_write();
+                   }));
+}
+
+void TcpClientAsio::do_write() {
+    // Everything queued so far goes out in one gathered write, in send_async() order
+    writing_ = true;
+    inflight_.assign(std::make_move_iterator(send_queue_.begin()),
+                     std::make_move_iterator(send_queue_.end()));
+    send_queue_.clear();
+
+    inflight_buffers_.clear();
+    for (const auto& msg : inflight_) inflight_buffers_.push_back(asio::buffer(msg.bytes()));
+
+    auto on_write = [self = shared_from_this(), tls = tls_stream_](const asio::error_code& ec,
+                                                                   std::size_t) {
+        self->finish_write(ec);
+    };
+    // A span keeps asio from copying the buffer vector into the write operation
+    with_stream([&](auto& stream) {
+        asio::async_write(stream, std::span<const asio::const_buffer>(inflight_buffers_),
+                          asio::bind_executor(strand_, bind_arena(arena_, std::move(on_write))));
+    });
+}
+
+void TcpClientAsio::finish_write(const asio::error_code& ec) {
+    Error err;
+    if (ec)
+        err.set_code(ErrorCode::SEND_FAILED)->set_message("Async send failed");
+
+    // writing_ stays set, so sends from the callbacks queue up behind this batch
+    size_t done = 0;
+    for (auto& msg : inflight_) {
+        done += msg.bytes().size();
+        if (msg.callback)
+            msg.callback(err);
+    }
+    completed_messages_ += inflight_.size();
+    if (!ec) {
+        sent_messages_ += inflight_.size();
+        ++write_batches_;
+    }
+    inflight_.clear();
+    inflight_buffers_.clear();
+
+    if (ec) {
+        // The connection is gone; nothing queued behind the failed write can follow it.
+        // Swapped out first: the callbacks may queue new messages.
+        std::deque<PendingSend> failed;
+        failed.swap(send_queue_);
+        for (auto& msg : failed) {
+            done += msg.bytes().size();
+            if (msg.callback)
+                msg.callback(err);
+        }
+        completed_messages_ += failed.size();
+    }
+    queued_bytes_ -= done;
+
+    while (!flush_waiters_.empty() && flush_waiters_.front().first <= completed_messages_) {
+        AsyncCallback callback = std::move(flush_waiters_.front().second);
+        flush_waiters_.pop_front();
+        callback(err);
+    }
+
+    if (!send_queue_.empty())
+        do_write();
+    else
+        writing_ = false;
 }
 
 // ====================== RECEIVE (SYNC) ======================
@@ -164,7 +348,8 @@ Error TcpClientAsio::recieve_sync(std::vector<uint8_t>& out) {
     asio::error_code ec;
     uint8_t buf[1024];
 
-    std::size_t n = socket_.read_some(asio::buffer(buf), ec);
+    std::size_t n =
+        with_stream([&](auto& stream) { return stream.read_some(asio::buffer(buf), ec); });
 
     if (ec) {
         Error err;
@@ -172,6 +357,7 @@ Error TcpClientAsio::recieve_sync(std::vector<uint8_t>& out) {
         return err;
     }
 
+    cfg_.socket_options.rearm_quickack(socket_.native_handle());
     out.assign(buf, buf + n);
     return Error{};
 }
@@ -180,30 +366,164 @@ Error TcpClientAsio::recieve_sync(std::vector<uint8_t>& out) {
 
 Error TcpClientAsio::recieve_async(ReceiveCallback callback) {
     auto self = shared_from_this();
-    auto buf = std::make_shared<std::vector<uint8_t>>(1024);
-
-    socket_.async_read_some(
-        asio::buffer(*buf),
-        asio::bind_executor(
-            strand_, [self, buf, callback](const asio::error_code& ec, std::size_t n) {
-                if (ec) {
-                    Error err;
-                    err.set_code(ErrorCode::RECEIVE_FAILED)->set_message("Async receive failed");
-                    callback(std::vector<uint8_t>{}, err);
-                    self->start_reconnect_loop();
-                } else {
-                    buf->resize(n);
-                    callback(*buf, Error{});
-                }
-            }));
+    auto buf = buffer_pool::acquire(kReadBufferSize);
+    auto target = asio::buffer(buf.vec());
+
+    // The handler owns the pooled buffer, it is recycled once the callback has returned
+    auto on_read = [self, tls = tls_stream_, buf = std::move(buf), callback = std::move(callback)](
+                       const asio::error_code& ec, std::size_t n) mutable {
+        if (ec) {
+            Error err;
+            err.set_code(ErrorCode::RECEIVE_FAILED)->set_message("Async receive failed");
+            callback(std::vector<uint8_t>{}, err);
+            self->start_reconnect_loop();
+        } else {
+            self->cfg_.socket_options.rearm_quickack(self->socket_.native_handle());
+            buf.resize(n);
+            callback(buf.vec(), Error{});
+        }
+    };
+    with_stream([&](auto& stream) {
+        stream.async_read_some(
+            target, asio::bind_executor(strand_, bind_arena(arena_, std::move(on_read))));
+    });
 
     return Error{};
 }
 
+// ====================== RECEIVE (STREAMING) ======================
+
+Error TcpClientAsio::start_receiving(ReceiveCallback callback, bool drain) {
+    auto self = shared_from_this();
+    asio::dispatch(strand_, [self, callback = std::move(callback), drain]() mutable {
+        self->stream_callback_ = std::move(callback);
+        self->stream_drain_ = drain;
+        if (self->stream_buffer_.vec().capacity() == 0)
+            self->stream_buffer_ = buffer_pool::acquire(kReadBufferSize);
+        self->streaming_ = true;
+        self->arm_stream_read();
+    });
+    return Error{};
+}
+
+void TcpClientAsio::stop_receiving() {
+    streaming_ = false;
+}
+
+void TcpClientAsio::arm_stream_read() {
+    // connect paths call this unconditionally; only one read is ever outstanding
+    if (!streaming_ || stream_armed_ || !is_connected_)
+        return;
+
+    stream_armed_ = true;
+    stream_buffer_.resize(kReadBufferSize);
+    auto on_read = [self = shared_from_this(), tls = tls_stream_](const asio::error_code& ec,
+                                                                  std::size_t n) {
+        self->on_stream_read(ec, n);
+    };
+    with_stream([&](auto& stream) {
+        stream.async_read_some(
+            asio::buffer(stream_buffer_.vec()),
+            asio::bind_executor(strand_, bind_arena(arena_, std::move(on_read))));
+    });
+}
+
+void TcpClientAsio::on_stream_read(const asio::error_code& ec, size_t bytes) {
+    stream_armed_ = false;
+    if (ec) {
+        // Stopped or disconnected: the aborted read is not an error worth reporting
+        if (!streaming_)
+            return;
+        Error err;
+        err.set_code(ErrorCode::RECEIVE_FAILED)->set_message("Async receive failed");
+        stream_callback_(std::vector<uint8_t>{}, err);
+        start_reconnect_loop();  // re-arms once connected again
+        return;
+    }
+
+    cfg_.socket_options.rearm_quickack(socket_.native_handle());
+    stream_buffer_.resize(bytes);
+    stream_callback_(stream_buffer_.vec(), Error{});
+
+    if (stream_drain_ && !drain_stream())
+        return;
+    arm_stream_read();
+}
+
+bool TcpClientAsio::drain_stream() {
+    while (streaming_ && is_connected_) {
+        stream_buffer_.resize(kReadBufferSize);
+        ssize_t n;
+        if (tls_stream_) {
+            // Only what OpenSSL already decrypted; more would need a (blocking) socket read
+            SSL* ssl = tls_stream_->native_handle();
+            if (SSL_pending(ssl) <= 0)
+                return true;
+            n = SSL_read(ssl, stream_buffer_.data(), static_cast<int>(stream_buffer_.size()));
+        } else {
+            // asio's own reads poll on EAGAIN for a blocking socket, so read natively
+            n = ::recv(socket_.native_handle(), stream_buffer_.data(), stream_buffer_.size(),
+                       MSG_DONTWAIT);
+        }
+        if (n <= 0)
+            return true;  // empty, or EOF/error the next async read reports
+
+        stream_buffer_.resize(n);
+        stream_callback_(stream_buffer_.vec(), Error{});
+    }
+    return streaming_;
+}
+
+// ====================== COROUTINES ======================
+
+asio::awaitable<Error> TcpClientAsio::send(std::span<const uint8_t> data) {
+    auto self = shared_from_this();
+    auto tls = tls_stream_;
+    asio::error_code ec;
+    co_await with_stream([&](auto& stream) {
+        return asio::async_write(stream, asio::buffer(data.data(), data.size()),
+                                 asio::redirect_error(asio::use_awaitable, ec));
+    });
+
+    if (ec) {
+        Error err;
+        err.set_code(ErrorCode::SEND_FAILED)->set_message("Send failed");
+        co_return err;
+    }
+    co_return Error{};
+}
+
+asio::awaitable<Error> TcpClientAsio::receive(std::vector<uint8_t>& out, size_t max_bytes) {
+    auto self = shared_from_this();
+    auto tls = tls_stream_;
+    asio::error_code ec;
+    out.resize(max_bytes);
+    std::size_t n = co_await with_stream([&](auto& stream) {
+        return stream.async_read_some(asio::buffer(out),
+                                      asio::redirect_error(asio::use_awaitable, ec));
+    });
+    out.resize(ec ? 0 : n);
+
+    if (ec) {
+        start_reconnect_loop();
+        Error err;
+        err.set_code(ErrorCode::RECEIVE_FAILED)->set_message("Receive failed");
+        co_return err;
+    }
+    cfg_.socket_options.rearm_quickack(socket_.native_handle());
+    co_return Error{};
+}
+
 // ====================== DISCONNECT ======================
 
 Error TcpClientAsio::disconnect() {
     reconnecting_ = false;
+    streaming_ = false;
+
+    // OpenSSL invalidates the session of a connection freed without a shutdown; mark it
+    // done (without waiting for the peer's close_notify) so the next connect can resume
+    if (tls_stream_)
+        SSL_set_shutdown(tls_stream_->native_handle(), SSL_SENT_SHUTDOWN | SSL_RECEIVED_SHUTDOWN);
 
     asio::error_code ec;
     socket_.close(ec);
@@ -2,14 +2,27 @@
 
 #include <asio.hpp>
 #include <atomic>
+#include <deque>
 #include <memory>
+#include <span>
 #include <vector>
 
+#include "buffer/buffer_pool.h"
+#include "buffer/handler_arena.h"
 #include "client/client_interface.h"
 #include "error.h"
+#include "tls/asio_tls.h"
 
+// With ssl_config.public_key set every connection, including reconnects, runs TLS: connect
+// completes after the handshake, and reconnects resume the previous session.
+//
+// send_async() messages join an ordered queue owned by the client: one write is in flight at
+// a time, and whatever queued up meanwhile leaves in the next gathered write. send_sync() and
+// the coroutine send() write directly; don't mix them with async sends still queued.
 class TcpClientAsio : public ClientInterface, public std::enable_shared_from_this<TcpClientAsio> {
   public:
+    static constexpr size_t kReadBufferSize = 1024;
+
     TcpClientAsio(const NetworkConfig& cfg, std::shared_ptr<asio::io_context> io);
 
     ~TcpClientAsio() override;
@@ -17,21 +30,128 @@ class TcpClientAsio : public ClientInterface, public std::enable_shared_from_thi
     Error connect() override;
     Error connect_async(AsyncCallback callback) override;
 
+    struct SendStats {
+        uint64_t messages = 0;  // send_async() messages written
+        uint64_t writes = 0;    // gathered writes that carried them
+    };
+
     Error send_sync(const std::vector<uint8_t>& data) override;
+
+    // Copies data into the queue; callback (may be empty) runs once it is written
     Error send_async(const std::vector<uint8_t>& data, AsyncCallback callback) override;
+    // Takes ownership of data instead of copying it
+    Error send_async(std::vector<uint8_t>&& data, AsyncCallback callback = nullptr);
+
+    // callback runs once every message queued before the call is written, or with
+    // SEND_FAILED when the connection failed first
+    void flush(AsyncCallback callback);
+
+    // Bytes accepted by send_async() and not yet written
+    size_t queued_bytes() const { return queued_bytes_; }
+
+    SendStats send_stats() const { return {sent_messages_, write_batches_}; }
 
     Error recieve_sync(std::vector<uint8_t>& out) override;
     Error recieve_async(ReceiveCallback callback) override;
 
+    // Streaming receive: one read stays outstanding on a reused buffer (the data passed to
+    // callback is only valid during the call) and is re-armed after every completion and
+    // after each reconnect, until stop_receiving() or disconnect(). A failed read reports the
+    // error and starts the reconnect loop. With drain, a completed read is followed by
+    // non-blocking reads until the socket is empty (under TLS: while OpenSSL still holds
+    // decrypted bytes), so a burst is handed over without a reactor round trip per read.
+    // Don't combine with recieve_async() or the coroutine receive().
+    Error start_receiving(ReceiveCallback callback, bool drain = false);
+
+    // No read is re-armed; one already in flight still completes into the callback
+    void stop_receiving();
+
     Error disconnect() override;
 
+    // Handshake counters; all zero without TLS
+    TlsContext::Stats tls_stats() const { return tls_ ? tls_->stats() : TlsContext::Stats{}; }
+
+    // ---- Coroutine API ----
+    // For coroutines spawned on executor(), which also runs the callback handlers. Nothing is
+    // allocated per operation, so a protocol can be written as a plain loop of awaits.
+
+    asio::strand<asio::io_context::executor_type> executor() const { return strand_; }
+
+    // Completes once all of data is written
+    asio::awaitable<Error> send(std::span<const uint8_t> data);
+
+    // Reads what is available, up to max_bytes, into out (resized to the bytes read).
+    // Like recieve_async, a failed read starts the reconnect loop.
+    asio::awaitable<Error> receive(std::vector<uint8_t>& out, size_t max_bytes = kReadBufferSize);
+
   private:
     void start_reconnect_loop();
 
+    // Marks the connected socket usable, after a TLS handshake when TLS is on
+    void finish_connect(AsyncCallback done);
+    Error start_tls_session();
+
+    // Fresh socket for ep, opened and tuned with cfg_.socket_options before connect
+    void reset_socket(const asio::ip::tcp::endpoint& ep);
+
+    // One send_async() message: moved in, or copied into a pooled buffer
+    struct PendingSend {
+        std::vector<uint8_t> owned;
+        buffer_pool::Buffer copy;
+        AsyncCallback callback;
+
+        const std::vector<uint8_t>& bytes() const { return owned.empty() ? copy.vec() : owned; }
+    };
+
+    // Streaming receive, strand only
+    void arm_stream_read();
+    void on_stream_read(const asio::error_code& ec, size_t bytes);
+    bool drain_stream();  // false once stopped
+
+    // Send queue, strand only
+    void enqueue(PendingSend msg);
+    void do_write();
+    void finish_write(const asio::error_code& ec);
+
+    // Runs f on the TLS stream when TLS is on, on the plain socket otherwise
+    template <typename F>
+    decltype(auto) with_stream(F&& f) {
+        if (tls_stream_)
+            return f(*tls_stream_);
+        return f(socket_);
+    }
+
   private:
     std::shared_ptr<asio::io_context> io_;
     asio::ip::tcp::socket socket_;
+
+    std::unique_ptr<TlsContext> tls_;  // null without TLS
+    std::unique_ptr<asio::ssl::context> ssl_context_;
+    Error tls_error_;  // context setup failure, reported by connect
+    // One per connection; handlers hold a reference until their operation completes
+    std::shared_ptr<AsioTlsStream> tls_stream_;
     asio::strand<asio::io_context::executor_type> strand_;
+    HandlerArena arena_;  // read and write handlers; they keep the client alive
 
     std::atomic<bool> reconnecting_{false};
+
+    // Streaming receive; the flag is cleared from any thread, the rest is strand only
+    std::atomic<bool> streaming_{false};
+    bool stream_drain_ = false;
+    bool stream_armed_ = false;
+    ReceiveCallback stream_callback_;
+    buffer_pool::Buffer stream_buffer_;
+
+    // Send queue, touched on strand_ only
+    std::deque<PendingSend> send_queue_;
+    std::vector<PendingSend> inflight_;
+    std::vector<asio::const_buffer> inflight_buffers_;
+    bool writing_ = false;
+    uint64_t enqueued_messages_ = 0;
+    uint64_t completed_messages_ = 0;  // written or failed
+    std::deque<std::pair<uint64_t, AsyncCallback>> flush_waiters_;  // (message count, callback)
+
+    std::atomic<size_t> queued_bytes_{0};
+    std::atomic<uint64_t> sent_messages_{0};
+    std::atomic<uint64_t> write_batches_{0};
 };
@@ -1,5 +1,24 @@
 #include "client/asio/udp_client.h"
 
+#include <cstring>
+
+#include "buffer/buffer_pool.h"
+#include "udp/offload.h"
+
+namespace {
+
+    // On a connected socket an ICMP port unreachable surfaces as ECONNREFUSED on the next call
+    Error udp_error(const asio::error_code& ec, ErrorCode code, const char* what) {
+        Error err;
+        if (ec == asio::error::connection_refused)
+            err.set_code(ErrorCode::SERVER_UNAVAILABLE)->set_message("UDP port unreachable");
+        else
+            err.set_code(code)->set_message(what);
+        return err;
+    }
+
+}  // namespace
+
 UdpClient::UdpClient(const NetworkConfig& cfg, std::shared_ptr<asio::io_context> io)
     : ClientInterface(cfg), io_(std::move(io)), socket_(*io_), server_endpoint_() {}
 
@@ -23,6 +42,7 @@ Error UdpClient::connect() {
         err.set_code(ErrorCode::CONNECTION_FAILED)->set_message("Failed to open UDP socket");
         return err;
     }
+    cfg_.socket_options.apply(socket_.native_handle());
 
     socket_.bind(asio::ip::udp::endpoint(asio::ip::udp::v4(), 0), ec);
     if (ec) {
@@ -31,7 +51,25 @@ Error UdpClient::connect() {
         return err;
     }
 
+    connected_ = false;
+    if (cfg_.udp_connected) {
+        socket_.connect(server_endpoint_, ec);
+        if (ec) {
+            Error err;
+            err.set_code(ErrorCode::CONNECTION_FAILED)->set_message("Failed to connect UDP socket");
+            return err;
+        }
+        connected_ = true;
+    }
+
+    if (cfg_.udp_offload) {
+        gro_ = udp_offload::enable_gro(socket_.native_handle());
+        gso_ = udp_offload::gso_supported(socket_.native_handle());
+    }
+
     is_connected_ = true;
+    if (streaming_)
+        asio::dispatch(*io_, [self = shared_from_this()]() { self->arm_stream_read(); });
     return Error{};
 }
 
@@ -46,6 +84,7 @@ Error UdpClient::connect_async(AsyncCallback callback) {
 // ====================== DISCONNECT ======================
 
 Error UdpClient::disconnect() {
+    streaming_ = false;
     asio::error_code ec;
     socket_.close(ec);
     is_connected_ = false;
@@ -57,40 +96,434 @@ Error UdpClient::disconnect() {
 Error UdpClient::send_async(const std::vector<uint8_t>& data, AsyncCallback callback) {
     auto self = shared_from_this();
 
-    socket_.async_send_to(
-        asio::buffer(data), server_endpoint_,
-        [self, callback](const asio::error_code& ec, std::size_t) {
-            if (ec) {
-                Error err;
-                err.set_code(ErrorCode::SEND_FAILED)->set_message("UDP async send failed");
-                callback(err);
-            } else {
-                callback(Error{});
-            }
-        });
+    if (gso_) {
+        bool start = false;
+        {
+            std::lock_guard<std::mutex> lock(send_mutex_);
+            send_queue_.push_back(PendingSend{data, std::move(callback)});
+            start = !sending_;
+            sending_ = true;
+        }
+        // Deferred so datagrams queued back to back can leave in one GSO send
+        if (start)
+            asio::post(*io_, bind_arena(arena_, [self]() { self->flush_sends(); }));
+        return Error{};
+    }
+
+    auto buf = buffer_pool::acquire(data.size());
+    std::copy(data.begin(), data.end(), buf.data());
+    auto payload = asio::buffer(buf.vec());
+
+    auto on_send = [self, buf = std::move(buf), callback = std::move(callback)](
+                       const asio::error_code& ec, std::size_t) {
+        if (ec) {
+            callback(udp_error(ec, ErrorCode::SEND_FAILED, "UDP async send failed"));
+        } else {
+            callback(Error{});
+        }
+    };
+    if (connected_)
+        socket_.async_send(payload, bind_arena(arena_, std::move(on_send)));
+    else
+        socket_.async_send_to(payload, server_endpoint_, bind_arena(arena_, std::move(on_send)));
 
     return Error{};
 }
 
+// ====================== SEND (BATCH) ======================
+
+Error UdpClient::send_batch(std::span<const std::vector<uint8_t>> datagrams, size_t* sent) {
+    Error err;
+    if (sent)
+        *sent = 0;
+    if (!socket_.is_open()) {
+        err.set_code(ErrorCode::NOT_CONNECTED)->set_message("UDP socket not open");
+        return err;
+    }
+
+    const int fd = socket_.native_handle();
+    const size_t slots = std::min(datagrams.size(), kMaxBatch);
+    std::vector<iovec> iov(slots);
+    std::vector<mmsghdr> msgs(slots);
+
+    size_t done = 0;
+    while (done < datagrams.size()) {
+        const size_t count = std::min(datagrams.size() - done, kMaxBatch);
+        for (size_t i = 0; i < count; ++i) {
+            const auto& data = datagrams[done + i];
+            iov[i] = {const_cast<uint8_t*>(data.data()), data.size()};
+            msgs[i] = {};
+            msgs[i].msg_hdr.msg_iov = &iov[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+            if (!connected_) {
+                msgs[i].msg_hdr.msg_name = server_endpoint_.data();
+                msgs[i].msg_hdr.msg_namelen = server_endpoint_.size();
+            }
+        }
+
+        // Never waits: called from a handler, it would stall the client's I/O thread
+        int n = sendmmsg(fd, msgs.data(), count, MSG_DONTWAIT);
+        if (n >= 0) {
+            done += n;
+            if (sent)
+                *sent = done;
+            continue;
+        }
+        if (errno == EINTR)
+            continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            err.set_code(ErrorCode::WOULD_BLOCK)->set_message("UDP send buffer full");
+            return err;
+        }
+        return udp_error(asio::error_code(errno, asio::error::get_system_category()),
+                         ErrorCode::SEND_FAILED, strerror(errno));
+    }
+    return err;
+}
+
 // ====================== RECEIVE (ASYNC) ======================
 
 Error UdpClient::recieve_async(ReceiveCallback callback) {
     auto self = shared_from_this();
-    auto buf = std::make_shared<std::vector<uint8_t>>(1024);
-    auto sender = std::make_shared<asio::ip::udp::endpoint>();
-
-    socket_.async_receive_from(
-        asio::buffer(*buf), *sender,
-        [self, buf, callback](const asio::error_code& ec, std::size_t bytes) {
-            if (ec) {
-                Error err;
-                err.set_code(ErrorCode::RECEIVE_FAILED)->set_message("UDP async receive failed");
-                callback({}, err);
-            } else {
-                buf->resize(bytes);
-                callback(*buf, Error{});
+
+    if (gro_) {
+        // The pending packet is io_context state; the callback never runs inside this call
+        asio::post(*io_, bind_arena(arena_, [self, callback = std::move(callback)]() mutable {
+                       self->receive_gro(std::move(callback));
+                   }));
+        return Error{};
+    }
+
+    // The handler owns its pooled buffer, which is recycled once the callback has returned
+    auto buf = buffer_pool::acquire(kBufferSize);
+    auto target = asio::buffer(buf.vec());
+
+    auto on_receive = [self, buf = std::move(buf), callback = std::move(callback)](
+                          const asio::error_code& ec, std::size_t bytes) mutable {
+        if (ec) {
+            callback({}, udp_error(ec, ErrorCode::RECEIVE_FAILED, "UDP async receive failed"));
+        } else {
+            buf.resize(bytes);
+            callback(buf.vec(), Error{});
+        }
+    };
+    // The sender is not reported, so a plain receive does without an endpoint per call
+    socket_.async_receive(target, bind_arena(arena_, std::move(on_receive)));
+
+    return Error{};
+}
+
+void UdpClient::receive_gro(ReceiveCallback callback) {
+    auto self = shared_from_this();
+    if (gro_offset_ < gro_length_) {
+        auto segment = buffer_pool::acquire(gro_segment_);
+        take_gro_segment(segment.vec());
+        callback(segment.vec(), Error{});
+        return;
+    }
+
+    // asio cannot hand out the GRO control message, so wait for readability and read the
+    // packet natively
+    auto on_ready = [self, callback = std::move(callback)](const asio::error_code& ec) mutable {
+        ssize_t n = ec ? -1 : self->read_gro_packet();
+        if (n < 0) {
+            if (!ec && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                self->receive_gro(std::move(callback));
+                return;
             }
-        });
+            Error err;
+            err.set_code(ErrorCode::RECEIVE_FAILED)->set_message("UDP async receive failed");
+            callback({}, err);
+            return;
+        }
+        self->receive_gro(std::move(callback));
+    };
+    socket_.async_wait(asio::socket_base::wait_read, bind_arena(arena_, std::move(on_ready)));
+}
+
+ssize_t UdpClient::read_gro_packet() {
+    if (gro_packet_.size() == 0)
+        gro_packet_ = buffer_pool::acquire(kOffloadBufferSize);
+    sockaddr_in from{};
+    int segment_size = 0;
+    ssize_t n = udp_offload::recv_gro(socket_.native_handle(), gro_packet_.data(),
+                                      gro_packet_.size(), &from, &segment_size, MSG_DONTWAIT);
+    if (n >= 0) {
+        gro_length_ = n;
+        gro_offset_ = 0;
+        gro_segment_ = segment_size > 0 ? segment_size : n;
+    }
+    return n;
+}
 
+void UdpClient::take_gro_segment(std::vector<uint8_t>& out) {
+    const size_t len = std::min(gro_segment_, gro_length_ - gro_offset_);
+    const uint8_t* segment = gro_packet_.data() + gro_offset_;
+    out.assign(segment, segment + len);
+    gro_offset_ += len;
+}
+
+// ====================== RECEIVE (STREAMING) ======================
+
+Error UdpClient::start_receiving(ReceiveCallback callback, bool drain) {
+    auto self = shared_from_this();
+    asio::dispatch(*io_, [self, callback = std::move(callback), drain]() mutable {
+        self->stream_callback_ = std::move(callback);
+        self->stream_drain_ = drain;
+        self->streaming_ = true;
+        self->arm_stream_read();
+    });
     return Error{};
 }
+
+void UdpClient::stop_receiving() {
+    streaming_ = false;
+}
+
+void UdpClient::arm_stream_read() {
+    if (!streaming_ || stream_armed_ || !is_connected_)
+        return;
+
+    // Sized on first use: GRO is only known once connected
+    const size_t size = gro_ ? kOffloadBufferSize : kBufferSize;
+    if (stream_buffer_.vec().capacity() < size)
+        stream_buffer_ = buffer_pool::acquire(size);
+    stream_buffer_.resize(size);
+    stream_armed_ = true;
+
+    auto self = shared_from_this();
+    if (gro_) {
+        socket_.async_wait(asio::socket_base::wait_read,
+                           bind_arena(arena_, [self](const asio::error_code& ec) {
+                               self->on_stream_ready(ec);
+                           }));
+        return;
+    }
+    socket_.async_receive(asio::buffer(stream_buffer_.vec()),
+                          bind_arena(arena_, [self](const asio::error_code& ec, std::size_t n) {
+                              self->on_stream_read(ec, n);
+                          }));
+}
+
+void UdpClient::on_stream_read(const asio::error_code& ec, size_t bytes) {
+    stream_armed_ = false;
+    if (ec) {
+        // Closed or stopped: nothing to report, and nothing to re-arm on
+        if (ec == asio::error::operation_aborted || !streaming_)
+            return;
+        stream_callback_({}, udp_error(ec, ErrorCode::RECEIVE_FAILED, "UDP async receive failed"));
+        arm_stream_read();
+        return;
+    }
+
+    stream_buffer_.resize(bytes);
+    stream_callback_(stream_buffer_.vec(), Error{});
+    while (stream_drain_ && streaming_) {
+        stream_buffer_.resize(kBufferSize);
+        ssize_t n = ::recv(socket_.native_handle(), stream_buffer_.data(), stream_buffer_.size(),
+                           MSG_DONTWAIT);
+        if (n < 0 && errno == ECONNREFUSED) {
+            // recv() consumed the pending ICMP error, report it here
+            stream_callback_({}, udp_error(asio::error::connection_refused,
+                                           ErrorCode::RECEIVE_FAILED, "UDP receive failed"));
+            continue;
+        }
+        if (n < 0)
+            break;  // empty (or an error the next async receive reports)
+        stream_buffer_.resize(n);
+        stream_callback_(stream_buffer_.vec(), Error{});
+    }
+    arm_stream_read();
+}
+
+void UdpClient::on_stream_ready(const asio::error_code& ec) {
+    stream_armed_ = false;
+    if (ec) {
+        if (ec == asio::error::operation_aborted || !streaming_)
+            return;
+        Error err;
+        err.set_code(ErrorCode::RECEIVE_FAILED)->set_message("UDP async receive failed");
+        stream_callback_({}, err);
+        arm_stream_read();
+        return;
+    }
+
+    // Without drain one packet per wakeup, as an async receive would take
+    do {
+        sockaddr_in from{};
+        int segment_size = 0;
+        ssize_t n = udp_offload::recv_gro(socket_.native_handle(), stream_buffer_.data(),
+                                          stream_buffer_.size(), &from, &segment_size,
+                                          MSG_DONTWAIT);
+        if (n < 0)
+            break;
+        udp_offload::for_each_segment(
+            stream_buffer_.data(), n, segment_size,
+            [&](const uint8_t* data, size_t len) { deliver_segment(data, len); });
+    } while (stream_drain_ && streaming_);
+    arm_stream_read();
+}
+
+void UdpClient::deliver_segment(const uint8_t* data, size_t len) {
+    if (stream_segment_.vec().capacity() < kOffloadBufferSize)
+        stream_segment_ = buffer_pool::acquire(kOffloadBufferSize);
+    stream_segment_.vec().assign(data, data + len);
+    stream_callback_(stream_segment_.vec(), Error{});
+}
+
+// ====================== COROUTINES ======================
+
+asio::awaitable<Error> UdpClient::send(std::span<const uint8_t> data) {
+    auto self = shared_from_this();
+    asio::error_code ec;
+    if (connected_)
+        co_await socket_.async_send(asio::buffer(data.data(), data.size()),
+                                    asio::redirect_error(asio::use_awaitable, ec));
+    else
+        co_await socket_.async_send_to(asio::buffer(data.data(), data.size()), server_endpoint_,
+                                       asio::redirect_error(asio::use_awaitable, ec));
+
+    if (ec)
+        co_return udp_error(ec, ErrorCode::SEND_FAILED, "UDP send failed");
+    co_return Error{};
+}
+
+asio::awaitable<Error> UdpClient::receive(std::vector<uint8_t>& out) {
+    auto self = shared_from_this();
+    auto failed = [&out]() {
+        out.clear();
+        Error err;
+        err.set_code(ErrorCode::RECEIVE_FAILED)->set_message("UDP receive failed");
+        return err;
+    };
+    asio::error_code ec;
+
+    if (!gro_) {
+        out.resize(kBufferSize);
+        std::size_t n = co_await socket_.async_receive(
+            asio::buffer(out), asio::redirect_error(asio::use_awaitable, ec));
+        if (ec)
+            co_return failed();
+        out.resize(n);
+        co_return Error{};
+    }
+
+    while (gro_offset_ >= gro_length_) {
+        co_await socket_.async_wait(asio::socket_base::wait_read,
+                                    asio::redirect_error(asio::use_awaitable, ec));
+        if (ec)
+            co_return failed();
+
+        ssize_t n = read_gro_packet();
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                continue;
+            co_return failed();
+        }
+        if (n == 0) {
+            out.clear();
+            co_return Error{};
+        }
+    }
+
+    take_gro_segment(out);
+    co_return Error{};
+}
+
+//------------------------------------------- PRIVATE //-------------------------------------------
+
+void UdpClient::flush_sends() {
+    {
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        size_t count = std::min(send_queue_.size(), udp_offload::kMaxSegments);
+        std::vector<iovec> iov(count);
+        for (size_t i = 0; i < count; ++i)
+            iov[i] = {send_queue_[i].data.data(), send_queue_[i].data.size()};
+
+        size_t n = udp_offload::gso_run_length(iov.data(), count);
+        for (size_t i = 0; i < n; ++i) {
+            gso_run_.push_back(std::move(send_queue_.front()));
+            send_queue_.pop_front();
+        }
+    }
+    send_gso_run();
+}
+
+void UdpClient::send_gso_run() {
+    const int fd = socket_.native_handle();
+
+    if (gso_run_.size() > 1 && gso_) {
+        std::vector<iovec> iov(gso_run_.size());
+        for (size_t i = 0; i < gso_run_.size(); ++i)
+            iov[i] = {gso_run_[i].data.data(), gso_run_[i].data.size()};
+
+        // A connected socket takes no destination
+        const sockaddr* to = connected_ ? nullptr : server_endpoint_.data();
+        const socklen_t to_len = connected_ ? 0 : server_endpoint_.size();
+        while (true) {
+            if (udp_offload::send_gso(fd, to, to_len, iov.data(), iov.size(), MSG_DONTWAIT) >= 0) {
+                finish_gso_run(Error{});
+                return;
+            }
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                // Send buffer full: retry the run once the socket is writable
+                auto on_writable = [self = shared_from_this()](const asio::error_code& ec) {
+                    if (ec)
+                        self->finish_gso_run(
+                            udp_error(ec, ErrorCode::SEND_FAILED, "UDP send failed"));
+                    else
+                        self->send_gso_run();
+                };
+                socket_.async_wait(asio::socket_base::wait_write,
+                                   bind_arena(arena_, std::move(on_writable)));
+                return;
+            }
+            break;
+        }
+
+        // No segmentation support on this route/device: stop trying, send one by one
+        if (errno == EIO || errno == EOPNOTSUPP || errno == ENOPROTOOPT)
+            gso_ = false;
+    }
+
+    send_run_from(0, Error{});
+}
+
+void UdpClient::send_run_from(size_t index, Error err) {
+    if (index == gso_run_.size()) {
+        finish_gso_run(err);
+        return;
+    }
+
+    auto on_send = [self = shared_from_this(), index, err](const asio::error_code& ec,
+                                                           std::size_t) mutable {
+        if (ec)
+            err = udp_error(ec, ErrorCode::SEND_FAILED, "UDP send failed");
+        self->send_run_from(index + 1, std::move(err));
+    };
+    auto payload = asio::buffer(gso_run_[index].data);
+    if (connected_)
+        socket_.async_send(payload, bind_arena(arena_, std::move(on_send)));
+    else
+        socket_.async_send_to(payload, server_endpoint_, bind_arena(arena_, std::move(on_send)));
+}
+
+void UdpClient::finish_gso_run(const Error& err) {
+    std::vector<PendingSend> run;
+    run.swap(gso_run_);
+    for (auto& pending : run) {
+        if (pending.callback)
+            pending.callback(err);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        if (send_queue_.empty()) {
+            sending_ = false;
+            return;
+        }
+    }
+    asio::post(*io_, [self = shared_from_this()]() { self->flush_sends(); });
+}
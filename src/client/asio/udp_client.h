@@ -1,9 +1,15 @@
 #pragma once
 
 #include <asio.hpp>
+#include <atomic>
+#include <deque>
 #include <memory>
+#include <mutex>
+#include <span>
 #include <vector>
 
+#include "buffer/buffer_pool.h"
+#include "buffer/handler_arena.h"
 #include "client/client_interface.h"
 #include "error.h"
 
@@ -17,13 +23,95 @@ class UdpClient : public ClientInterface, public std::enable_shared_from_this<Ud
 
     Error send_async(const std::vector<uint8_t>& data, AsyncCallback callback) override;
 
+    // Send the datagrams from the calling thread, up to kMaxBatch per sendmmsg() call, without
+    // blocking: a full send buffer returns WOULD_BLOCK and the rest is left to the caller.
+    // Stops at the first failed datagram. `sent`, if set, receives how many were handed to
+    // the kernel. Not ordered with send_async() datagrams in flight.
+    Error send_batch(std::span<const std::vector<uint8_t>> datagrams, size_t* sent = nullptr);
+
+    // One datagram per call. With GRO a coalesced packet is read once and handed out one
+    // datagram per call, shared with the coroutine receive().
     Error recieve_async(ReceiveCallback callback) override;
 
+    // Streaming receive: one read stays outstanding on a reused buffer (the data passed to
+    // callback is only valid during the call), re-armed after every datagram and after
+    // connect(), until stop_receiving() or disconnect(). With drain, each wakeup reads on
+    // without blocking until the socket is empty. Don't combine with recieve_async() or the
+    // coroutine receive().
+    Error start_receiving(ReceiveCallback callback, bool drain = false);
+
+    // No read is re-armed; one already in flight still completes into the callback
+    void stop_receiving();
+
     // We can keep send_sync / recieve_sync as NOT_IMPLEMENTED
     // from base class.
 
+    // ---- Coroutine API ----
+    // For coroutines spawned on the client's io_context, one receiving coroutine at a time.
+
+    // One datagram to the server. Sent on its own; GSO batching applies to send_async only.
+    asio::awaitable<Error> send(std::span<const uint8_t> data);
+
+    // Next datagram into out. With GRO a coalesced packet is read once and handed out one
+    // datagram per call.
+    asio::awaitable<Error> receive(std::vector<uint8_t>& out);
+
+  private:
+    struct PendingSend {
+        std::vector<uint8_t> data;
+        AsyncCallback callback;
+    };
+
+    // Streaming receive, on the io_context
+    void arm_stream_read();
+    void on_stream_read(const asio::error_code& ec, size_t bytes);
+    void on_stream_ready(const asio::error_code& ec);  // GRO: readable, read natively
+    void deliver_segment(const uint8_t* data, size_t len);  // one datagram of a GRO packet
+
+    // One-shot GRO receive, on the io_context: next datagram of gro_packet_, reading a new
+    // packet once it is used up
+    void receive_gro(ReceiveCallback callback);
+    ssize_t read_gro_packet();  // recv_gro() into gro_packet_, MSG_DONTWAIT
+    void take_gro_segment(std::vector<uint8_t>& out);
+
+    // Offload mode: send queued datagrams, equal-sized runs as a single GSO send. One run is
+    // in flight at a time; a full send buffer is waited out with async_wait, so the
+    // io_context thread never blocks.
+    void flush_sends();
+    void send_gso_run();
+    void send_run_from(size_t index, Error err);  // without GSO: one async send each
+    void finish_gso_run(const Error& err);
+
   private:
+    static constexpr size_t kBufferSize = 1024;
+    static constexpr size_t kOffloadBufferSize = 65536;
+    static constexpr size_t kMaxBatch = 1024;  // UIO_MAXIOV, the sendmmsg() limit
+
     std::shared_ptr<asio::io_context> io_;
     asio::ip::udp::socket socket_;
     asio::ip::udp::endpoint server_endpoint_;
+    HandlerArena arena_;  // completion handlers; they keep the client alive
+
+    bool gro_ = false;
+    bool connected_ = false;  // cfg.udp_connected: the socket is connected to the server
+    std::atomic<bool> gso_{false};  // cleared when a GSO send is refused
+
+    // GRO packet being handed out by receive()
+    buffer_pool::Buffer gro_packet_;
+    size_t gro_length_ = 0;
+    size_t gro_offset_ = 0;
+    size_t gro_segment_ = 0;
+
+    // Streaming receive; the flag is cleared from any thread, the rest runs on io_
+    std::atomic<bool> streaming_{false};
+    bool stream_drain_ = false;
+    bool stream_armed_ = false;
+    ReceiveCallback stream_callback_;
+    buffer_pool::Buffer stream_buffer_;   // datagram, or GRO packet
+    buffer_pool::Buffer stream_segment_;  // one datagram of a GRO packet
+
+    std::mutex send_mutex_;  // guards the offload send queue
+    std::deque<PendingSend> send_queue_;
+    bool sending_ = false;
+    std::vector<PendingSend> gso_run_;  // run being sent, touched by the flush chain only
 };
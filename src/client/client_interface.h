@@ -6,6 +6,8 @@
 #include <vector>
 
 #include "error.h"
+#include "socket/busy_poll.h"
+#include "socket/socket_options.h"
 
 enum class ClientType { TCP, UDP, Serial };
 
@@ -13,11 +15,15 @@ struct NetworkConfig {
     std::string ip;
     int port;
 
+    // TLS is used when public_key is set. Key material is PEM text or a path to a PEM file.
     struct SSLConfig {
-        std::string public_key;
-    } ssl_config = {};  // By default, do not use SSL (empty config)
+        std::string public_key;   // certificate (or CA) the server must present
+        std::string server_name;  // SNI and name checked against the certificate, ip if empty
+        bool verify_peer = true;
+        bool ktls = true;  // let the kernel encrypt records when it supports kTLS
+    } ssl_config = {};     // By default, do not use SSL (empty config)
 
-    enum class BackendType { ASIO, POSIX };
+    enum class BackendType { ASIO, POSIX, IO_URING };
     BackendType backend_type = BackendType::ASIO;
 
     ClientType connection_type = ClientType::TCP;
@@ -28,6 +34,22 @@ struct NetworkConfig {
     } auto_connect = {};
 
     bool keep_alive = true;
+
+    // Socket tuning applied by every backend, e.g. SocketOptions::low_latency()
+    SocketOptions socket_options = {};
+
+    // POSIX clients only: with busy_poll.enabled a client created without a reactor gets a
+    // dedicated spinning ClientReactor thread instead of the shared blocking ones
+    BusyPollOptions busy_poll = {};
+
+    // UDP only: send queued datagrams with UDP_SEGMENT and receive with UDP_GRO when the
+    // kernel supports them (silently ignored otherwise)
+    bool udp_offload = false;
+
+    // UDP only: connect() the socket to the server. Datagrams then go out with plain send()
+    // without a route lookup each, only the server's datagrams are received, and an ICMP
+    // port unreachable fails the next send or receive with SERVER_UNAVAILABLE.
+    bool udp_connected = false;
 };
 
 class ClientInterface {
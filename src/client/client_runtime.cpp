@@ -0,0 +1,60 @@
+#include "client/client_runtime.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+
+ClientRuntime::ClientRuntime(ClientRuntimeOptions options) : options_(std::move(options)) {
+    const unsigned threads = options_.io_threads
+                                 ? options_.io_threads
+                                 : std::max(1u, std::thread::hardware_concurrency());
+
+    for (unsigned i = 0; i < threads; ++i) {
+        contexts_.push_back(std::make_shared<asio::io_context>(1));
+        work_.push_back(asio::make_work_guard(*contexts_.back()));
+    }
+
+    for (unsigned i = 0; i < threads; ++i) {
+        asio::io_context* io = contexts_[i].get();
+        io_threads_.emplace_back([io]() { io->run(); });
+
+        if (!options_.cpus.empty()) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(options_.cpus[i % options_.cpus.size()], &set);
+            pthread_setaffinity_np(io_threads_.back().native_handle(), sizeof(set), &set);
+        }
+    }
+
+    reactor_ = options_.reactor_threads ? std::make_shared<ClientReactor>(options_.reactor_threads)
+                                        : ClientReactor::shared();
+}
+
+ClientRuntime::~ClientRuntime() {
+    shutdown();
+}
+
+std::shared_ptr<ClientRuntime> ClientRuntime::shared() {
+    static std::shared_ptr<ClientRuntime> runtime = std::make_shared<ClientRuntime>();
+    return runtime;
+}
+
+std::shared_ptr<asio::io_context> ClientRuntime::next_context() {
+    return contexts_[next_context_++ % contexts_.size()];
+}
+
+std::shared_ptr<ClientReactor> ClientRuntime::reactor() const {
+    return reactor_;
+}
+
+void ClientRuntime::shutdown() {
+    std::lock_guard<std::mutex> lock(shutdown_mutex_);
+    work_.clear();
+    for (auto& io : contexts_) io->stop();
+    for (auto& t : io_threads_) {
+        if (t.joinable())
+            t.join();
+    }
+    io_threads_.clear();
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <asio.hpp>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "client/posix/client_reactor.h"
+
+struct ClientRuntimeOptions {
+    // I/O threads for the asio clients, each running its own io_context; 0 uses one per core
+    unsigned io_threads = 1;
+
+    // Pin I/O thread i to cpus[i % cpus.size()]; empty leaves the threads unpinned
+    std::vector<int> cpus;
+
+    // epoll threads of a reactor owned by the runtime for the POSIX clients; 0 shares
+    // ClientReactor::shared()
+    unsigned reactor_threads = 0;
+};
+
+// Threads the clients of a ClientFactory run on.
+//
+// Every I/O thread runs its own io_context, and each asio client is handed one of them
+// round-robin and stays on it for its lifetime: its handlers never cross threads, and
+// 1000 connections spread evenly over the threads instead of sharing one core. Clients hold
+// their io_context, not the runtime; disconnect them before shutdown(), after which their
+// handlers no longer run.
+class ClientRuntime {
+  public:
+    explicit ClientRuntime(ClientRuntimeOptions options = {});
+    ~ClientRuntime();  // shutdown()
+
+    ClientRuntime(const ClientRuntime&) = delete;
+    ClientRuntime& operator=(const ClientRuntime&) = delete;
+
+    // Used by ClientFactory::create(cfg): one I/O thread, joined at exit
+    static std::shared_ptr<ClientRuntime> shared();
+
+    // io_context for a new connection, round-robin over the threads
+    std::shared_ptr<asio::io_context> next_context();
+
+    // Reactor for a new POSIX client
+    std::shared_ptr<ClientReactor> reactor() const;
+
+    unsigned io_threads() const { return static_cast<unsigned>(contexts_.size()); }
+
+    // Stop the io_contexts and join the threads. Handlers still queued are dropped.
+    // Idempotent; also run by the destructor.
+    void shutdown();
+
+  private:
+    using WorkGuard = asio::executor_work_guard<asio::io_context::executor_type>;
+
+    ClientRuntimeOptions options_;
+    std::vector<std::shared_ptr<asio::io_context>> contexts_;  // one per thread
+    std::vector<WorkGuard> work_;
+    std::vector<std::thread> io_threads_;
+    std::atomic<unsigned> next_context_{0};
+    std::shared_ptr<ClientReactor> reactor_;
+
+    std::mutex shutdown_mutex_;
+};
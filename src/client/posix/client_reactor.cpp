@@ -0,0 +1,175 @@
+#include "client/posix/client_reactor.h"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+ClientReactor::ClientReactor(unsigned threads, BusyPollOptions busy_poll)
+    : busy_poll_(busy_poll) {
+    for (unsigned i = 0; i < std::max(1u, threads); ++i) {
+        auto loop = std::make_unique<Loop>();
+        loop->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        loop->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = loop->wake_fd;
+        epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, loop->wake_fd, &ev);
+        loops_.push_back(std::move(loop));
+    }
+    for (auto& loop : loops_) {
+        Loop* l = loop.get();
+        l->worker = std::thread([this, l]() { run(*l); });
+        if (busy_poll_.enabled)
+            busy_poll_.pin(l->worker, static_cast<int>(&loop - &loops_.front()));
+    }
+}
+
+ClientReactor::~ClientReactor() {
+    stop_ = true;
+    for (auto& loop : loops_) {
+        uint64_t one = 1;
+        [[maybe_unused]] ssize_t n = write(loop->wake_fd, &one, sizeof(one));
+    }
+    for (auto& loop : loops_) {
+        if (loop->worker.joinable())
+            loop->worker.join();
+        close(loop->wake_fd);
+        close(loop->epoll_fd);
+    }
+}
+
+std::shared_ptr<ClientReactor> ClientReactor::shared() {
+    static std::shared_ptr<ClientReactor> reactor = std::make_shared<ClientReactor>(
+        std::min(4u, std::max(1u, std::thread::hardware_concurrency())));
+    return reactor;
+}
+
+std::shared_ptr<ClientReactor> ClientReactor::for_config(const NetworkConfig& cfg) {
+    if (!cfg.busy_poll.enabled)
+        return shared();
+    return std::make_shared<ClientReactor>(1, cfg.busy_poll);
+}
+
+Error ClientReactor::add(int fd, uint32_t events, Handler handler) {
+    Loop& loop = *loops_[next_loop_++ % loops_.size()];
+    {
+        std::lock_guard<std::mutex> lock(owners_mutex_);
+        if (!owners_.emplace(fd, &loop).second) {
+            Error err;
+            err.set_code(ErrorCode::ALREADY_CONNECTED)->set_message("fd already registered");
+            return err;
+        }
+    }
+
+    auto registration = std::make_shared<Registration>();
+    registration->handler = std::move(handler);
+    {
+        std::lock_guard<std::mutex> lock(loop.mutex);
+        loop.handlers[fd] = std::move(registration);
+    }
+
+    epoll_event ev{};
+    ev.events = events;
+    ev.data.fd = fd;
+    if (epoll_ctl(loop.epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        Error err;
+        err.set_code(ErrorCode::INTERNAL_ERROR)->set_message(strerror(errno));
+        remove(fd);
+        return err;
+    }
+    return Error();
+}
+
+Error ClientReactor::modify(int fd, uint32_t events) {
+    Loop* loop = find_loop(fd);
+    epoll_event ev{};
+    ev.events = events;
+    ev.data.fd = fd;
+    if (!loop || epoll_ctl(loop->epoll_fd, EPOLL_CTL_MOD, fd, &ev) < 0) {
+        Error err;
+        err.set_code(ErrorCode::INTERNAL_ERROR)->set_message("fd not registered");
+        return err;
+    }
+    return Error();
+}
+
+void ClientReactor::remove(int fd) {
+    Loop* loop = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(owners_mutex_);
+        auto it = owners_.find(fd);
+        if (it == owners_.end())
+            return;
+        loop = it->second;
+        owners_.erase(it);
+    }
+
+    epoll_ctl(loop->epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+    std::shared_ptr<Registration> registration;
+    {
+        std::lock_guard<std::mutex> lock(loop->mutex);
+        auto it = loop->handlers.find(fd);
+        if (it == loop->handlers.end())
+            return;
+        registration = std::move(it->second);
+        loop->handlers.erase(it);
+    }
+
+    // On the loop's own thread no handler of it can be running elsewhere (and the caller
+    // may be inside this very handler); from any other thread wait for a running call
+    if (std::this_thread::get_id() == loop->worker.get_id()) {
+        registration->active = false;
+    } else {
+        std::lock_guard<std::mutex> lock(registration->call_mutex);
+        registration->active = false;
+    }
+}
+
+ClientReactor::Loop* ClientReactor::find_loop(int fd) {
+    std::lock_guard<std::mutex> lock(owners_mutex_);
+    auto it = owners_.find(fd);
+    return it == owners_.end() ? nullptr : it->second;
+}
+
+void ClientReactor::run(Loop& loop) {
+    constexpr int kMaxEvents = 64;
+    epoll_event events[kMaxEvents];
+    BusySpinner spinner(busy_poll_);
+
+    while (!stop_) {
+        int n = epoll_wait(loop.epoll_fd, events, kMaxEvents, spinner.timeout_ms(-1));
+        spinner.update(n > 0);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+
+        for (int i = 0; i < n && !stop_; ++i) {
+            const int fd = events[i].data.fd;
+            if (fd == loop.wake_fd) {
+                uint64_t value;
+                [[maybe_unused]] ssize_t r = read(loop.wake_fd, &value, sizeof(value));
+                continue;
+            }
+
+            std::shared_ptr<Registration> registration;
+            {
+                std::lock_guard<std::mutex> lock(loop.mutex);
+                auto it = loop.handlers.find(fd);
+                if (it == loop.handlers.end())
+                    continue;  // removed by an earlier handler of this batch
+                registration = it->second;
+            }
+
+            std::lock_guard<std::mutex> lock(registration->call_mutex);
+            if (registration->active)
+                registration->handler(events[i].events);
+        }
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "client/client_interface.h"
+#include "error.h"
+#include "socket/busy_poll.h"
+
+// epoll event loop shared by the POSIX clients.
+//
+// A fixed set of threads, each with its own epoll instance, multiplexes every registered
+// descriptor; a descriptor is served by one thread for as long as it is registered, so its
+// handler never runs concurrently with itself. Readiness is level-triggered and handlers
+// run on the reactor thread as soon as epoll reports the descriptor. With busy_poll.enabled
+// the threads spin on epoll_wait() instead of sleeping in it.
+class ClientReactor {
+  public:
+    // Called with the epoll event mask (EPOLLIN, EPOLLOUT, EPOLLERR, ...)
+    using Handler = std::function<void(uint32_t events)>;
+
+    explicit ClientReactor(unsigned threads, BusyPollOptions busy_poll = {});
+    ~ClientReactor();  // stops and joins the threads
+
+    ClientReactor(const ClientReactor&) = delete;
+    ClientReactor& operator=(const ClientReactor&) = delete;
+
+    // Process-wide reactor of the POSIX clients (up to 4 threads), created on first use
+    static std::shared_ptr<ClientReactor> shared();
+
+    // shared(), or a new single spinning thread when cfg.busy_poll is enabled
+    static std::shared_ptr<ClientReactor> for_config(const NetworkConfig& cfg);
+
+    Error add(int fd, uint32_t events, Handler handler);
+    Error modify(int fd, uint32_t events);
+
+    // Once remove() returns the handler is not running and will not run again. Safe to call
+    // from the fd's own handler.
+    void remove(int fd);
+
+    unsigned threads() const { return static_cast<unsigned>(loops_.size()); }
+    const BusyPollOptions& busy_poll() const { return busy_poll_; }
+
+  private:
+    struct Registration {
+        Handler handler;
+        std::mutex call_mutex;  // held while the handler runs
+        bool active = true;
+    };
+
+    struct Loop {
+        int epoll_fd = -1;
+        int wake_fd = -1;
+        std::thread worker;
+        std::mutex mutex;  // guards handlers
+        std::unordered_map<int, std::shared_ptr<Registration>> handlers;
+    };
+
+    void run(Loop& loop);
+    Loop* find_loop(int fd);
+
+  private:
+    BusyPollOptions busy_poll_;
+    std::vector<std::unique_ptr<Loop>> loops_;
+    std::atomic<unsigned> next_loop_{0};
+    std::atomic<bool> stop_{false};
+
+    std::mutex owners_mutex_;
+    std::unordered_map<int, Loop*> owners_;  // fd -> loop serving it
+};
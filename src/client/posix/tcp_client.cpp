@@ -1,18 +1,41 @@
 #include "tcp_client.h"
 
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+
 #include <iostream>
 
 #include "client/client_interface.h"
 #include "error.h"
 
-TcpClientPosix::TcpClientPosix(const NetworkConfig& cfg)
+namespace {
+
+    constexpr uint32_t kReadEvents = EPOLLIN | EPOLLRDHUP;
+    constexpr int kMaxReadsPerEvent = 16;  // then let the other sockets of the loop run
+
+    bool make_address(const std::string& ip, int port, sockaddr_in& addr) {
+        addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        return inet_pton(AF_INET, ip.c_str(), &addr.sin_addr) > 0;
+    }
+
+}  // namespace
+
+TcpClientPosix::TcpClientPosix(const NetworkConfig& cfg,
+                               std::shared_ptr<ClientReactor> shared_reactor)
     : ClientInterface(cfg),
       serverIP(cfg.ip),
       serverPort(cfg.port),
       sock(-1),
       running(false),
       reconnectDelayMs(cfg.auto_connect.retry_time_ms),
-      delimiter() {}
+      delimiter(),
+      reactor(shared_reactor ? std::move(shared_reactor) : ClientReactor::for_config(cfg)) {}
+
+TcpClientPosix::~TcpClientPosix() {
+    disconnect();
+}
 
 Error TcpClientPosix::connect() {
     bool result = internal_connect(true);
@@ -23,12 +46,14 @@ Error TcpClientPosix::connect() {
     return err;
 }
 
-Error TcpClientPosix::connect_async(std::function<void(Error)>  callback [[maybe_unused]]) {
+Error TcpClientPosix::connect_async(std::function<void(Error)> callback) {
     bool result = internal_connect(false);
     Error err;
     if (!result) {
         err.set_code(ErrorCode::CONNECTION_FAILED);
     }
+    if (callback)
+        callback(err);
     return err;
 }
 
@@ -65,6 +90,7 @@ Error TcpClientPosix::recieve_sync(std::vector<uint8_t>& out) {
         std::cerr << "Read failed or connection closed\n";
         return err;
     }
+    cfg_.socket_options.rearm_quickack(sock);
     out.assign(reinterpret_cast<uint8_t*>(buf), reinterpret_cast<uint8_t*>(buf) + bytes);
     return err;
 }
@@ -72,91 +98,103 @@ Error TcpClientPosix::recieve_sync(std::vector<uint8_t>& out) {
 Error TcpClientPosix::recieve_async(
     std::function<void(const std::vector<uint8_t>&, Error)> callback) {
     Error err;
+    std::lock_guard<std::mutex> lock(sockMutex);
     if (running)
         return err;
-    running = true;
-
-    recvThread = std::thread([this, callback, err]() {
-        while (running) {
-            if (sock < 0 && !internal_connect(false)) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(reconnectDelayMs));
-                continue;
-            }
-
-            char buffer[1024];
-            int bytes = read(sock, buffer, sizeof(buffer));
 
-            if (bytes > 0) {
-                std::vector<uint8_t> data(buffer, buffer + bytes);
-
-                if (callback)
-                    callback(data, err);
-            } else if (bytes == 0) {
-                reconnect();
-            } else {
-                if (errno != EAGAIN && errno != EWOULDBLOCK)
-                    reconnect();
-                std::this_thread::sleep_for(std::chrono::milliseconds(30));
-            }
-        }
+    timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timerFd < 0) {
+        err.set_code(ErrorCode::INTERNAL_ERROR)->set_message("timerfd_create failed");
+        return err;
+    }
+    err = reactor->add(timerFd, EPOLLIN, [this, timer = timerFd](uint32_t) {
+        uint64_t expirations;
+        if (read(timer, &expirations, sizeof(expirations)) > 0)
+            start_reconnect();
     });
+    if (err.code() != ErrorCode::NO_ERROR) {
+        close(timerFd);
+        timerFd = -1;
+        return err;
+    }
 
+    recvCallback = std::move(callback);
+    running = true;
+    bool watching = false;
+    if (sock >= 0) {
+        std::lock_guard<std::mutex> send_lock(sendMutex);
+        watching = update_watch_locked();
+    }
+    if (!watching)
+        arm_reconnect_locked(0);
     return err;
 }
 
 Error TcpClientPosix::disconnect() {
     Error err;
     stop();
-    std::lock_guard<std::mutex> lock(sockMutex);
-    if (sock >= 0) {
-        close(sock);
-        sock = -1;
-    }
+    release_socket();
     return err;
 }
 
 //------------------------------------------- PRIVATE //-------------------------------------------
 bool TcpClientPosix::sendMessage(const std::vector<uint8_t>& data) {
-    std::lock_guard<std::mutex> lock(sockMutex);
+    std::lock_guard<std::mutex> lock(sendMutex);
     if (sock < 0)
         return false;
+    if (!sendQueue.empty() && queuedBytes + data.size() > kMaxQueuedBytes)
+        return false;  // refused whole, so the stream never carries a partial message
+
+    // Straight to the socket when nothing is queued ahead (and the connect has completed)
+    size_t sent = 0;
+    if (sendQueue.empty() && !connecting) {
+        while (sent < data.size()) {
+            ssize_t n = ::send(sock, data.data() + sent, data.size() - sent,
+                               MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (n >= 0) {
+                sent += n;
+                continue;
+            }
+            if (errno == EINTR)
+                continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                return false;
+            break;
+        }
+    }
+    if (sent == data.size())
+        return true;
 
-    return ::send(sock, data.data(), data.size(), 0) >= 0;
+    // The reactor writes the rest once the socket is writable
+    sendQueue.emplace_back(data.begin() + sent, data.end());
+    queuedBytes += data.size() - sent;
+    return update_watch_locked();
 }
 
 bool TcpClientPosix::internal_connect(bool isBlocking) {
+    release_socket();
     std::lock_guard<std::mutex> lock(sockMutex);
 
-    if (sock >= 0)
-        close(sock);
-    sock = socket(AF_INET, SOCK_STREAM, 0);
+    sock = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
     if (sock < 0)
         return false;
 
     sockaddr_in addr{};
-    addr.sin_family = AF_INET;
-    addr.sin_port = htons(serverPort);
-
-    if (inet_pton(AF_INET, serverIP.c_str(), &addr.sin_addr) <= 0)
+    if (!make_address(serverIP, serverPort, addr)) {
+        close(sock);
+        sock = -1;
         return false;
+    }
 
+    cfg_.socket_options.apply(sock);
+    cfg_.busy_poll.apply(sock);
     if (::connect(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
         close(sock);
         sock = -1;
         return false;
     }
 
-    // --- KEEP ALIVE IMPLEMENTATION ---
-    if (cfg_.keep_alive && sock >= 0) {
-        int optval = 1;
-        setsockopt(sock, SOL_SOCKET, SO_KEEPALIVE, &optval, sizeof(optval));
-
-        int idle = 30, interval = 10, count = 3;  // default values
-        setsockopt(sock, IPPROTO_TCP, TCP_KEEPIDLE, &idle, sizeof(idle));
-        setsockopt(sock, IPPROTO_TCP, TCP_KEEPINTVL, &interval, sizeof(interval));
-        setsockopt(sock, IPPROTO_TCP, TCP_KEEPCNT, &count, sizeof(count));
-    }
-    // --- END KEEP ALIVE ---
+    set_keep_alive_options();
 
     int flags = fcntl(sock, F_GETFL, 0);
     if (!isBlocking)
@@ -164,14 +202,28 @@ bool TcpClientPosix::internal_connect(bool isBlocking) {
     else
         fcntl(sock, F_SETFL, flags & ~O_NONBLOCK);
 
+    is_connected_ = true;
+    {
+        std::lock_guard<std::mutex> send_lock(sendMutex);
+        update_watch_locked();
+    }
+
     std::cout << "Connected to server ✅" << std::endl;
     return true;
 }
 
 void TcpClientPosix::stop() {
-    running = false;
-    if (recvThread.joinable())
-        recvThread.join();
+    int timer = -1;
+    {
+        std::lock_guard<std::mutex> lock(sockMutex);
+        running = false;
+        std::swap(timer, timerFd);
+    }
+    // Not under sockMutex: remove() waits for a running handler, which may need the lock
+    if (timer >= 0) {
+        reactor->remove(timer);
+        close(timer);
+    }
 }
 
 void TcpClientPosix::set_keep_alive_options(int idle, int interval, int count) {
@@ -187,4 +239,230 @@ void TcpClientPosix::set_keep_alive_options(int idle, int interval, int count) {
     setsockopt(sock, IPPROTO_TCP, TCP_KEEPIDLE, &idle, sizeof(idle));
     setsockopt(sock, IPPROTO_TCP, TCP_KEEPINTVL, &interval, sizeof(interval));
     setsockopt(sock, IPPROTO_TCP, TCP_KEEPCNT, &count, sizeof(count));
-}
\ No newline at end of file
+}
+
+bool TcpClientPosix::watch_socket(int fd, uint32_t events) {
+    Error err = reactor->add(fd, events, [this, fd](uint32_t ev) { on_socket_event(fd, ev); });
+    return err.code() == ErrorCode::NO_ERROR;
+}
+
+bool TcpClientPosix::update_watch_locked() {
+    uint32_t events = EPOLLOUT;  // a non-blocking connect reports completion as writable
+    if (!connecting) {
+        events = running ? kReadEvents : 0;
+        if (!sendQueue.empty())
+            events |= EPOLLOUT;
+    }
+    if (events == watchedEvents || sock < 0)
+        return true;
+
+    const int fd = sock;
+    if (events == 0) {
+        // Only the queue of a client that doesn't receive draining gets here, from the
+        // socket's own handler, where remove() does not wait
+        reactor->remove(fd);
+    } else if (watchedEvents == 0) {
+        if (!watch_socket(fd, events))
+            return false;
+    } else if (reactor->modify(fd, events).code() != ErrorCode::NO_ERROR) {
+        return false;
+    }
+    watchedEvents = events;
+    return true;
+}
+
+bool TcpClientPosix::write_queue_locked() {
+    while (!sendQueue.empty()) {
+        const std::vector<uint8_t>& chunk = sendQueue.front();
+        // With tcp_cork a partial segment waits for the message queued behind it
+        const int more = cfg_.socket_options.more_flag(sendQueue.size() > 1);
+        ssize_t n = ::send(sock, chunk.data() + sendOffset, chunk.size() - sendOffset,
+                           MSG_NOSIGNAL | MSG_DONTWAIT | more);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        sendOffset += n;
+        queuedBytes -= n;
+        if (sendOffset == chunk.size()) {
+            sendQueue.pop_front();
+            sendOffset = 0;
+        }
+    }
+    return true;
+}
+
+void TcpClientPosix::release_socket() {
+    int fd = -1;
+    {
+        std::lock_guard<std::mutex> lock(sockMutex);
+        {
+            std::lock_guard<std::mutex> send_lock(sendMutex);
+            fd = sock.exchange(-1);
+            sendQueue.clear();
+            sendOffset = 0;
+            queuedBytes = 0;
+            watchedEvents = 0;
+        }
+        connecting = false;
+        is_connected_ = false;
+    }
+    if (fd >= 0) {
+        reactor->remove(fd);  // before close(), the number may be reused right away
+        close(fd);
+    }
+}
+
+void TcpClientPosix::on_socket_event(int fd, uint32_t events) {
+    // Runs on the reactor thread; sock only changes to another fd after remove(fd), which
+    // waits for this handler, so no lock is needed to read it here
+    if (sock != fd)
+        return;
+    if (connecting) {
+        on_connected(fd);
+        return;
+    }
+
+    if (events & EPOLLOUT) {
+        on_writable(fd);
+        if (sock != fd)
+            return;
+    }
+    if (!(events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)))
+        return;
+    if (running)
+        on_readable(fd);
+    else
+        on_connection_lost(fd);  // only flushing: nobody reads, stop the hangup reports
+}
+
+void TcpClientPosix::on_writable(int fd) {
+    bool ok = true;
+    {
+        std::lock_guard<std::mutex> lock(sendMutex);
+        if (sock != fd)
+            return;
+        ok = write_queue_locked();
+        if (ok)
+            update_watch_locked();  // stop watching writability once drained
+    }
+    if (!ok)
+        on_connection_lost(fd);
+}
+
+void TcpClientPosix::on_readable(int fd) {
+    uint8_t buffer[16 * 1024];
+    char control[LatencyHistogram::kControlSize];
+    iovec iov{buffer, sizeof(buffer)};
+    for (int i = 0; i < kMaxReadsPerEvent; ++i) {
+        msghdr msg{};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        ssize_t bytes = ::recvmsg(fd, &msg, MSG_DONTWAIT);
+        if (bytes > 0) {
+            if (cfg_.busy_poll.measure_latency)
+                latency.record_since_rx(msg);
+            cfg_.socket_options.rearm_quickack(fd);
+            if (recvCallback)
+                recvCallback(std::vector<uint8_t>(buffer, buffer + bytes), Error());
+            if (static_cast<size_t>(bytes) < sizeof(buffer) || sock != fd)
+                return;  // drained (or the callback reconnected / disconnected)
+            continue;
+        }
+        if (bytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+            return;
+        on_connection_lost(fd);
+        return;
+    }
+}
+
+void TcpClientPosix::on_connected(int fd) {
+    int so_error = 0;
+    socklen_t len = sizeof(so_error);
+    if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &so_error, &len) < 0 || so_error != 0) {
+        release_socket();
+        schedule_reconnect(reconnectDelayMs);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(sockMutex);
+        if (sock != fd)
+            return;
+        set_keep_alive_options();
+        connecting = false;
+        is_connected_ = true;
+
+        // Reads, and sends queued while connecting
+        std::lock_guard<std::mutex> send_lock(sendMutex);
+        update_watch_locked();
+    }
+}
+
+void TcpClientPosix::on_connection_lost(int fd) {
+    if (sock != fd)
+        return;
+    release_socket();
+    if (!running)
+        return;
+
+    if (recvCallback) {
+        Error err;
+        err.set_code(ErrorCode::RECEIVE_FAILED)->set_message("Connection lost");
+        recvCallback({}, err);
+    }
+    schedule_reconnect(reconnectDelayMs);
+}
+
+void TcpClientPosix::schedule_reconnect(int delay_ms) {
+    std::lock_guard<std::mutex> lock(sockMutex);
+    arm_reconnect_locked(delay_ms);
+}
+
+void TcpClientPosix::arm_reconnect_locked(int delay_ms) {
+    if (timerFd < 0 || !running)
+        return;
+    itimerspec spec{};
+    spec.it_value.tv_sec = delay_ms / 1000;
+    spec.it_value.tv_nsec = (delay_ms % 1000) * 1000000L;
+    if (delay_ms <= 0)
+        spec.it_value.tv_nsec = 1;  // an all-zero value would disarm the timer
+    timerfd_settime(timerFd, 0, &spec, nullptr);
+}
+
+void TcpClientPosix::start_reconnect() {
+    sockaddr_in addr{};
+    if (!make_address(serverIP, serverPort, addr))
+        return;
+
+    std::lock_guard<std::mutex> lock(sockMutex);
+    if (!running || sock >= 0)
+        return;
+
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        arm_reconnect_locked(reconnectDelayMs);
+        return;
+    }
+    cfg_.socket_options.apply(fd);
+    cfg_.busy_poll.apply(fd);
+    if (::connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 && errno != EINPROGRESS) {
+        close(fd);
+        arm_reconnect_locked(reconnectDelayMs);
+        return;
+    }
+
+    // Completion (or failure) of the connect is reported as EPOLLOUT
+    std::lock_guard<std::mutex> send_lock(sendMutex);
+    sock = fd;
+    connecting = true;
+    if (!update_watch_locked()) {
+        close(fd);
+        sock = -1;
+        connecting = false;
+        arm_reconnect_locked(reconnectDelayMs);
+    }
+}
@@ -7,17 +7,32 @@
 #include <unistd.h>
 
 #include <atomic>
+#include <deque>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <string>
-#include <thread>
 
 #include "client/client_interface.h"
+#include "client/posix/client_reactor.h"
 #include "error.h"
+#include "socket/latency.h"
 
+// Asynchronous receive runs on a ClientReactor (the process-wide one unless a reactor is
+// passed in): data is delivered from the reactor thread as soon as epoll reports it, and a
+// lost connection is re-established there with a non-blocking connect every
+// auto_connect.retry_time_ms. With cfg.busy_poll.enabled and no reactor given, the client
+// gets its own spinning reactor thread.
+//
+// Sends never block: send_sync() and send_async() write what the socket takes at once and
+// queue the rest, which the reactor writes out when the socket turns writable. They fail
+// with SEND_FAILED while kMaxQueuedBytes are already waiting.
 class TcpClientPosix : public ClientInterface {
   public:
-    TcpClientPosix(const NetworkConfig& cfg);
+    static constexpr size_t kMaxQueuedBytes = 4 * 1024 * 1024;
+
+    TcpClientPosix(const NetworkConfig& cfg, std::shared_ptr<ClientReactor> reactor = nullptr);
+    ~TcpClientPosix() override;
 
     Error connect() override;
     Error connect_async(std::function<void(Error)> callback) override;
@@ -31,28 +46,53 @@ class TcpClientPosix : public ClientInterface {
 
     Error disconnect() override;
 
+    // Receive-to-callback latency of recieve_async(), with cfg.busy_poll.measure_latency
+    LatencyStats latency_stats() const { return latency.stats(); }
+
   private:
     bool sendMessage(const std::vector<uint8_t>& data);
     bool internal_connect(bool isBlocking);
     void stop();
     void setDelimiter(char d) { delimiter = d; }
     void setReconnectDelay(int ms) { reconnectDelayMs = ms; }
-    void reconnect() {
-        close(sock);
-        sock = -1;
-        std::this_thread::sleep_for(std::chrono::milliseconds(reconnectDelayMs));
-    }
     void set_keep_alive_options(int idle = 30, int interval = 10, int count = 3);
 
+    // Reactor side
+    bool watch_socket(int fd, uint32_t events);
+    bool update_watch_locked();  // register sock for what it needs now, sendMutex held
+    bool write_queue_locked();   // false when the socket failed, sendMutex held
+    void release_socket();       // unregister and close sock, drop queued sends
+    void on_socket_event(int fd, uint32_t events);
+    void on_readable(int fd);
+    void on_writable(int fd);
+    void on_connected(int fd);
+    void on_connection_lost(int fd);
+    void schedule_reconnect(int delay_ms);
+    void arm_reconnect_locked(int delay_ms);
+    void start_reconnect();
+
   private:
     std::string serverIP;
     int serverPort;
-    int sock;
+    std::atomic<int> sock;
     std::atomic<bool> running;
-    std::thread recvThread;
-    std::string recvBuffer;
     int reconnectDelayMs;
     char delimiter;
 
+    std::shared_ptr<ClientReactor> reactor;
+    ReceiveCallback recvCallback;
+    int timerFd = -1;                     // reconnect timer, registered while running
+    std::atomic<bool> connecting{false};  // non-blocking connect of sock in progress
+
+    LatencyHistogram latency;
+
     std::mutex sockMutex;
-};
\ No newline at end of file
+
+    // Send queue and reactor registration. Taken inside sockMutex, never around it, and
+    // never held across a blocking call; sock is only swapped with both held.
+    std::mutex sendMutex;
+    std::deque<std::vector<uint8_t>> sendQueue;
+    size_t sendOffset = 0;  // bytes of sendQueue.front() already written
+    size_t queuedBytes = 0;
+    uint32_t watchedEvents = 0;  // events sock is registered for, 0 when it is not
+};
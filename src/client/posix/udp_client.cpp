@@ -0,0 +1,162 @@
+#include "client/posix/udp_client.h"
+
+#include <arpa/inet.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+namespace {
+
+    constexpr int kMaxReadsPerEvent = 16;  // then let the other sockets of the loop run
+
+}  // namespace
+
+UdpClientPosix::UdpClientPosix(const NetworkConfig& cfg, std::shared_ptr<ClientReactor> reactor)
+    : ClientInterface(cfg),
+      reactor_(reactor ? std::move(reactor) : ClientReactor::for_config(cfg)),
+      buffer_(kMaxDatagram) {}
+
+UdpClientPosix::~UdpClientPosix() {
+    disconnect();
+}
+
+Error UdpClientPosix::connect() {
+    Error err;
+    int old = -1;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        old = fd_.exchange(-1);
+    }
+    if (old >= 0) {
+        reactor_->remove(old);
+        close(old);
+    }
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(cfg_.port);
+    if (inet_pton(AF_INET, cfg_.ip.c_str(), &addr.sin_addr) <= 0) {
+        err.set_code(ErrorCode::INVALID_ADDRESS)->set_message("Invalid server address");
+        return err;
+    }
+
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        err.set_code(ErrorCode::CONNECTION_FAILED)->set_message(strerror(errno));
+        return err;
+    }
+    cfg_.socket_options.apply(fd);
+    cfg_.busy_poll.apply(fd);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        err.set_code(ErrorCode::CONNECTION_FAILED)->set_message(strerror(errno));
+        close(fd);
+        return err;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    fd_ = fd;
+    is_connected_ = true;
+    if (receiving_ && !watch_locked())
+        err.set_code(ErrorCode::INTERNAL_ERROR)->set_message("Reactor registration failed");
+    return err;
+}
+
+Error UdpClientPosix::connect_async(AsyncCallback callback) {
+    Error err = connect();
+    if (callback)
+        callback(err);
+    return err;
+}
+
+Error UdpClientPosix::disconnect() {
+    receiving_ = false;
+    int fd = -1;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        fd = fd_.exchange(-1);
+        is_connected_ = false;
+    }
+    if (fd >= 0) {
+        reactor_->remove(fd);  // waits for a running callback
+        close(fd);
+    }
+    return Error();
+}
+
+Error UdpClientPosix::send_sync(const std::vector<uint8_t>& data) {
+    Error err;
+    const int fd = fd_;
+    if (fd < 0) {
+        err.set_code(ErrorCode::NOT_CONNECTED)->set_message("UDP socket not connected");
+        return err;
+    }
+    if (::send(fd, data.data(), data.size(), 0) < 0)
+        err.set_code(ErrorCode::SEND_FAILED)->set_message(strerror(errno));
+    return err;
+}
+
+Error UdpClientPosix::send_async(const std::vector<uint8_t>& data, AsyncCallback callback) {
+    // A datagram send doesn't block on the peer, complete it right away
+    Error err = send_sync(data);
+    if (callback)
+        callback(err);
+    return err;
+}
+
+Error UdpClientPosix::recieve_sync(std::vector<uint8_t>& out) {
+    Error err;
+    const int fd = fd_;
+    if (fd < 0) {
+        err.set_code(ErrorCode::NOT_CONNECTED)->set_message("UDP socket not connected");
+        return err;
+    }
+    out.resize(kMaxDatagram);
+    ssize_t bytes = ::recv(fd, out.data(), out.size(), 0);
+    if (bytes < 0) {
+        out.clear();
+        err.set_code(ErrorCode::RECEIVE_FAILED)->set_message(strerror(errno));
+        return err;
+    }
+    out.resize(bytes);
+    return err;
+}
+
+Error UdpClientPosix::recieve_async(ReceiveCallback callback) {
+    Error err;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (receiving_)
+        return err;
+    callback_ = std::move(callback);
+    receiving_ = true;
+    if (fd_ >= 0 && !watch_locked())
+        err.set_code(ErrorCode::INTERNAL_ERROR)->set_message("Reactor registration failed");
+    return err;
+}
+
+//------------------------------------------- PRIVATE //-------------------------------------------
+bool UdpClientPosix::watch_locked() {
+    const int fd = fd_;
+    Error err = reactor_->add(fd, EPOLLIN, [this, fd](uint32_t) { on_readable(fd); });
+    return err.code() == ErrorCode::NO_ERROR;
+}
+
+void UdpClientPosix::on_readable(int fd) {
+    for (int i = 0; i < kMaxReadsPerEvent && receiving_; ++i) {
+        ssize_t bytes = ::recv(fd, buffer_.data(), buffer_.size(), MSG_DONTWAIT);
+        if (bytes < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+                return;
+            // e.g. ECONNREFUSED from an ICMP port unreachable; the socket stays usable
+            Error err;
+            err.set_code(ErrorCode::RECEIVE_FAILED)->set_message(strerror(errno));
+            if (callback_)
+                callback_({}, err);
+            continue;
+        }
+        if (callback_)
+            callback_(std::vector<uint8_t>(buffer_.begin(), buffer_.begin() + bytes), Error());
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "client/client_interface.h"
+#include "client/posix/client_reactor.h"
+#include "error.h"
+
+// Connected UDP socket (only the server's datagrams are received, ICMP errors are reported).
+// recieve_async() delivers every datagram from a ClientReactor thread as soon as it arrives;
+// ClientReactor::for_config(cfg) is used unless a reactor is passed in.
+class UdpClientPosix : public ClientInterface {
+  public:
+    UdpClientPosix(const NetworkConfig& cfg, std::shared_ptr<ClientReactor> reactor = nullptr);
+    ~UdpClientPosix() override;
+
+    Error connect() override;
+    Error connect_async(AsyncCallback callback) override;
+    Error disconnect() override;
+
+    Error send_sync(const std::vector<uint8_t>& data) override;
+    Error send_async(const std::vector<uint8_t>& data, AsyncCallback callback) override;
+
+    Error recieve_sync(std::vector<uint8_t>& out) override;
+    Error recieve_async(ReceiveCallback callback) override;
+
+  private:
+    bool watch_locked();  // register fd_ with the reactor, mutex_ held
+    void on_readable(int fd);
+
+  private:
+    static constexpr size_t kMaxDatagram = 65536;
+
+    std::shared_ptr<ClientReactor> reactor_;
+    std::mutex mutex_;  // guards fd_ changes
+    std::atomic<int> fd_{-1};
+    std::atomic<bool> receiving_{false};
+    ReceiveCallback callback_;
+    std::vector<uint8_t> buffer_;  // reactor thread only
+};
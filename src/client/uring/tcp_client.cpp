@@ -0,0 +1,413 @@
+#include "client/uring/tcp_client.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <iostream>
+
+TcpClientUring::~TcpClientUring() {
+    disconnect();
+}
+
+// ====================== CONNECT (SYNC) ======================
+
+Error TcpClientUring::connect() {
+    if (sock_ >= 0)
+        disconnect();
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(cfg_.port);
+    if (inet_pton(AF_INET, cfg_.ip.c_str(), &addr.sin_addr) <= 0) {
+        Error err;
+        err.set_code(ErrorCode::INVALID_ADDRESS)->set_message("Invalid IP");
+        return err;
+    }
+
+    sock_ = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (sock_ < 0) {
+        Error err;
+        err.set_code(ErrorCode::CONNECTION_FAILED)->set_message("Failed to create TCP socket");
+        return err;
+    }
+
+    cfg_.socket_options.apply(sock_);
+    if (::connect(sock_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        close(sock_);
+        sock_ = -1;
+        Error err;
+        err.set_code(ErrorCode::SERVER_UNAVAILABLE)->set_message("Server is offline");
+        return err;
+    }
+
+    if (cfg_.keep_alive) {
+        int optval = 1;
+        setsockopt(sock_, SOL_SOCKET, SO_KEEPALIVE, &optval, sizeof(optval));
+    }
+
+    Error err = ring_.init(kRingEntries);
+    if (err.code() == ErrorCode::NO_ERROR)
+        err = ring_.setup_buffer_ring(kBufferGroup, kBufferCount, kBufferSize);
+    if (err.code() != ErrorCode::NO_ERROR) {
+        ring_.close();
+        close(sock_);
+        sock_ = -1;
+        return err;
+    }
+
+    stop_ = false;
+    worker_ = std::thread([this]() { this->run(); });
+
+    is_connected_ = true;
+    return Error{};
+}
+
+// ====================== CONNECT (ASYNC) ======================
+
+Error TcpClientUring::connect_async(AsyncCallback callback) {
+    Error err = connect();
+    if (callback)
+        callback(err);
+    return err;
+}
+
+// ====================== SEND ======================
+
+Error TcpClientUring::send_sync(const std::vector<uint8_t>& data) {
+    size_t total = 0;
+    while (total < data.size()) {
+        ssize_t sent = ::send(sock_, data.data() + total, data.size() - total, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR)
+            continue;
+        if (sent <= 0) {
+            Error err;
+            err.set_code(ErrorCode::SEND_FAILED)->set_message("Send failed");
+            return err;
+        }
+        total += sent;
+    }
+    return Error{};
+}
+
+Error TcpClientUring::send_async(const std::vector<uint8_t>& data, AsyncCallback callback) {
+    unsigned to_submit = 0;
+    Error err;
+    std::vector<AsyncCallback> failed;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (sock_ < 0 || !ring_.valid()) {
+            Error err;
+            err.set_code(ErrorCode::NOT_CONNECTED)->set_message("Not connected");
+            return err;
+        }
+
+        pending_.push_back(data);
+        pending_callbacks_.push_back(std::move(callback));
+        if (!send_armed_ && !start_send_locked()) {
+            err.set_code(ErrorCode::SEND_FAILED)->set_message("io_uring SQ full");
+            failed = fail_sends_locked();
+        }
+        to_submit = submit_from_caller_locked();
+    }
+
+    if (to_submit > 0)
+        ring_.enter(to_submit, 0, -1);
+    for (auto& failed_callback : failed) {
+        if (failed_callback)
+            failed_callback(err);
+    }
+    return err;
+}
+
+// ====================== RECEIVE ======================
+
+Error TcpClientUring::recieve_sync(std::vector<uint8_t>& out) {
+    uint8_t buf[kBufferSize];
+    ssize_t n = ::recv(sock_, buf, sizeof(buf), 0);
+    if (n <= 0) {
+        Error err;
+        err.set_code(ErrorCode::RECEIVE_FAILED)->set_message("Receive failed");
+        return err;
+    }
+    out.assign(buf, buf + n);
+    return Error{};
+}
+
+Error TcpClientUring::recieve_async(ReceiveCallback callback) {
+    unsigned to_submit = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (sock_ < 0 || !ring_.valid()) {
+            Error err;
+            err.set_code(ErrorCode::NOT_CONNECTED)->set_message("Not connected");
+            return err;
+        }
+
+        receive_callback_ = std::move(callback);
+        if (!recv_armed_ && !arm_recv_locked()) {
+            Error err;
+            err.set_code(ErrorCode::RECEIVE_FAILED)->set_message("io_uring SQ full");
+            return err;
+        }
+        to_submit = submit_from_caller_locked();
+    }
+
+    if (to_submit > 0)
+        ring_.enter(to_submit, 0, -1);
+    return Error{};
+}
+
+// ====================== DISCONNECT ======================
+
+Error TcpClientUring::disconnect() {
+    if (sock_ < 0)
+        return Error{};
+
+    stop_ = true;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (io_uring_sqe* sqe = ring_.get_sqe()) {
+            sqe->opcode = IORING_OP_NOP;
+            sqe->user_data = OP_WAKE;
+        }
+        ring_.enter(ring_.flush(), 0, -1);
+    }
+    if (worker_.joinable())
+        worker_.join();
+
+    // Cancel outstanding requests and reap them before the buffers go away
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        receive_callback_ = nullptr;
+        ::shutdown(sock_, SHUT_RDWR);
+        cancel_locked();
+        ring_.enter(ring_.flush(), 0, -1);
+    }
+    for (int i = 0; i < 50 && (recv_armed_ || send_armed_); ++i) {
+        ring_.enter(0, 1, 20);
+        ring_.for_each_cqe([this](const io_uring_cqe& cqe) { handle_completion(cqe); });
+    }
+
+    // Sends the reap didn't complete (queued behind the cancelled one) fail after teardown
+    std::vector<AsyncCallback> unsent;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ring_.close();
+        close(sock_);
+        sock_ = -1;
+        unsent = std::move(inflight_callbacks_);
+        unsent.insert(unsent.end(), std::make_move_iterator(pending_callbacks_.begin()),
+                      std::make_move_iterator(pending_callbacks_.end()));
+        pending_.clear();
+        pending_callbacks_.clear();
+        inflight_.clear();
+        inflight_callbacks_.clear();
+        recv_armed_ = send_armed_ = false;
+        is_connected_ = false;
+    }
+
+    Error err;
+    err.set_code(ErrorCode::DISCONNECTED)->set_message("Disconnected before the send completed");
+    for (auto& callback : unsent) {
+        if (callback)
+            callback(err);
+    }
+    return Error{};
+}
+
+//------------------------------------------- PRIVATE //-------------------------------------------
+
+void TcpClientUring::run() {
+    while (!stop_) {
+        unsigned to_submit;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            to_submit = ring_.flush();
+        }
+
+        int ret = ring_.enter(to_submit, 1, 200);
+        if (ret < 0 && ret != -ETIME && ret != -EINTR && ret != -EBUSY)
+            std::cerr << "io_uring_enter() failed: " << strerror(-ret) << std::endl;
+
+        ring_.for_each_cqe([this](const io_uring_cqe& cqe) { handle_completion(cqe); });
+    }
+}
+
+void TcpClientUring::handle_completion(const io_uring_cqe& cqe) {
+    switch (static_cast<Op>(cqe.user_data)) {
+        case OP_RECV:
+            on_recv(cqe);
+            break;
+        case OP_SEND:
+            on_send(cqe);
+            break;
+        case OP_WAKE:
+        case OP_CANCEL:
+            break;
+    }
+}
+
+void TcpClientUring::on_recv(const io_uring_cqe& cqe) {
+    const bool more = cqe.flags & IORING_CQE_F_MORE;
+
+    std::vector<uint8_t> data;
+    if ((cqe.flags & IORING_CQE_F_BUFFER) && cqe.res > 0) {
+        uint16_t bid = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+        const uint8_t* buf = ring_.buffer(bid);
+        data.assign(buf, buf + cqe.res);
+    }
+
+    ReceiveCallback callback;
+    Error err;
+    Error lost;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (cqe.flags & IORING_CQE_F_BUFFER)
+            ring_.recycle_buffer(static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT));
+
+        callback = receive_callback_;
+        if (!more)
+            recv_armed_ = false;
+
+        if (cqe.res > 0)
+            cfg_.socket_options.rearm_quickack(sock_);
+        if (cqe.res > 0 || cqe.res == -ENOBUFS) {
+            // -ENOBUFS: buffer ring ran dry, the request ended and is simply re-armed
+            if (!more && !stop_ && !arm_recv_locked()) {
+                // Nothing would be received any more: close, the loss is reported below
+                ::shutdown(sock_, SHUT_RDWR);
+                is_connected_ = false;
+                lost.set_code(ErrorCode::RECEIVE_FAILED)->set_message("io_uring SQ full");
+            } else if (cqe.res < 0) {
+                return;
+            }
+        } else {
+            err.set_code(cqe.res == 0 ? ErrorCode::DISCONNECTED : ErrorCode::RECEIVE_FAILED)
+                ->set_message(cqe.res == 0 ? "Connection closed" : strerror(-cqe.res));
+            is_connected_ = false;
+        }
+    }
+
+    if (callback && cqe.res != -ENOBUFS)
+        callback(data, err);
+    if (callback && lost.code() != ErrorCode::NO_ERROR)
+        callback({}, lost);
+}
+
+void TcpClientUring::on_send(const io_uring_cqe& cqe) {
+    std::vector<AsyncCallback> done;
+    std::vector<AsyncCallback> failed;
+    Error err;
+    Error lost;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        send_armed_ = false;
+
+        if (cqe.res < 0) {
+            err.set_code(ErrorCode::SEND_FAILED)->set_message(strerror(-cqe.res));
+            done = fail_sends_locked();
+        } else {
+            inflight_offset_ += cqe.res;
+            if (inflight_offset_ >= inflight_.size()) {
+                done = std::move(inflight_callbacks_);
+                inflight_callbacks_.clear();
+                inflight_.clear();
+            }
+            if (!stop_ && (!inflight_.empty() || !pending_.empty()) && !start_send_locked()) {
+                lost.set_code(ErrorCode::SEND_FAILED)->set_message("io_uring SQ full");
+                failed = fail_sends_locked();
+            }
+        }
+    }
+
+    for (auto& callback : done) {
+        if (callback)
+            callback(err);
+    }
+    for (auto& callback : failed) {
+        if (callback)
+            callback(lost);
+    }
+}
+
+std::vector<TcpClientUring::AsyncCallback> TcpClientUring::fail_sends_locked() {
+    // The stream can't carry the rest in order any more: close, and fail every queued send
+    if (!stop_)
+        ::shutdown(sock_, SHUT_RDWR);
+    is_connected_ = false;
+
+    std::vector<AsyncCallback> failed = std::move(inflight_callbacks_);
+    failed.insert(failed.end(), std::make_move_iterator(pending_callbacks_.begin()),
+                  std::make_move_iterator(pending_callbacks_.end()));
+    inflight_.clear();
+    inflight_callbacks_.clear();
+    pending_.clear();
+    pending_callbacks_.clear();
+    return failed;
+}
+
+bool TcpClientUring::arm_recv_locked() {
+    io_uring_sqe* sqe = ring_.get_sqe_or_flush();
+    if (!sqe)
+        return false;
+
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = sock_;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = kBufferGroup;
+    sqe->user_data = OP_RECV;
+    recv_armed_ = true;
+    return true;
+}
+
+bool TcpClientUring::start_send_locked() {
+    // Gather all queued messages into one send; their callbacks complete together
+    if (inflight_.empty()) {
+        if (pending_.size() == 1) {
+            inflight_ = std::move(pending_.front());
+        } else {
+            for (auto& chunk : pending_)
+                inflight_.insert(inflight_.end(), chunk.begin(), chunk.end());
+        }
+        inflight_callbacks_.assign(std::make_move_iterator(pending_callbacks_.begin()),
+                                   std::make_move_iterator(pending_callbacks_.end()));
+        pending_.clear();
+        pending_callbacks_.clear();
+        inflight_offset_ = 0;
+    }
+
+    io_uring_sqe* sqe = ring_.get_sqe_or_flush();
+    if (!sqe)
+        return false;
+
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = sock_;
+    sqe->addr = reinterpret_cast<uint64_t>(inflight_.data() + inflight_offset_);
+    sqe->len = static_cast<uint32_t>(inflight_.size() - inflight_offset_);
+    // Only the rest of a partial send can have messages queued behind it; with tcp_cork
+    // its last partial segment then waits for them
+    sqe->msg_flags = MSG_NOSIGNAL | cfg_.socket_options.more_flag(!pending_.empty());
+    sqe->user_data = OP_SEND;
+    send_armed_ = true;
+    return true;
+}
+
+void TcpClientUring::cancel_locked() {
+    if (io_uring_sqe* sqe = ring_.get_sqe()) {
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = sock_;
+        sqe->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+        sqe->user_data = OP_CANCEL;
+    }
+}
+
+unsigned TcpClientUring::submit_from_caller_locked() {
+    // The completion thread flushes in its next io_uring_enter(); other callers submit now
+    if (std::this_thread::get_id() == worker_.get_id())
+        return 0;
+    return ring_.flush();
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "client/client_interface.h"
+#include "error.h"
+#include "uring/ring.h"
+
+// io_uring TCP client. A completion thread owns the ring; sends are queued and gathered into
+// one in-flight send, receives use a multishot recv on a provided buffer ring.
+class TcpClientUring : public ClientInterface {
+  public:
+    explicit TcpClientUring(const NetworkConfig& cfg) : ClientInterface(cfg) {}
+    ~TcpClientUring() override;
+
+    Error connect() override;
+    Error connect_async(AsyncCallback callback) override;
+
+    Error send_sync(const std::vector<uint8_t>& data) override;
+    Error send_async(const std::vector<uint8_t>& data, AsyncCallback callback) override;
+
+    Error recieve_sync(std::vector<uint8_t>& out) override;
+
+    // Delivers every received chunk to callback until the connection fails or is closed
+    Error recieve_async(ReceiveCallback callback) override;
+
+    Error disconnect() override;
+
+  private:
+    enum Op : uint64_t { OP_WAKE = 1, OP_RECV, OP_SEND, OP_CANCEL };
+
+    void run();
+    void handle_completion(const io_uring_cqe& cqe);
+    void on_recv(const io_uring_cqe& cqe);
+    void on_send(const io_uring_cqe& cqe);
+
+    // The *_locked helpers prepare sqes and expect mutex_ to be held. They return false when
+    // the SQ is still full after submitting it.
+    bool arm_recv_locked();
+    bool start_send_locked();
+    std::vector<AsyncCallback> fail_sends_locked();  // closes the connection
+    void cancel_locked();
+    unsigned submit_from_caller_locked();
+
+  private:
+    static constexpr unsigned kRingEntries = 256;
+    static constexpr unsigned kBufferCount = 64;
+    static constexpr unsigned kBufferSize = 4096;
+    static constexpr uint16_t kBufferGroup = 0;
+
+    int sock_ = -1;
+    UringRing ring_;
+    std::thread worker_;
+    std::atomic<bool> stop_{false};
+
+    std::mutex mutex_;  // guards the SQ side of ring_ and the send/receive state below
+    std::deque<std::vector<uint8_t>> pending_;
+    std::deque<AsyncCallback> pending_callbacks_;
+    std::vector<uint8_t> inflight_;
+    std::vector<AsyncCallback> inflight_callbacks_;
+    size_t inflight_offset_ = 0;
+    ReceiveCallback receive_callback_;
+    bool recv_armed_ = false;
+    bool send_armed_ = false;
+};
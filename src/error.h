@@ -22,6 +22,7 @@ enum class ErrorCode {
     SERVER_UNAVAILABLE = 14,  // Client cannot reach server
     NOT_IMPLEMENTED = 15,
     DISCONNECTION_FAILED = 16,
+    WOULD_BLOCK = 17,  // Non-blocking call made partial progress, retry the rest
 };
 
 inline std::string error_message_from_code(ErrorCode code) {
@@ -58,6 +59,8 @@ inline std::string error_message_from_code(ErrorCode code) {
             return "Port is already in use";
         case ErrorCode::SERVER_UNAVAILABLE:
             return "Server is unavailable";
+        case ErrorCode::WOULD_BLOCK:
+            return "Operation would block";
 
         default:
             return "Unknown error";
@@ -1,28 +1,26 @@
 #pragma once
 
-#include <asio.hpp>
 #include <memory>
-#include <thread>
 
 #include "client/asio/tcp_client.h"
 #include "client/asio/udp_client.h"
 #include "client/client_interface.h"
-
-// #include "client/posix/tcp_client_posix.h"   // future
-// #include "client/posix/udp_client_posix.h"   // future
+#include "client/client_runtime.h"
+#include "client/posix/tcp_client.h"
+#include "client/posix/udp_client.h"
+#include "client/uring/tcp_client.h"
 
 class ClientFactory {
   public:
+    // Clients on the process-wide runtime (one I/O thread)
     static std::shared_ptr<ClientInterface> create(const NetworkConfig& cfg) {
-        // Shared io_context for all ASIO clients
-        static auto io = std::make_shared<asio::io_context>();
-
-        static auto work =
-            std::make_shared<asio::executor_work_guard<asio::io_context::executor_type> >(
-                asio::make_work_guard(*io));
-
-        static std::thread io_thread([] { io->run(); });
+        return create(cfg, ClientRuntime::shared());
+    }
 
+    // Asio clients run on one of the runtime's I/O threads, POSIX clients on its reactor
+    // (busy-polling ones get their own)
+    static std::shared_ptr<ClientInterface> create(const NetworkConfig& cfg,
+                                                   const std::shared_ptr<ClientRuntime>& runtime) {
         // -----------------------------
         // BACKEND SELECTION
         // -----------------------------
@@ -30,20 +28,37 @@ class ClientFactory {
             case NetworkConfig::BackendType::ASIO:
                 switch (cfg.connection_type) {
                     case ClientType::TCP:
-                        return std::make_shared<TcpClientAsio>(cfg, io);
+                        return std::make_shared<TcpClientAsio>(cfg, runtime->next_context());
 
                     case ClientType::UDP:
-                        return std::make_shared<UdpClient>(cfg, io);
+                        return std::make_shared<UdpClient>(cfg, runtime->next_context());
 
                     default:
                         return nullptr;
                 }
 
-            case NetworkConfig::BackendType::POSIX:
-                // TODO: implement POSIX clients
-                // return std::make_shared<TcpClientPosix>(cfg);
-                // return std::make_shared<UdpClientPosix>(cfg);
-                return nullptr;
+            case NetworkConfig::BackendType::POSIX: {
+                auto reactor = cfg.busy_poll.enabled ? nullptr : runtime->reactor();
+                switch (cfg.connection_type) {
+                    case ClientType::TCP:
+                        return std::make_shared<TcpClientPosix>(cfg, reactor);
+
+                    case ClientType::UDP:
+                        return std::make_shared<UdpClientPosix>(cfg, reactor);
+
+                    default:
+                        return nullptr;
+                }
+            }
+
+            case NetworkConfig::BackendType::IO_URING:
+                switch (cfg.connection_type) {
+                    case ClientType::TCP:
+                        return std::make_shared<TcpClientUring>(cfg);
+
+                    default:
+                        return nullptr;
+                }
         }
 
         return nullptr;
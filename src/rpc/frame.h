@@ -0,0 +1,123 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <vector>
+
+// Framing of RpcClient / RpcServer messages on a byte stream.
+//
+// Every request and reply is an 8-byte header followed by the payload:
+//   uint32 payload length | uint32 request id     (both big-endian)
+// A reply carries the id of its request, so replies may come back in any order and many
+// requests can be outstanding on one connection.
+namespace rpc_frame {
+
+    constexpr size_t kHeaderSize = 8;
+    constexpr size_t kDefaultMaxPayload = 16 * 1024 * 1024;
+
+    inline void put_u32(uint8_t* p, uint32_t v) {
+        p[0] = uint8_t(v >> 24);
+        p[1] = uint8_t(v >> 16);
+        p[2] = uint8_t(v >> 8);
+        p[3] = uint8_t(v);
+    }
+
+    inline uint32_t get_u32(const uint8_t* p) {
+        return uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | p[3];
+    }
+
+    // Header and payload in one buffer, ready for a single send
+    inline std::vector<uint8_t> encode(uint32_t id, std::span<const uint8_t> payload) {
+        std::vector<uint8_t> frame(kHeaderSize + payload.size());
+        put_u32(frame.data(), static_cast<uint32_t>(payload.size()));
+        put_u32(frame.data() + 4, id);
+        if (!payload.empty())
+            std::memcpy(frame.data() + kHeaderSize, payload.data(), payload.size());
+        return frame;
+    }
+
+    // Splits a byte stream back into frames. Complete frames in the input are handed over
+    // in place; only a frame cut off at the end of a read is copied, until the rest arrives.
+    class Decoder {
+      public:
+        explicit Decoder(size_t max_payload = kDefaultMaxPayload) : max_payload_(max_payload) {}
+
+        // Calls on_frame(id, payload) for every frame completed by bytes; the payload is only
+        // valid during the call. False when a header announces more than max_payload: the
+        // stream can't be resynchronised and the decoder stays failed until reset().
+        template <typename F>
+        bool feed(std::span<const uint8_t> bytes, F&& on_frame) {
+            if (failed_)
+                return false;
+
+            if (!partial_.empty()) {
+                bytes = complete_partial(bytes, on_frame);
+                if (failed_ || !partial_.empty())
+                    return !failed_;
+            }
+
+            while (bytes.size() >= kHeaderSize) {
+                const uint32_t len = get_u32(bytes.data());
+                if (len > max_payload_)
+                    return fail();
+                if (bytes.size() < kHeaderSize + len)
+                    break;
+                on_frame(get_u32(bytes.data() + 4), bytes.subspan(kHeaderSize, len));
+                bytes = bytes.subspan(kHeaderSize + len);
+            }
+            partial_.assign(bytes.begin(), bytes.end());
+            return true;
+        }
+
+        // Bytes held back for an incomplete frame
+        size_t buffered() const { return partial_.size(); }
+
+        void reset() {
+            partial_.clear();
+            failed_ = false;
+        }
+
+      private:
+        // Tops up partial_ from bytes; returns what is left once its frame is complete
+        template <typename F>
+        std::span<const uint8_t> complete_partial(std::span<const uint8_t> bytes, F& on_frame) {
+            if (partial_.size() < kHeaderSize) {
+                const size_t take = std::min(kHeaderSize - partial_.size(), bytes.size());
+                partial_.insert(partial_.end(), bytes.begin(), bytes.begin() + take);
+                bytes = bytes.subspan(take);
+                if (partial_.size() < kHeaderSize)
+                    return bytes;
+            }
+
+            const uint32_t len = get_u32(partial_.data());
+            if (len > max_payload_) {
+                fail();
+                return {};
+            }
+            const size_t take = std::min(kHeaderSize + len - partial_.size(), bytes.size());
+            partial_.insert(partial_.end(), bytes.begin(), bytes.begin() + take);
+            bytes = bytes.subspan(take);
+            if (partial_.size() < kHeaderSize + len)
+                return bytes;
+
+            on_frame(get_u32(partial_.data() + 4),
+                     std::span<const uint8_t>(partial_).subspan(kHeaderSize, len));
+            partial_.clear();
+            return bytes;
+        }
+
+        bool fail() {
+            failed_ = true;
+            partial_.clear();
+            return false;
+        }
+
+        size_t max_payload_;
+        std::vector<uint8_t> partial_;
+        bool failed_ = false;
+    };
+
+}  // namespace rpc_frame
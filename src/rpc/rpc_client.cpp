@@ -0,0 +1,210 @@
+#include "rpc/rpc_client.h"
+
+#include <bit>
+#include <limits>
+
+std::shared_ptr<RpcClient> RpcClient::create(std::shared_ptr<TcpClientAsio> client,
+                                             RpcClientOptions options) {
+    std::shared_ptr<RpcClient> rpc(new RpcClient(std::move(client), std::move(options)));
+    rpc->start();
+    return rpc;
+}
+
+RpcClient::RpcClient(std::shared_ptr<TcpClientAsio> client, RpcClientOptions options)
+    : client_(std::move(client)),
+      options_(std::move(options)),
+      decoder_(options_.max_payload),
+      deadlines_(client_->executor()) {
+    const size_t capacity = std::bit_ceil(std::max<size_t>(options_.max_in_flight, 1));
+    slots_ = std::make_unique<Slot[]>(capacity);
+    mask_ = static_cast<uint32_t>(capacity - 1);
+    if (options_.deadline_resolution.count() <= 0)
+        options_.deadline_resolution = std::chrono::milliseconds(1);
+}
+
+RpcClient::~RpcClient() {
+    client_->stop_receiving();
+    fail_all(ErrorCode::DISCONNECTED, "RPC client destroyed");
+}
+
+void RpcClient::start() {
+    std::weak_ptr<RpcClient> weak = weak_from_this();
+    client_->start_receiving(
+        [weak](const std::vector<uint8_t>& data, Error err) {
+            if (auto self = weak.lock())
+                self->on_data(data, err);
+        },
+        true);
+    // Nothing else uses the timer before its first completion
+    arm_deadline_timer();
+}
+
+// ====================== PENDING TABLE ======================
+
+int64_t RpcClient::now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+uint32_t RpcClient::claim(ReplyCallback callback, std::chrono::milliseconds timeout) {
+    // Ids advance for every attempt, so a slot still held by a slow call is stepped over
+    for (size_t attempt = 0; attempt <= mask_; ++attempt) {
+        const uint32_t id = next_id_.fetch_add(1, std::memory_order_relaxed);
+        if (id == kFree || id == kBusy)
+            continue;  // wrapped around
+
+        Slot& slot = slots_[id & mask_];
+        uint32_t expected = kFree;
+        if (slot.owner.load(std::memory_order_relaxed) != kFree ||
+            !slot.owner.compare_exchange_strong(expected, kBusy, std::memory_order_acquire))
+            continue;
+
+        // Published with the id below: whoever completes the call sees both
+        slot.callback = std::move(callback);
+        slot.deadline_ns.store(
+            timeout.count() > 0
+                ? now_ns() + std::chrono::nanoseconds(timeout).count()
+                : std::numeric_limits<int64_t>::max(),
+            std::memory_order_relaxed);
+        in_flight_.fetch_add(1, std::memory_order_relaxed);
+        slot.owner.store(id, std::memory_order_release);
+        return id;
+    }
+    return 0;
+}
+
+bool RpcClient::complete(uint32_t id, RpcReply reply) {
+    if (id == kFree || id == kBusy)
+        return false;
+
+    Slot& slot = slots_[id & mask_];
+    uint32_t expected = id;
+    if (!slot.owner.compare_exchange_strong(expected, kBusy, std::memory_order_acquire))
+        return false;
+
+    // The slot is free again before the callback runs, which may call again
+    ReplyCallback callback = std::move(slot.callback);
+    slot.callback = nullptr;
+    in_flight_.fetch_sub(1, std::memory_order_relaxed);
+    slot.owner.store(kFree, std::memory_order_release);
+
+    callback(std::move(reply));
+    return true;
+}
+
+void RpcClient::fail_all(ErrorCode code, const char* message) {
+    Error err;
+    err.set_code(code)->set_message(message);
+    for (uint32_t i = 0; i <= mask_; ++i) {
+        const uint32_t id = slots_[i].owner.load(std::memory_order_acquire);
+        complete(id, RpcReply{err, {}});
+    }
+}
+
+// ====================== CALLS ======================
+
+Error RpcClient::call_async(std::span<const uint8_t> request, ReplyCallback callback,
+                            std::chrono::milliseconds timeout) {
+    const uint32_t id = claim(std::move(callback), timeout);
+    if (id == 0) {
+        Error err;
+        err.set_code(ErrorCode::SEND_FAILED)->set_message("Too many calls in flight");
+        return err;
+    }
+
+    // The frame joins the client's queue and leaves in the next gathered write
+    std::weak_ptr<RpcClient> weak = weak_from_this();
+    client_->send_async(rpc_frame::encode(id, request), [weak, id](Error err) {
+        if (err.code() == ErrorCode::NO_ERROR)
+            return;
+        if (auto self = weak.lock())
+            self->complete(id, RpcReply{err, {}});
+    });
+    return Error{};
+}
+
+std::future<RpcReply> RpcClient::call(std::span<const uint8_t> request,
+                                      std::chrono::milliseconds timeout) {
+    auto promise = std::make_shared<std::promise<RpcReply>>();
+    auto future = promise->get_future();
+    Error err = call_async(
+        request, [promise](RpcReply reply) { promise->set_value(std::move(reply)); }, timeout);
+    if (err.code() != ErrorCode::NO_ERROR)
+        promise->set_value(RpcReply{err, {}});
+    return future;
+}
+
+asio::awaitable<RpcReply> RpcClient::co_call(std::span<const uint8_t> request,
+                                             std::chrono::milliseconds timeout) {
+    auto self = shared_from_this();
+    co_return co_await asio::async_initiate<const asio::use_awaitable_t<>&, void(RpcReply)>(
+        [self, request, timeout](auto handler) {
+            // Completion callbacks are copyable, the coroutine's handler is not
+            auto shared = std::make_shared<decltype(handler)>(std::move(handler));
+            auto resume = [shared](RpcReply reply) {
+                auto ex = asio::get_associated_executor(*shared);
+                asio::dispatch(ex, [shared, reply = std::move(reply)]() mutable {
+                    (*shared)(std::move(reply));
+                });
+            };
+
+            Error err = self->call_async(request, resume, timeout);
+            if (err.code() != ErrorCode::NO_ERROR)
+                resume(RpcReply{err, {}});
+        },
+        asio::use_awaitable);
+}
+
+// ====================== REPLIES ======================
+
+void RpcClient::on_data(const std::vector<uint8_t>& data, Error err) {
+    if (err.code() != ErrorCode::NO_ERROR) {
+        // Calls sent on the lost connection will never be answered
+        decoder_.reset();
+        fail_all(ErrorCode::RECEIVE_FAILED, "Connection lost");
+        return;
+    }
+
+    const bool ok = decoder_.feed(data, [this](uint32_t id, std::span<const uint8_t> payload) {
+        complete(id, RpcReply{Error{}, std::vector<uint8_t>(payload.begin(), payload.end())});
+    });
+    if (!ok) {
+        decoder_.reset();
+        fail_all(ErrorCode::RECEIVE_FAILED, "Malformed reply frame");
+        client_->disconnect();
+    }
+}
+
+// ====================== DEADLINES ======================
+
+void RpcClient::arm_deadline_timer() {
+    deadlines_.expires_after(options_.deadline_resolution);
+    deadlines_.async_wait([weak = weak_from_this()](const asio::error_code& ec) {
+        if (ec)
+            return;
+        if (auto self = weak.lock()) {
+            self->expire_deadlines();
+            self->arm_deadline_timer();
+        }
+    });
+}
+
+void RpcClient::expire_deadlines() {
+    if (in_flight_.load(std::memory_order_relaxed) == 0)
+        return;
+
+    Error err;
+    err.set_code(ErrorCode::TIMEOUT)->set_message("RPC deadline passed");
+    const int64_t now = now_ns();
+    for (uint32_t i = 0; i <= mask_; ++i) {
+        Slot& slot = slots_[i];
+        const uint32_t id = slot.owner.load(std::memory_order_acquire);
+        if (id == kFree || id == kBusy)
+            continue;
+        // Read after the id: if the slot moved on to a newer call meanwhile, complete(id)
+        // no longer matches and this deadline is not applied
+        if (slot.deadline_ns.load(std::memory_order_relaxed) <= now)
+            complete(id, RpcReply{err, {}});
+    }
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <asio.hpp>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "client/asio/tcp_client.h"
+#include "error.h"
+#include "rpc/frame.h"
+
+struct RpcReply {
+    Error error;
+    std::vector<uint8_t> payload;
+};
+
+struct RpcClientOptions {
+    // Requests outstanding at once, rounded up to a power of two; call() fails beyond that
+    size_t max_in_flight = 1024;
+
+    // Deadline of a call() made without one; zero or negative means no deadline
+    std::chrono::milliseconds timeout{5000};
+
+    // How often deadlines are checked, so a call times out up to this much late
+    std::chrono::milliseconds deadline_resolution{10};
+
+    // Largest reply accepted; a bigger frame header disconnects the client
+    size_t max_payload = rpc_frame::kDefaultMaxPayload;
+};
+
+// Request/response calls over one TcpClientAsio connection, pipelined: every request is
+// framed with an id (see rpc/frame.h), goes straight into the client's send queue, and is
+// completed by the reply carrying the same id, in whatever order replies arrive. A
+// connection carries as many calls per round trip as fit its bandwidth instead of one.
+//
+// Outstanding calls live in a fixed table of slots indexed by id; claiming and completing a
+// slot are single compare-exchanges, so callers on any thread never take a lock. A call
+// completes exactly once: with the reply, with TIMEOUT at its deadline, with SEND_FAILED, or
+// with RECEIVE_FAILED when the connection drops (the server won't answer calls sent on it).
+// A reply arriving after its call completed is dropped.
+//
+// The RpcClient owns the client's streaming receive (start_receiving); don't read from the
+// client otherwise. Completion callbacks run on the client's executor and should not block.
+class RpcClient : public std::enable_shared_from_this<RpcClient> {
+  public:
+    using ReplyCallback = std::function<void(RpcReply)>;
+
+    // client must be connected, or connect later; calls made meanwhile fail with SEND_FAILED
+    static std::shared_ptr<RpcClient> create(std::shared_ptr<TcpClientAsio> client,
+                                             RpcClientOptions options = {});
+
+    // Fails the calls still outstanding with DISCONNECTED and stops the client's receive
+    ~RpcClient();
+
+    RpcClient(const RpcClient&) = delete;
+    RpcClient& operator=(const RpcClient&) = delete;
+
+    // Queues request; callback runs once with the reply or the error. The returned error is
+    // set, and the callback never runs, when max_in_flight calls are already outstanding.
+    Error call_async(std::span<const uint8_t> request, ReplyCallback callback,
+                     std::chrono::milliseconds timeout);
+    Error call_async(std::span<const uint8_t> request, ReplyCallback callback) {
+        return call_async(request, std::move(callback), options_.timeout);
+    }
+
+    // Future of the reply; a rejected call is a ready future holding the error
+    std::future<RpcReply> call(std::span<const uint8_t> request,
+                               std::chrono::milliseconds timeout);
+    std::future<RpcReply> call(std::span<const uint8_t> request) {
+        return call(request, options_.timeout);
+    }
+
+    // For coroutines; resumes on the awaiting coroutine's executor. request is copied when
+    // the call is awaited and must stay valid until then.
+    asio::awaitable<RpcReply> co_call(std::span<const uint8_t> request,
+                                      std::chrono::milliseconds timeout);
+    asio::awaitable<RpcReply> co_call(std::span<const uint8_t> request) {
+        return co_call(request, options_.timeout);
+    }
+
+    // Calls sent and not completed yet
+    size_t in_flight() const { return in_flight_.load(std::memory_order_relaxed); }
+
+    const std::shared_ptr<TcpClientAsio>& client() const { return client_; }
+
+  private:
+    RpcClient(std::shared_ptr<TcpClientAsio> client, RpcClientOptions options);
+
+    // owner values besides request ids
+    static constexpr uint32_t kFree = 0;
+    static constexpr uint32_t kBusy = 0xFFFFFFFF;  // being filled in or completed
+
+    struct alignas(64) Slot {
+        std::atomic<uint32_t> owner{kFree};
+        std::atomic<int64_t> deadline_ns{0};  // steady clock
+        ReplyCallback callback;               // only touched by whoever set owner to kBusy
+    };
+
+    void start();
+
+    // Claims a free slot and returns its id, 0 when the table is full
+    uint32_t claim(ReplyCallback callback, std::chrono::milliseconds timeout);
+
+    // Completes call id if it is still outstanding; false for a late or unknown id
+    bool complete(uint32_t id, RpcReply reply);
+    void fail_all(ErrorCode code, const char* message);
+
+    // Strand only
+    void on_data(const std::vector<uint8_t>& data, Error err);
+    void arm_deadline_timer();
+    void expire_deadlines();
+
+    static int64_t now_ns();
+
+  private:
+    std::shared_ptr<TcpClientAsio> client_;
+    RpcClientOptions options_;
+
+    std::unique_ptr<Slot[]> slots_;
+    uint32_t mask_;
+    std::atomic<uint32_t> next_id_{1};
+    std::atomic<size_t> in_flight_{0};
+
+    rpc_frame::Decoder decoder_;    // strand only
+    asio::steady_timer deadlines_;  // strand only
+};
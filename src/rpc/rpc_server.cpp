@@ -0,0 +1,53 @@
+#include "rpc/rpc_server.h"
+
+Error RpcServer::Responder::reply(std::span<const uint8_t> payload) const {
+    if (!server_) {
+        Error err;
+        err.set_code(ErrorCode::NOT_CONNECTED)->set_message("RpcServer is not attached");
+        return err;
+    }
+    return server_->send(fd_, rpc_frame::encode(id_, payload));
+}
+
+RpcServer::RpcServer(Handler handler, size_t max_payload)
+    : handler_(std::move(handler)), max_payload_(max_payload) {}
+
+ServerInterface::ReceiveCallback RpcServer::receive_callback() {
+    return [this](int fd, const std::string&, const std::vector<uint8_t>& data) {
+        on_receive(fd, data);
+    };
+}
+
+ServerInterface::ClientDisconnectCallback RpcServer::disconnect_callback(
+    ServerInterface::ClientDisconnectCallback next) {
+    return [this, next = std::move(next)](int fd, const std::string& ip) {
+        on_disconnect(fd);
+        if (next)
+            next(fd, ip);
+    };
+}
+
+void RpcServer::on_receive(int fd, const std::vector<uint8_t>& data) {
+    std::shared_ptr<Connection> conn;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& slot = connections_[fd];
+        if (!slot)
+            slot = std::make_shared<Connection>(max_payload_);
+        conn = slot;
+    }
+
+    // A connection's receive callbacks never overlap, so its decoder needs no lock
+    const bool ok = conn->decoder.feed(data, [&](uint32_t id, std::span<const uint8_t> request) {
+        handler_(fd, request, Responder(server_, fd, id));
+    });
+    if (!ok && !conn->malformed) {
+        conn->malformed = true;
+        malformed_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void RpcServer::on_disconnect(int fd) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    connections_.erase(fd);
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "error.h"
+#include "rpc/frame.h"
+#include "server/server_interface.h"
+
+// Server half of RpcClient, for any ServerInterface (TcpServer, TcpServerAsio,
+// TcpServerUring). Request frames are reassembled per connection from the receive callback
+// and handed to the handler with a Responder that frames the reply with the request's id,
+// so a handler may answer at once or later, from any thread, in any order.
+//
+//   RpcServer rpc(handler);
+//   TcpServerAsio server(cfg, rpc.receive_callback(), on_connect, rpc.disconnect_callback());
+//   rpc.attach(&server);
+//
+// Connections are keyed by the fd the server reports. TcpServer recycles fd numbers, so it
+// reports a disconnect before closing the socket; a server must do the same (or never reuse
+// ids, as TcpServerAsio and TcpServerUring don't) or a new connection could inherit the old
+// one's partial frame.
+//
+// The RpcServer must outlive the server it is attached to.
+class RpcServer {
+  public:
+    class Responder {
+      public:
+        // Sends payload as the reply; once per request
+        Error reply(std::span<const uint8_t> payload) const;
+
+        int fd() const { return fd_; }
+        uint32_t id() const { return id_; }
+
+      private:
+        friend class RpcServer;
+        Responder(ServerInterface* server, int fd, uint32_t id)
+            : server_(server), fd_(fd), id_(id) {}
+
+        ServerInterface* server_;
+        int fd_;
+        uint32_t id_;
+    };
+
+    // request is only valid during the call; copy it to answer later
+    using Handler =
+        std::function<void(int fd, std::span<const uint8_t> request, Responder responder)>;
+
+    explicit RpcServer(Handler handler, size_t max_payload = rpc_frame::kDefaultMaxPayload);
+
+    RpcServer(const RpcServer&) = delete;
+    RpcServer& operator=(const RpcServer&) = delete;
+
+    // Callbacks to construct the server with. next, if set, runs after the connection's
+    // partial frame is dropped.
+    ServerInterface::ReceiveCallback receive_callback();
+    ServerInterface::ClientDisconnectCallback disconnect_callback(
+        ServerInterface::ClientDisconnectCallback next = nullptr);
+
+    // Server the replies are sent through; set before listen()
+    void attach(ServerInterface* server) { server_ = server; }
+
+    // Connections that sent a frame larger than max_payload; the rest of their input is
+    // ignored until they disconnect
+    uint64_t malformed_connections() const { return malformed_.load(std::memory_order_relaxed); }
+
+  private:
+    struct Connection {
+        explicit Connection(size_t max_payload) : decoder(max_payload) {}
+        // Used by the connection's receive callbacks only
+        rpc_frame::Decoder decoder;
+        bool malformed = false;
+    };
+
+    void on_receive(int fd, const std::vector<uint8_t>& data);
+    void on_disconnect(int fd);
+
+  private:
+    Handler handler_;
+    size_t max_payload_;
+    ServerInterface* server_ = nullptr;
+
+    std::mutex mutex_;  // guards the map, not the decoders
+    std::unordered_map<int, std::shared_ptr<Connection>> connections_;
+    std::atomic<uint64_t> malformed_{0};
+};
@@ -1,14 +1,15 @@
 #include "tcp_server.h"
 
+#include <algorithm>
+#include <span>
+
 TcpServerAsio::TcpServerAsio(
     ServerConfig cfg,
     ReceiveCallback receiveCallback,
     ClientConnectCallback clientConnectCallback,
     ClientDisconnectCallback clientDisconnectCallback
 )
-    : ServerInterface(cfg, receiveCallback, clientConnectCallback, clientDisconnectCallback),
-      acceptor_(io_context_),
-      socket_(io_context_) {}
+    : ServerInterface(cfg, receiveCallback, clientConnectCallback, clientDisconnectCallback) {}
 
 TcpServerAsio::~TcpServerAsio() {
     gracefull_shutdown();
@@ -16,51 +17,102 @@ TcpServerAsio::~TcpServerAsio() {
 
 // Listen and start the server
 Error TcpServerAsio::listen() {
+    if (cfg_.threads < 1) {
+        return *Error()
+                    .set_code(ErrorCode::CONFIGURATION_ERROR)
+                    ->set_message("threads must be >= 1");
+    }
+
+    ssl_context_.reset();
+    tls_.reset();
+    if (!cfg_.ssl_config.public_key.empty()) {
+        tls_ = std::make_unique<TlsContext>();
+        Error err = tls_->init_server(cfg_.ssl_config);
+        if (err.code() != ErrorCode::NO_ERROR) {
+            tls_.reset();
+            return err;
+        }
+        ssl_context_ = std::make_unique<asio::ssl::context>(make_asio_context(*tls_));
+    }
+
+    const bool per_thread = cfg_.asio_execution == ServerConfig::AsioExecution::CONTEXT_PER_THREAD;
+    const int context_count = per_thread ? cfg_.threads : 1;
+
+    contexts_.clear();
+    work_.clear();
+    for (int i = 0; i < context_count; ++i) {
+        contexts_.push_back(std::make_unique<asio::io_context>(per_thread ? 1 : cfg_.threads));
+        work_.push_back(asio::make_work_guard(*contexts_.back()));
+    }
+
     try {
+        acceptor_ = std::make_unique<asio::ip::tcp::acceptor>(*contexts_.front());
         asio::ip::tcp::endpoint endpoint(asio::ip::tcp::v4(), cfg_.port);
-        acceptor_.open(endpoint.protocol());
-        acceptor_.set_option(asio::ip::tcp::acceptor::reuse_address(true));
-        acceptor_.bind(endpoint);
-        acceptor_.listen();
-        running_ = true;
-        do_accept();
-
-        io_thread_ = std::thread([this]() {
-            io_context_.run();
-        });
-        return Error();
+        acceptor_->open(endpoint.protocol());
+        acceptor_->set_option(asio::ip::tcp::acceptor::reuse_address(true));
+        cfg_.socket_options.apply(acceptor_->native_handle());
+        acceptor_->bind(endpoint);
+        acceptor_->listen();
     } catch (const std::exception& ex) {
+        acceptor_.reset();
+        work_.clear();
+        contexts_.clear();
         return *Error().set_code(ErrorCode::PORT_IN_USE)->set_message(ex.what());
     }
+
+    running_ = true;
+    do_accept();
+
+    for (int i = 0; i < cfg_.threads; ++i) {
+        asio::io_context* io = contexts_[per_thread ? i : 0].get();
+        io_threads_.emplace_back([io]() {
+            io->run();
+        });
+    }
+    return Error();
 }
 
 // Send data to client by "fd" (Here, fd is actually the internal connection id)
 Error TcpServerAsio::send(int fd, const std::vector<uint8_t>& data) {
-    std::lock_guard<std::mutex> lock(connections_mutex_);
-    auto it = connections_.find(fd);
-    if (it == connections_.end()) {
+    auto session = find_session(fd);
+    if (!session) {
         return *Error().set_code(ErrorCode::NOT_CONNECTED)->set_message("Connection not found.");
     }
-    auto sock = it->second;
-    auto buf = std::make_shared<std::vector<uint8_t>>(data);
-
-    asio::async_write(
-        *sock, asio::buffer(*buf),
-        [buf](std::error_code /*ec*/, std::size_t /*bytes_transferred*/) {
-            // handle errors/logging here if required
-        });
-    return Error();
+    return enqueue(session, data);
 }
 
 // Send data to client by IP (send to first matching IP)
 Error TcpServerAsio::send(const std::string& ip, const std::vector<uint8_t>& data) {
-    std::lock_guard<std::mutex> lock(connections_mutex_);
-    for (const auto& kv : connections_ip_) {
-        if (kv.second == ip) {
-            return send(kv.first, data);
+    std::shared_ptr<Session> session;
+    {
+        RegistryShard& shard = ip_shard(ip);
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.by_ip.find(ip);
+        if (it != shard.by_ip.end()) {
+            session = it->second.front();
         }
     }
-    return *Error().set_code(ErrorCode::NOT_CONNECTED)->set_message("IP not found.");
+    if (!session) {
+        return *Error().set_code(ErrorCode::NOT_CONNECTED)->set_message("IP not found.");
+    }
+    return enqueue(session, data);
+}
+
+size_t TcpServerAsio::queued_bytes(int fd) {
+    auto session = find_session(fd);
+    return session ? session->queued_bytes.load() : 0;
+}
+
+Error TcpServerAsio::session_stats(int fd, SessionStats& out) {
+    auto session = find_session(fd);
+    if (!session) {
+        return *Error().set_code(ErrorCode::NOT_CONNECTED)->set_message("Connection not found.");
+    }
+    out.ip = session->ip;
+    out.queued_bytes = session->queued_bytes;
+    out.bytes_received = session->bytes_received;
+    out.bytes_sent = session->bytes_sent;
+    return Error();
 }
 
 Error TcpServerAsio::gracefull_shutdown() {
@@ -69,74 +121,322 @@ Error TcpServerAsio::gracefull_shutdown() {
 
     running_ = false;
     try {
-        {
-            std::lock_guard<std::mutex> lock(connections_mutex_);
-            for (auto& kv : connections_) {
+        // Stop the loops first; with no thread left inside a handler the sockets can be
+        // closed from here
+        stop_threads();
+
+        asio::error_code ignored_ec;
+        if (acceptor_)
+            acceptor_->close(ignored_ec);
+        for (auto& shard : registry_) {
+            std::unique_lock<std::shared_mutex> lock(shard.mutex);
+            for (auto& kv : shard.by_id) {
                 asio::error_code ec;
-                kv.second->shutdown(asio::ip::tcp::socket::shutdown_both, ec);
-                kv.second->close(ec);
+                kv.second->socket.shutdown(asio::ip::tcp::socket::shutdown_both, ec);
+                kv.second->socket.close(ec);
             }
-            connections_.clear();
-            connections_ip_.clear();
-        }
-        asio::error_code ignored_ec;
-        acceptor_.close(ignored_ec);
-        socket_.close(ignored_ec);
-        io_context_.stop();
-        if (io_thread_.joinable()) {
-            io_thread_.join();
+            shard.by_id.clear();
+            shard.by_ip.clear();
         }
+        acceptor_.reset();
+        contexts_.clear();
         return Error();
     } catch (const std::exception& ex) {
         return *Error().set_code(ErrorCode::DISCONNECTION_FAILED)->set_message(ex.what());
     }
 }
 
-void TcpServerAsio::do_accept() {
-    acceptor_.async_accept(socket_, [this](std::error_code ec) {
-        if (!running_) return;
-
-        if (!ec) {
-            int conn_id = next_conn_id_++;
-            auto new_socket = std::make_shared<asio::ip::tcp::socket>(std::move(socket_));
-            std::string client_ip = new_socket->remote_endpoint().address().to_string();
-            {
-                std::lock_guard<std::mutex> lock(connections_mutex_);
-                connections_[conn_id] = new_socket;
-                connections_ip_[conn_id] = client_ip;
-            }
-            if (clientConnectionCallback_) {
-                clientConnectionCallback_(conn_id, client_ip);
-            }
-            do_read(conn_id, new_socket, client_ip);
+void TcpServerAsio::stop_threads() {
+    work_.clear();
+    for (auto& io : contexts_) {
+        io->stop();
+    }
+    for (auto& t : io_threads_) {
+        if (t.joinable()) {
+            t.join();
         }
-        if (running_) {
-            do_accept();
+    }
+    io_threads_.clear();
+}
+
+void TcpServerAsio::do_accept() {
+    if (cfg_.asio_execution == ServerConfig::AsioExecution::CONTEXT_PER_THREAD) {
+        // Round-robin: the accepted socket belongs to the next context in the pool
+        unsigned i = next_context_++ % contexts_.size();
+        acceptor_->async_accept(*contexts_[i],
+                                [this](std::error_code ec, asio::ip::tcp::socket socket) {
+                                    on_accept(ec, std::move(socket));
+                                });
+    } else {
+        // Every connection gets its own strand on the shared context
+        acceptor_->async_accept(asio::make_strand(*contexts_.front()),
+                                [this](std::error_code ec, asio::ip::tcp::socket socket) {
+                                    on_accept(ec, std::move(socket));
+                                });
+    }
+}
+
+void TcpServerAsio::on_accept(std::error_code ec, asio::ip::tcp::socket socket) {
+    if (!running_) return;
+
+    if (!ec) {
+        cfg_.socket_options.apply(socket.native_handle());
+        asio::error_code ep_ec;
+        auto endpoint = socket.remote_endpoint(ep_ec);
+        std::string client_ip = ep_ec ? std::string() : endpoint.address().to_string();
+
+        auto session = std::make_shared<Session>(next_conn_id_++, std::move(socket), client_ip,
+                                                 ssl_context_.get());
+        if (!session->tls) {
+            start_session(session);
+        } else {
+            // Handshake on the connection's executor; a failed one closes it unannounced
+            asio::post(session->socket.get_executor(), [this, session]() {
+                session->tls->async_handshake(
+                    asio::ssl::stream_base::server,
+                    bind_arena(session->arena, [this, session](std::error_code ec) {
+                        if (ec) {
+                            asio::error_code ignored;
+                            session->socket.close(ignored);
+                            return;
+                        }
+                        tls_->on_handshake(session->tls->native_handle());
+                        start_session(session);
+                    }));
+            });
         }
-    });
+    }
+    if (running_) {
+        do_accept();
+    }
 }
 
-void TcpServerAsio::do_read(int conn_id, std::shared_ptr<asio::ip::tcp::socket> sock, std::string client_ip) {
-    auto buf = std::make_shared<std::vector<uint8_t>>(4096);
-    sock->async_receive(
-        asio::buffer(*buf),
-        [this, sock, buf, conn_id, client_ip](std::error_code ec, std::size_t bytes_transferred) {
+void TcpServerAsio::start_session(const std::shared_ptr<Session>& session) {
+    add_session(session);
+    if (clientConnectionCallback_) {
+        clientConnectionCallback_(session->id, session->ip);
+    }
+    if (sessionHandler_) {
+        asio::co_spawn(session->socket.get_executor(),
+                       sessionHandler_(SessionStream(this, session)),
+                       [this, session](std::exception_ptr) {
+                           close_session(session);
+                       });
+    } else {
+        // Start reading on the connection's own executor
+        asio::post(session->socket.get_executor(), [this, session]() {
+            do_read(session);
+        });
+    }
+}
+
+void TcpServerAsio::add_session(const std::shared_ptr<Session>& session) {
+    {
+        RegistryShard& shard = id_shard(session->id);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        shard.by_id[session->id] = session;
+    }
+    RegistryShard& shard = ip_shard(session->ip);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    shard.by_ip[session->ip].push_back(session);
+}
+
+void TcpServerAsio::remove_session(const std::shared_ptr<Session>& session) {
+    {
+        RegistryShard& shard = id_shard(session->id);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        shard.by_id.erase(session->id);
+    }
+    RegistryShard& shard = ip_shard(session->ip);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.by_ip.find(session->ip);
+    if (it == shard.by_ip.end()) {
+        return;
+    }
+    auto& sessions = it->second;
+    sessions.erase(std::remove(sessions.begin(), sessions.end(), session), sessions.end());
+    if (sessions.empty()) {
+        shard.by_ip.erase(it);
+    }
+}
+
+std::shared_ptr<TcpServerAsio::Session> TcpServerAsio::find_session(int id) {
+    RegistryShard& shard = id_shard(id);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.by_id.find(id);
+    return it == shard.by_id.end() ? nullptr : it->second;
+}
+
+Error TcpServerAsio::enqueue(const std::shared_ptr<Session>& session,
+                             const std::vector<uint8_t>& data) {
+    session->queued_bytes += data.size();
+
+    auto msg = buffer_pool::acquire(data.size());
+    std::copy(data.begin(), data.end(), msg.data());
+
+    // The socket and its queue are only ever used from its own executor
+    asio::post(session->socket.get_executor(),
+               bind_arena(session->arena, [this, session, msg = std::move(msg)]() mutable {
+                   session->queue.push_back(std::move(msg));
+                   if (!session->writing) {
+                       do_write(session);
+                   }
+               }));
+    return Error();
+}
+
+void TcpServerAsio::do_read(std::shared_ptr<Session> session) {
+    session->read_buffer.resize(kReadBufferSize);
+    auto on_read =
+        bind_arena(session->arena, [this, session](std::error_code ec,
+                                                   std::size_t bytes_transferred) {
             if (!ec && bytes_transferred > 0) {
-                buf->resize(bytes_transferred);
+                cfg_.socket_options.rearm_quickack(session->socket.native_handle());
+                session->bytes_received += bytes_transferred;
+                session->read_buffer.resize(bytes_transferred);
                 if (recieveCallback_) {
-                    recieveCallback_(conn_id, client_ip, *buf);
+                    recieveCallback_(session->id, session->ip, session->read_buffer.vec());
                 }
-                do_read(conn_id, sock, client_ip);
+                do_read(session);
             } else {
                 // Connection closed or error
-                {
-                    std::lock_guard<std::mutex> lock(connections_mutex_);
-                    connections_.erase(conn_id);
-                    connections_ip_.erase(conn_id);
-                }
+                remove_session(session);
                 if (clientDisconnectCallback_) {
-                    clientDisconnectCallback_(conn_id, client_ip);
+                    clientDisconnectCallback_(session->id, session->ip);
+                }
+            }
+        });
+    session->with_stream([&](auto& stream) {
+        stream.async_read_some(asio::buffer(session->read_buffer.vec()), std::move(on_read));
+    });
+}
+
+void TcpServerAsio::do_write(std::shared_ptr<Session> session) {
+    // Everything queued so far goes out in one gathered write, in send() order
+    session->writing = true;
+    session->inflight.assign(std::make_move_iterator(session->queue.begin()),
+                             std::make_move_iterator(session->queue.end()));
+    session->queue.clear();
+
+    session->inflight_buffers.clear();
+    for (const auto& chunk : session->inflight) {
+        session->inflight_buffers.push_back(asio::buffer(chunk.vec()));
+    }
+
+    auto on_write =
+        bind_arena(session->arena, [this, session](std::error_code ec,
+                                                   std::size_t bytes_transferred) {
+            session->bytes_sent += bytes_transferred;
+
+            size_t done = 0;
+            for (const auto& chunk : session->inflight) {
+                done += chunk.size();
+            }
+            session->inflight.clear();
+            session->inflight_buffers.clear();
+
+            if (ec) {
+                // The read side reports the disconnect; drop what can no longer be sent
+                done += discard_queue(*session);
+            }
+            session->queued_bytes -= done;
+
+            if (!ec && !session->queue.empty()) {
+                do_write(session);
+            } else {
+                session->writing = false;
+                if (session->close_after_write) {
+                    close_session(session);
                 }
             }
         });
+
+    // A span keeps asio from copying the buffer vector into the write operation
+    session->with_stream([&](auto& stream) {
+        asio::async_write(stream, std::span<const asio::const_buffer>(session->inflight_buffers),
+                          std::move(on_write));
+    });
+}
+
+size_t TcpServerAsio::discard_queue(Session& session) {
+    size_t dropped = 0;
+    for (const auto& chunk : session.queue) {
+        dropped += chunk.size();
+    }
+    session.queue.clear();
+    return dropped;
+}
+
+void TcpServerAsio::close_session(const std::shared_ptr<Session>& session) {
+    if (session->writing) {
+        // Let the queued sends go out first; the write completion comes back here
+        session->close_after_write = true;
+        return;
+    }
+    asio::error_code ec;
+    session->socket.shutdown(asio::ip::tcp::socket::shutdown_both, ec);
+    session->socket.close(ec);
+    remove_session(session);
+    if (clientDisconnectCallback_) {
+        clientDisconnectCallback_(session->id, session->ip);
+    }
+}
+
+// ====================== Session coroutines ======================
+
+int TcpServerAsio::SessionStream::id() const {
+    return session_->id;
+}
+
+const std::string& TcpServerAsio::SessionStream::ip() const {
+    return session_->ip;
+}
+
+asio::awaitable<Error> TcpServerAsio::SessionStream::receive(std::vector<uint8_t>& out,
+                                                             size_t max_bytes) {
+    asio::error_code ec;
+    out.resize(max_bytes);
+    std::size_t n = co_await session_->with_stream([&](auto& stream) {
+        return stream.async_read_some(asio::buffer(out),
+                                      asio::redirect_error(asio::use_awaitable, ec));
+    });
+    if (ec) {
+        out.clear();
+        co_return *Error().set_code(ErrorCode::DISCONNECTED)->set_message("Connection closed");
+    }
+    server_->cfg_.socket_options.rearm_quickack(session_->socket.native_handle());
+    session_->bytes_received += n;
+    out.resize(n);
+    co_return Error();
+}
+
+asio::awaitable<Error> TcpServerAsio::SessionStream::send(std::span<const uint8_t> data) {
+    Session& session = *session_;
+    session.queued_bytes += data.size();
+
+    if (session.writing) {
+        auto msg = buffer_pool::acquire(data.size());
+        std::copy(data.begin(), data.end(), msg.data());
+        session.queue.push_back(std::move(msg));
+        co_return Error();
+    }
+
+    // Sends posted meanwhile see writing set and queue up behind this write
+    session.writing = true;
+    asio::error_code ec;
+    std::size_t n = co_await session.with_stream([&](auto& stream) {
+        return asio::async_write(stream, asio::buffer(data.data(), data.size()),
+                                 asio::redirect_error(asio::use_awaitable, ec));
+    });
+    session.bytes_sent += n;
+    session.queued_bytes -= data.size() + (ec ? discard_queue(session) : 0);
+    session.writing = false;
+
+    if (ec) {
+        co_return *Error().set_code(ErrorCode::SEND_FAILED)->set_message("Send failed");
+    }
+    if (!session.queue.empty()) {
+        server_->do_write(session_);
+    }
+    co_return Error();
 }
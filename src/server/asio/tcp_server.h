@@ -1,19 +1,77 @@
 #pragma once
 
 #include <asio.hpp>
+#include <array>
 #include <atomic>
+#include <deque>
+#include <functional>
 #include <memory>
+#include <shared_mutex>
+#include <span>
 #include <string>
 #include <thread>
 #include <unordered_map>
 #include <vector>
 
+#include "buffer/buffer_pool.h"
+#include "buffer/handler_arena.h"
 #include "error.h"
 #include "server/server_interface.h"
+#include "tls/asio_tls.h"
 
 // ASIO TCP Server implementation inheriting from ServerInterface
+//
+// Runs cfg.threads I/O threads as described by ServerConfig::AsioExecution. Either way all
+// handlers of one connection are serialised (own io_context or own strand), and sends are
+// posted to the connection's executor rather than touching its socket from the caller.
+// There they join an ordered queue: one write is in flight per connection, and whatever
+// queued up meanwhile leaves in the next scatter/gather write.
+//
+// Connections are Session objects kept in a sharded registry; sends only take a shared
+// lock on one shard to find their session, so application threads rarely contend.
+//
+// With a session handler set, each connection is served by a coroutine instead of the
+// receive callback; see set_session_handler().
+//
+// With ssl_config.public_key set, connections run TLS. The connect callback (and the session
+// handler) only see connections whose handshake succeeded.
 class TcpServerAsio : public ServerInterface {
+    struct Session;
+
   public:
+    // A connection as seen from its session handler coroutine. Its operations run on the
+    // connection's executor and must only be awaited from that coroutine.
+    class SessionStream {
+      public:
+        int id() const;
+        const std::string& ip() const;
+
+        // Next chunk of the byte stream, at most max_bytes, into out (resized to the bytes
+        // read). DISCONNECTED once the client has gone.
+        asio::awaitable<Error> receive(std::vector<uint8_t>& out, size_t max_bytes = 4096);
+
+        // Completes once data is written. While send() traffic for this connection is in
+        // flight, data is copied into the queue behind it instead, keeping the order.
+        asio::awaitable<Error> send(std::span<const uint8_t> data);
+
+      private:
+        friend class TcpServerAsio;
+        SessionStream(TcpServerAsio* server, std::shared_ptr<Session> session)
+            : server_(server), session_(std::move(session)) {}
+
+        TcpServerAsio* server_;
+        std::shared_ptr<Session> session_;
+    };
+
+    using SessionHandler = std::function<asio::awaitable<void>(SessionStream)>;
+
+    struct SessionStats {
+        std::string ip;
+        size_t queued_bytes = 0;
+        uint64_t bytes_received = 0;
+        uint64_t bytes_sent = 0;
+    };
+
     TcpServerAsio(ServerConfig cfg, ReceiveCallback receiveCallback,
                   ClientConnectCallback clientConnectCallback,
                   ClientDisconnectCallback clientDisconnectCallback);
@@ -26,23 +84,111 @@ class TcpServerAsio : public ServerInterface {
     // Send data to client by "fd" (Here, fd is actually the internal connection id)
     Error send(int fd, const std::vector<uint8_t>& data) override;
 
+    // Bytes accepted by send() for this connection and not yet written to the socket,
+    // for callers that want to apply backpressure. 0 for unknown connections.
+    size_t queued_bytes(int fd);
+
+    // Snapshot of a connection's counters, NOT_CONNECTED for unknown ids
+    Error session_stats(int fd, SessionStats& out);
+
     // Send data to client by IP (send to first matching IP)
     Error send(const std::string& ip, const std::vector<uint8_t>& data) override;
 
+    // Serve every connection accepted from now on with handler, spawned on the connection's
+    // executor, instead of the receive callback. The connect callback still runs first.
+    // When the coroutine returns the connection is closed once queued sends are written,
+    // and the disconnect callback runs. Set it before listen().
+    void set_session_handler(SessionHandler handler) { sessionHandler_ = std::move(handler); }
+
     Error gracefull_shutdown() override;
 
+    // Handshake counters; all zero without TLS
+    TlsContext::Stats tls_stats() const { return tls_ ? tls_->stats() : TlsContext::Stats{}; }
+
   private:
+    using WorkGuard = asio::executor_work_guard<asio::io_context::executor_type>;
+
+    // One accepted connection. Socket, read buffer and write queue are only touched on the
+    // socket's executor; the counters may be read from any thread. Queued messages are held
+    // in pooled buffers and the session's handlers allocate from its arena, so a steady
+    // read/write loop does not reach the heap.
+    struct Session {
+        Session(int id, asio::ip::tcp::socket s, std::string ip, asio::ssl::context* ssl)
+            : id(id),
+              ip(std::move(ip)),
+              socket(std::move(s)),
+              tls(ssl ? std::make_unique<AsioTlsStream>(socket, *ssl) : nullptr),
+              read_buffer(buffer_pool::acquire(kReadBufferSize)) {}
+
+        // Runs f on the TLS stream when TLS is on, on the plain socket otherwise
+        template <typename F>
+        decltype(auto) with_stream(F&& f) {
+            if (tls)
+                return f(*tls);
+            return f(socket);
+        }
+
+        const int id;
+        const std::string ip;
+        asio::ip::tcp::socket socket;
+        std::unique_ptr<AsioTlsStream> tls;
+        buffer_pool::Buffer read_buffer;  // back to the pool with the session
+
+        HandlerArena arena;
+
+        std::deque<buffer_pool::Buffer> queue;
+        std::vector<buffer_pool::Buffer> inflight;
+        std::vector<asio::const_buffer> inflight_buffers;
+        bool writing = false;
+        bool close_after_write = false;  // the session handler is done
+
+        std::atomic<size_t> queued_bytes{0};
+        std::atomic<uint64_t> bytes_received{0};
+        std::atomic<uint64_t> bytes_sent{0};
+    };
+
+    // Sessions are filed under their id's shard, and under their address's shard for
+    // send(ip). The two locks are never held together.
+    struct RegistryShard {
+        std::shared_mutex mutex;
+        std::unordered_map<int, std::shared_ptr<Session>> by_id;
+        std::unordered_map<std::string, std::vector<std::shared_ptr<Session>>> by_ip;
+    };
+
+    RegistryShard& id_shard(int id) { return registry_[unsigned(id) % kRegistryShards]; }
+    RegistryShard& ip_shard(const std::string& ip) {
+        return registry_[std::hash<std::string>{}(ip) % kRegistryShards];
+    }
+    void add_session(const std::shared_ptr<Session>& session);
+    void remove_session(const std::shared_ptr<Session>& session);
+    std::shared_ptr<Session> find_session(int id);
+    Error enqueue(const std::shared_ptr<Session>& session, const std::vector<uint8_t>& data);
+
     void do_accept();
-    void do_read(int conn_id, std::shared_ptr<asio::ip::tcp::socket> sock, std::string client_ip);
+    void on_accept(std::error_code ec, asio::ip::tcp::socket socket);
+    void start_session(const std::shared_ptr<Session>& session);
+    void do_read(std::shared_ptr<Session> session);
+    void do_write(std::shared_ptr<Session> session);
+    static size_t discard_queue(Session& session);
+    void close_session(const std::shared_ptr<Session>& session);
+    void stop_threads();
 
   private:
-    asio::io_context io_context_;
-    asio::ip::tcp::acceptor acceptor_;
-    asio::ip::tcp::socket socket_;
-    std::thread io_thread_;
+    // Declared first so that sessions, also those owned by pending handlers, go before them
+    std::unique_ptr<TlsContext> tls_;
+    std::unique_ptr<asio::ssl::context> ssl_context_;
+
+    std::vector<std::unique_ptr<asio::io_context>> contexts_;  // one, or one per thread
+    std::vector<WorkGuard> work_;
+    std::vector<std::thread> io_threads_;
+    std::unique_ptr<asio::ip::tcp::acceptor> acceptor_;
+    std::atomic<unsigned> next_context_{0};
+
+    static constexpr size_t kReadBufferSize = 4096;
+    static constexpr size_t kRegistryShards = 16;
+
+    SessionHandler sessionHandler_;
 
     std::atomic<int> next_conn_id_{1};
-    std::unordered_map<int, std::shared_ptr<asio::ip::tcp::socket>> connections_;
-    std::unordered_map<int, std::string> connections_ip_;
-    std::mutex connections_mutex_;
+    std::array<RegistryShard, kRegistryShards> registry_;
 };
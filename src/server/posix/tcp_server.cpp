@@ -1,34 +1,167 @@
 #include "tcp_server.h"
 
-#include <algorithm>
+#include <linux/filter.h>
+#include <openssl/err.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include <sys/sendfile.h>
+
+#include <climits>
 #include <cstring>
 #include <iostream>
 
 #include "error.h"
 
+namespace {
+    thread_local int current_shard_index = -1;
+}
+
+int TcpServer::current_shard() {
+    return current_shard_index;
+}
+
+TcpServer::ClientInfo& TcpServer::Shard::insert(int fd, const std::string& ip) {
+    if (size_t(fd) >= slots.size())
+        slots.resize(fd + 1);
+
+    slots[fd] = std::make_unique<ClientInfo>();
+    ClientInfo& c = *slots[fd];
+    c.fd = fd;
+    c.ip = ip;
+    c.live_index = live.size();
+    live.push_back(fd);
+    by_ip[ip].push_back(fd);
+    return c;
+}
+
+std::unique_ptr<TcpServer::ClientInfo> TcpServer::Shard::erase(int fd) {
+    if (!find(fd))
+        return nullptr;
+    std::unique_ptr<ClientInfo> c = std::move(slots[fd]);
+
+    // Swap-remove from the dense list and the per-address bucket
+    int moved = live.back();
+    live[c->live_index] = moved;
+    if (moved != fd)
+        slots[moved]->live_index = c->live_index;
+    live.pop_back();
+
+    auto it = by_ip.find(c->ip);
+    if (it != by_ip.end()) {
+        std::vector<int>& fds = it->second;
+        for (size_t i = 0; i < fds.size(); ++i) {
+            if (fds[i] == fd) {
+                fds[i] = fds.back();
+                fds.pop_back();
+                break;
+            }
+        }
+        if (fds.empty())
+            by_ip.erase(it);
+    }
+    return c;
+}
+
 Error TcpServer::listen() {
     // Clear old clients on restart
-    for (auto client : clients_) close(client.fd);
-    clients_.clear();
+    close_shards();
+
+    if (cfg_.threads < 1) {
+        Error err;
+        err.set_code(ErrorCode::CONFIGURATION_ERROR)->set_message("threads must be >= 1");
+        return err;
+    }
+
+    tls_.reset();
+    if (!cfg_.ssl_config.public_key.empty()) {
+        tls_ = std::make_unique<TlsContext>();
+        Error err = tls_->init_server(cfg_.ssl_config);
+        if (err.code() != ErrorCode::NO_ERROR) {
+            tls_.reset();
+            return err;
+        }
+    }
+
+    for (int i = 0; i < cfg_.threads; ++i) {
+        auto shard = std::make_unique<Shard>();
+        shard->index = i;
+
+        Error err = open_listener(*shard);
+        shard->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (err.code() == ErrorCode::NO_ERROR && shard->wake_fd < 0)
+            err.set_code(ErrorCode::INTERNAL_ERROR)->set_message("Failed to create eventfd");
+        if (err.code() == ErrorCode::NO_ERROR && uses_epoll())
+            err = setup_epoll(*shard);
+
+        shards_.push_back(std::move(shard));
+        if (err.code() != ErrorCode::NO_ERROR) {
+            close_shards();
+            return err;
+        }
+    }
+
+    if (cfg_.cpu_steering && shards_.size() > 1) {
+        Error err = attach_cpu_steering();
+        if (err.code() != ErrorCode::NO_ERROR)
+            std::cerr << "[SERVER] " << err.message() << ", using kernel hash distribution"
+                      << std::endl;
+    }
 
-    server_fd_ = socket(AF_INET, SOCK_STREAM, 0);
-    if (server_fd_ < 0) {
+    running_ = true;
+    stop_ = false;
+
+    // Run one event loop per shard in a background thread
+    const unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+    for (auto& shard : shards_) {
+        Shard* s = shard.get();
+        s->worker = std::thread([this, s]() { this->run(*s); });
+
+        if (cfg_.cpu_steering) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(s->index % cpus, &set);
+            pthread_setaffinity_np(s->worker.native_handle(), sizeof(set), &set);
+        } else if (cfg_.busy_poll.enabled) {
+            cfg_.busy_poll.pin(s->worker, s->index);
+        }
+    }
+
+    Error ok;
+    ok.set_code(ErrorCode::NO_ERROR);
+    return ok;
+}
+
+Error TcpServer::open_listener(Shard& shard) {
+    shard.listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (shard.listen_fd < 0) {
         Error err;
         err.set_code(ErrorCode::CONNECTION_FAILED)->set_message("Failed to create TCP socket");
         return err;
     }
 
-    fcntl(server_fd_, F_SETFL, O_NONBLOCK);
+    fcntl(shard.listen_fd, F_SETFL, O_NONBLOCK);
 
     int opt = 1;
-    setsockopt(server_fd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    setsockopt(shard.listen_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    if (cfg_.threads > 1) {
+        // Every shard binds the same port; the kernel load-balances between the listeners
+        setsockopt(shard.listen_fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt));
+
+        if (cfg_.cpu_steering) {
+            const unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+            int cpu = static_cast<int>(shard.index % cpus);
+            setsockopt(shard.listen_fd, SOL_SOCKET, SO_INCOMING_CPU, &cpu, sizeof(cpu));
+        }
+    }
+    cfg_.socket_options.apply(shard.listen_fd);
 
     sockaddr_in addr{};
     addr.sin_family = AF_INET;
     addr.sin_addr.s_addr = INADDR_ANY;
     addr.sin_port = htons(cfg_.port);
 
-    if (::bind(server_fd_, (sockaddr*)&addr, sizeof(addr)) < 0) {
+    if (::bind(shard.listen_fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
         Error err;
         if (errno == EADDRINUSE) {
             err.set_code(ErrorCode::PORT_IN_USE)->set_message("Port is already in use");
@@ -38,42 +171,104 @@ Error TcpServer::listen() {
         return err;
     }
 
-    if (::listen(server_fd_, SOMAXCONN) < 0) {
+    if (::listen(shard.listen_fd, SOMAXCONN) < 0) {
         Error err;
         err.set_code(ErrorCode::CONNECTION_FAILED)->set_message("Listen failed");
         return err;
     }
 
-    running_ = true;
-    stop_ = false;
+    Error ok;
+    return ok;
+}
+
+Error TcpServer::setup_epoll(Shard& shard) {
+    shard.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (shard.epoll_fd < 0) {
+        Error err;
+        err.set_code(ErrorCode::INTERNAL_ERROR)->set_message("Failed to create epoll instance");
+        return err;
+    }
+
+    // The listening socket is edge-triggered: accept_new_client() drains the backlog
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLET;
+    ev.data.fd = shard.listen_fd;
+    if (epoll_ctl(shard.epoll_fd, EPOLL_CTL_ADD, shard.listen_fd, &ev) < 0) {
+        Error err;
+        err.set_code(ErrorCode::INTERNAL_ERROR)->set_message("Failed to register listen socket");
+        return err;
+    }
 
-    // Run the select-based event loop in a background thread
-    worker_ = std::thread([this]() { this->run(); });
+    ev.events = EPOLLIN;
+    ev.data.fd = shard.wake_fd;
+    epoll_ctl(shard.epoll_fd, EPOLL_CTL_ADD, shard.wake_fd, &ev);
 
     Error ok;
-    ok.set_code(ErrorCode::NO_ERROR);
     return ok;
 }
 
-void TcpServer::run() {
+Error TcpServer::attach_cpu_steering() {
+    // Socket index within the reuseport group follows listen() order, i.e. the shard
+    // index, so "receiving cpu % shards" selects the shard pinned to that cpu.
+    sock_filter code[] = {
+        {BPF_LD | BPF_W | BPF_ABS, 0, 0, static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU)},
+        {BPF_ALU | BPF_MOD | BPF_K, 0, 0, static_cast<uint32_t>(shards_.size())},
+        {BPF_RET | BPF_A, 0, 0, 0},
+    };
+    sock_fprog prog{};
+    prog.len = sizeof(code) / sizeof(code[0]);
+    prog.filter = code;
+
+    if (setsockopt(shards_.front()->listen_fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog,
+                   sizeof(prog)) < 0) {
+        Error err;
+        err.set_code(ErrorCode::CONFIGURATION_ERROR)
+            ->set_message(std::string("SO_ATTACH_REUSEPORT_CBPF failed: ") + strerror(errno));
+        return err;
+    }
+
+    Error ok;
+    return ok;
+}
+
+void TcpServer::run(Shard& shard) {
+    current_shard_index = shard.index;
+
+    if (uses_epoll())
+        run_epoll(shard);
+    else
+        run_select(shard);
+}
+
+void TcpServer::run_select(Shard& shard) {
     while (running_ && !stop_) {
         fd_set readfds;
+        fd_set writefds;
         FD_ZERO(&readfds);
-
-        FD_SET(server_fd_, &readfds);
-        int max_fd = server_fd_;
-
-        for (auto c : clients_) {
-            FD_SET(c.fd, &readfds);
-            if (c.fd > max_fd)
-                max_fd = c.fd;
+        FD_ZERO(&writefds);
+
+        FD_SET(shard.listen_fd, &readfds);
+        FD_SET(shard.wake_fd, &readfds);
+        int max_fd = std::max(shard.listen_fd, shard.wake_fd);
+
+        {
+            // Write queues are appended by other threads; they wake us through wake_fd
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            for (int fd : shard.live) {
+                FD_SET(fd, &readfds);
+                const ClientInfo& c = *shard.slots[fd];
+                if (!c.outq.empty() || c.read_wants_write)
+                    FD_SET(fd, &writefds);
+                if (fd > max_fd)
+                    max_fd = fd;
+            }
         }
 
         timeval tv{};
         tv.tv_sec = 0;
         tv.tv_usec = 200000;  // 200 ms
 
-        int activity = select(max_fd + 1, &readfds, nullptr, nullptr, &tv);
+        int activity = select(max_fd + 1, &readfds, &writefds, nullptr, &tv);
         if (activity < 0) {
             // If we are shutting down, select can fail due to closed fds
             if (stop_)
@@ -81,11 +276,67 @@ void TcpServer::run() {
             continue;
         }
 
-        if (FD_ISSET(server_fd_, &readfds)) {
-            accept_new_client();
+        if (FD_ISSET(shard.wake_fd, &readfds)) {
+            uint64_t value;
+            [[maybe_unused]] ssize_t n = read(shard.wake_fd, &value, sizeof(value));
+        }
+
+        if (FD_ISSET(shard.listen_fd, &readfds)) {
+            accept_new_client(shard);
+        }
+
+        handle_client_io(shard, readfds, writefds);
+    }
+}
+
+void TcpServer::run_epoll(Shard& shard) {
+    std::vector<epoll_event> events(kMaxEpollEvents);
+    BusySpinner spinner(cfg_.busy_poll);
+
+    while (running_ && !stop_) {
+        int n = epoll_wait(shard.epoll_fd, events.data(), kMaxEpollEvents,
+                           spinner.timeout_ms(200));
+        spinner.update(n > 0);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            if (stop_)
+                break;
+            continue;
         }
 
-        handle_client_io(readfds);
+        for (int i = 0; i < n; ++i) {
+            int fd = events[i].data.fd;
+
+            if (fd == shard.wake_fd)
+                continue;  // shutdown request, loop condition handles it
+
+            if (fd == shard.listen_fd) {
+                accept_new_client(shard);
+                continue;
+            }
+
+            ClientInfo* c = shard.find(fd);
+            if (!c)
+                continue;
+
+            const uint32_t ev = events[i].events;
+            const bool readable = ev & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR);
+            if (c->ssl) {
+                if (!service_tls_client(shard, *c, readable, ev & EPOLLOUT))
+                    remove_client(shard, fd);
+                continue;
+            }
+
+            if ((ev & EPOLLOUT) && !flush_client(shard, fd)) {
+                remove_client(shard, fd);
+                continue;
+            }
+
+            // Edge-triggered: read until EAGAIN; EPOLLHUP/EPOLLERR surface as recv() <= 0
+            if (readable && !drain_client(shard, *c))
+                remove_client(shard, fd);
+        }
     }
 }
 
@@ -93,109 +344,468 @@ Error TcpServer::gracefull_shutdown() {
     stop_ = true;
     running_ = false;
 
-    if (server_fd_ >= 0) {
-        close(server_fd_);
-        server_fd_ = -1;
-    }
-
-    for (auto c : clients_) {
-        close(c.fd);
+    for (auto& shard : shards_) {
+        if (shard->wake_fd >= 0) {
+            uint64_t one = 1;
+            [[maybe_unused]] ssize_t n = write(shard->wake_fd, &one, sizeof(one));
+        }
     }
-    clients_.clear();
 
-    if (worker_.joinable())
-        worker_.join();
+    close_shards();
 
     Error ok;
     ok.set_code(ErrorCode::NO_ERROR);
     return ok;
 }
 
-void TcpServer::accept_new_client() {
+void TcpServer::close_shards() {
+    // Join before closing so no loop touches a descriptor we released
+    for (auto& shard : shards_) {
+        if (shard->worker.joinable())
+            shard->worker.join();
+    }
+
+    for (auto& shard : shards_) {
+        if (shard->listen_fd >= 0)
+            close(shard->listen_fd);
+        for (int fd : shard->live) close(fd);
+        if (shard->epoll_fd >= 0)
+            close(shard->epoll_fd);
+        if (shard->wake_fd >= 0)
+            close(shard->wake_fd);
+    }
+    shards_.clear();
+}
+
+void TcpServer::accept_new_client(Shard& shard) {
+    const bool use_epoll = uses_epoll();
+
     while (true) {
         sockaddr_in client_addr;
         socklen_t client_len = sizeof(client_addr);
-        int client_fd = accept(server_fd_, reinterpret_cast<sockaddr*>(&client_addr), &client_len);
+        int client_fd = accept4(shard.listen_fd, reinterpret_cast<sockaddr*>(&client_addr),
+                                &client_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
         if (client_fd < 0) {
             if (errno == EAGAIN || errno == EWOULDBLOCK) {
                 // No more clients to accept
                 return;
             }
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
             std::cerr << "[SERVER] accept() failed: " << strerror(errno) << std::endl;
             return;
         }
 
-        fcntl(client_fd, F_SETFL, O_NONBLOCK);
+        // FD_SET on a descriptor >= FD_SETSIZE writes past the fd_set
+        if (!use_epoll && client_fd >= FD_SETSIZE) {
+            std::cerr << "[SERVER] fd " << client_fd
+                      << " exceeds FD_SETSIZE, use EventLoopType::EPOLL" << std::endl;
+            close(client_fd);
+            continue;
+        }
+        cfg_.socket_options.apply(client_fd);
+        cfg_.busy_poll.apply(client_fd);
+
+        if (use_epoll) {
+            epoll_event ev{};
+            // EPOLLOUT is edge-triggered too, so it only fires once a full socket drains
+            ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+            ev.data.fd = client_fd;
+            if (epoll_ctl(shard.epoll_fd, EPOLL_CTL_ADD, client_fd, &ev) < 0) {
+                std::cerr << "[SERVER] epoll_ctl() failed: " << strerror(errno) << std::endl;
+                close(client_fd);
+                continue;
+            }
+        }
 
         char ipstr[INET_ADDRSTRLEN] = {0};
         inet_ntop(AF_INET, &client_addr.sin_addr, ipstr, sizeof(ipstr));
         uint16_t port = ntohs(client_addr.sin_port);
 
         std::cout << "[SERVER] New client accepted: fd=" << client_fd << ", ip=" << ipstr
-                  << ", port=" << port << std::endl;
-
-        clients_.push_back(ClientInfo{.fd = client_fd, .ip = ipstr});
-        clientConnectionCallback_(client_fd, ipstr);
+                  << ", port=" << port << ", shard=" << shard.index << std::endl;
+
+        bool ssl_failed = false;
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            ClientInfo& c = shard.insert(client_fd, ipstr);
+            if (tls_) {
+                // Announced once the handshake, driven by the read path, has completed
+                c.ssl = tls_->accept(client_fd);
+                c.handshaking = true;
+                ssl_failed = !c.ssl;
+            }
+        }
+        if (ssl_failed) {
+            remove_client(shard, client_fd);
+            continue;
+        }
+        if (!tls_)
+            clientConnectionCallback_(client_fd, ipstr);
+
+        // Data may have arrived before registration; edge-triggered epoll would not report it
+        if (use_epoll) {
+            ClientInfo* c = shard.find(client_fd);
+            if (c && !(c->ssl ? drain_tls_client(shard, *c) : drain_client(shard, *c)))
+                remove_client(shard, client_fd);
+        }
     }
 }
 
-void TcpServer::handle_client_io(fd_set& readfds) {
-    std::vector<ClientInfo> to_remove;
+void TcpServer::handle_client_io(Shard& shard, fd_set& readfds, fd_set& writefds) {
+    std::vector<int> to_remove;
+
+    for (int fd : shard.live) {
+        if (shard.slots[fd]->ssl) {
+            if (!service_tls_client(shard, *shard.slots[fd], FD_ISSET(fd, &readfds),
+                                    FD_ISSET(fd, &writefds)))
+                to_remove.push_back(fd);
+            continue;
+        }
+
+        if (FD_ISSET(fd, &writefds) && !flush_client(shard, fd)) {
+            to_remove.push_back(fd);
+            continue;
+        }
 
-    for (auto c : clients_) {
-        if (FD_ISSET(c.fd, &readfds)) {
+        if (FD_ISSET(fd, &readfds)) {
             char buffer[1024];
-            int bytes = recv(c.fd, buffer, sizeof(buffer), 0);
+            ssize_t bytes = receive(shard, fd, buffer, sizeof(buffer));
 
             if (bytes <= 0) {
-                to_remove.push_back(c);
+                to_remove.push_back(fd);
                 continue;
             }
 
-            recieveCallback_(c.fd, c.ip, std::vector<uint8_t>(buffer, buffer + bytes));
+            cfg_.socket_options.rearm_quickack(fd);
+            recieveCallback_(fd, shard.slots[fd]->ip,
+                             std::vector<uint8_t>(buffer, buffer + bytes));
+        }
+    }
+
+    for (int fd : to_remove) remove_client(shard, fd);
+}
+
+ssize_t TcpServer::receive(Shard& shard, int fd, char* buffer, size_t len) {
+    if (!cfg_.busy_poll.measure_latency)
+        return recv(fd, buffer, len, 0);
+
+    char control[LatencyHistogram::kControlSize];
+    iovec iov{buffer, len};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    ssize_t bytes = recvmsg(fd, &msg, 0);
+    if (bytes > 0)
+        shard.latency.record_since_rx(msg);
+    return bytes;
+}
+
+LatencyStats TcpServer::latency_stats() const {
+    LatencyHistogram all;
+    for (const auto& shard : shards_) all.merge(shard->latency);
+    return all.stats();
+}
+
+bool TcpServer::drain_client(Shard& shard, const ClientInfo& client) {
+    char buffer[kReadBufferSize];
+    bool received = false;
+
+    while (true) {
+        ssize_t bytes = receive(shard, client.fd, buffer, sizeof(buffer));
+        if (bytes > 0) {
+            received = true;
+            recieveCallback_(client.fd, client.ip, std::vector<uint8_t>(buffer, buffer + bytes));
+            continue;
+        }
+        if (bytes == 0)
+            return false;  // orderly shutdown by peer
+        if (errno == EINTR)
+            continue;
+        if (received)
+            cfg_.socket_options.rearm_quickack(client.fd);
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+}
+
+bool TcpServer::drain_tls_client(Shard& shard, ClientInfo& client) {
+    char buffer[kReadBufferSize];
+
+    while (true) {
+        int bytes = 0;
+        int status = SSL_ERROR_NONE;
+        bool connected = false;
+        {
+            // send() may be inside SSL_write() on another thread
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            SSL* ssl = client.ssl.get();
+            ERR_clear_error();
+            if (client.handshaking) {
+                int ret = SSL_do_handshake(ssl);
+                if (ret != 1) {
+                    status = SSL_get_error(ssl, ret);
+                    client.read_wants_write = status == SSL_ERROR_WANT_WRITE;
+                    return status == SSL_ERROR_WANT_READ || status == SSL_ERROR_WANT_WRITE;
+                }
+                client.read_wants_write = false;
+                client.handshaking = false;
+                client.ktls_send = tls_->on_handshake(ssl);
+                connected = true;
+                if (!write_queue_locked(client))
+                    return false;
+            } else {
+                bytes = SSL_read(ssl, buffer, sizeof(buffer));
+                if (bytes <= 0)
+                    status = SSL_get_error(ssl, bytes);
+                client.read_wants_write = status == SSL_ERROR_WANT_WRITE;
+            }
+        }
+
+        if (connected) {
+            clientConnectionCallback_(client.fd, client.ip);
+            continue;
+        }
+        if (bytes > 0) {
+            cfg_.socket_options.rearm_quickack(client.fd);
+            recieveCallback_(client.fd, client.ip, std::vector<uint8_t>(buffer, buffer + bytes));
+            continue;
         }
+        // WANT_WRITE: OpenSSL has to send first (e.g. a key update); service_tls_client()
+        // resumes the read once the socket is writable
+        return status == SSL_ERROR_WANT_READ || status == SSL_ERROR_WANT_WRITE;
     }
+}
 
-    for (auto c : to_remove) {
-        close(c.fd);
-        clients_.erase(std::remove_if(clients_.begin(), clients_.end(),
-                                      [&](const ClientInfo& client) { return client.fd == c.fd; }),
-                       clients_.end());
-        clientDisconnectCallback_(c.fd, c.ip);
+bool TcpServer::service_tls_client(Shard& shard, ClientInfo& client, bool readable,
+                                   bool writable) {
+    bool read = readable;
+    bool write = writable;
+    {
+        // write_wants_read is also set by send() on other threads
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        read = read || (writable && client.read_wants_write);
+        write = write || (readable && client.write_wants_read);
     }
+
+    if (write && !flush_client(shard, client.fd))
+        return false;
+    // Decrypted bytes can wait inside OpenSSL, so read until it wants more input
+    return !read || drain_tls_client(shard, client);
+}
+
+void TcpServer::remove_client(Shard& shard, int fd) {
+    std::unique_ptr<ClientInfo> c;
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        c = shard.erase(fd);
+        if (!c)
+            return;
+    }
+
+    if (shard.epoll_fd >= 0)
+        epoll_ctl(shard.epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+    // Reported before close(): until then the fd number can't be handed to a new connection,
+    // so state keyed by fd is dropped before it could be reused
+    if (!c->handshaking)
+        clientDisconnectCallback_(c->fd, c->ip);
+    close(fd);
+}
+
+bool TcpServer::write_queue_locked(ClientInfo& client) {
+    if (client.handshaking)
+        return true;  // flushed when the handshake completes
+
+    while (!client.outq.empty()) {
+        const std::vector<uint8_t>& chunk = client.outq.front();
+        const uint8_t* data = chunk.data() + client.out_offset;
+        const size_t len = chunk.size() - client.out_offset;
+
+        ssize_t sent;
+        if (client.ssl) {
+            ERR_clear_error();
+            int n = SSL_write(client.ssl.get(), data,
+                              static_cast<int>(std::min<size_t>(len, INT_MAX)));
+            if (n <= 0) {
+                int status = SSL_get_error(client.ssl.get(), n);
+                client.write_wants_read = status == SSL_ERROR_WANT_READ;
+                return status == SSL_ERROR_WANT_WRITE || status == SSL_ERROR_WANT_READ;
+            }
+            client.write_wants_read = false;
+            sent = n;
+        } else {
+            // With tcp_cork a partial segment waits for the message queued behind it
+            const int more = cfg_.socket_options.more_flag(client.outq.size() > 1);
+            sent = ::send(client.fd, data, len, MSG_NOSIGNAL | MSG_DONTWAIT | more);
+            if (sent < 0) {
+                if (errno == EINTR)
+                    continue;
+                return errno == EAGAIN || errno == EWOULDBLOCK;
+            }
+        }
+
+        client.out_offset += sent;
+        client.queued_bytes -= sent;
+        if (client.out_offset == chunk.size()) {
+            client.outq.pop_front();
+            client.out_offset = 0;
+        }
+    }
+    return true;
+}
+
+bool TcpServer::flush_client(Shard& shard, int fd) {
+    bool ok = true;
+    bool released = false;
+    size_t queued = 0;
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        ClientInfo* client = shard.find(fd);
+        if (!client)
+            return true;
+
+        ClientInfo& c = *client;
+        ok = write_queue_locked(c);
+        queued = c.queued_bytes;
+        if (c.backpressured && queued <= cfg_.send_high_water_mark / 2) {
+            c.backpressured = false;
+            released = true;
+        }
+    }
+
+    if (released && backpressureCallback_)
+        backpressureCallback_(fd, queued, false);
+    return ok;
 }
 
 Error TcpServer::send(int fd, const std::vector<uint8_t>& data) {
     Error err;
-    const uint8_t* buf = data.data();
-    size_t total = 0;
-    size_t len = data.size();
 
-    while (total < len) {
-        ssize_t sent = ::send(fd, buf + total, len - total, 0);
-        if (sent <= 0) {
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                usleep(1000);
+    // An fd lives in exactly one shard; replies sent from a receive callback find it in
+    // the calling shard on the first probe
+    const size_t shards = shards_.size();
+    const size_t first = current_shard_index >= 0 ? size_t(current_shard_index) : 0;
+    for (size_t k = 0; k < shards; ++k) {
+        Shard* shard = shards_[(first + k) % shards].get();
+        std::unique_lock<std::mutex> lock(shard->mutex);
+        ClientInfo* client = shard->find(fd);
+        if (!client)
+            continue;
+
+        return enqueue_locked(*shard, *client, lock, data);
+    }
+
+    err.set_code(ErrorCode::NOT_CONNECTED)->set_message("unknown client fd");
+    return err;
+}
+
+Error TcpServer::enqueue_locked(Shard& shard, ClientInfo& c, std::unique_lock<std::mutex>& lock,
+                                std::vector<uint8_t> data) {
+    Error err;
+    if (!c.outq.empty() && c.queued_bytes + data.size() > cfg_.send_high_water_mark) {
+        // Refuse the whole message so the stream never carries a partial one
+        const int fd = c.fd;
+        const bool notify = !c.backpressured;
+        const size_t queued = c.queued_bytes;
+        c.backpressured = true;
+        lock.unlock();
+
+        if (notify && backpressureCallback_)
+            backpressureCallback_(fd, queued, true);
+        err.set_code(ErrorCode::SEND_FAILED)->set_message("send queue above high-water mark");
+        return err;
+    }
+
+    const bool was_idle = c.outq.empty();
+    c.queued_bytes += data.size();
+    c.outq.push_back(std::move(data));
+
+    // Write straight away when nothing is queued ahead; the reactor takes the rest
+    if (was_idle && !write_queue_locked(c)) {
+        err.set_code(ErrorCode::SEND_FAILED)->set_message(strerror(errno));
+        return err;
+    }
+
+    // epoll reports EPOLLOUT by itself; select has to rebuild its writefds first
+    if (was_idle && !c.outq.empty() && shard.epoll_fd < 0) {
+        uint64_t one = 1;
+        [[maybe_unused]] ssize_t n = write(shard.wake_fd, &one, sizeof(one));
+    }
+    return err;
+}
+
+Error TcpServer::send_file(int fd, int file_fd, off_t offset, size_t count) {
+    const size_t shards = shards_.size();
+    const size_t first = current_shard_index >= 0 ? size_t(current_shard_index) : 0;
+    for (size_t k = 0; k < shards; ++k) {
+        Shard* shard = shards_[(first + k) % shards].get();
+        std::unique_lock<std::mutex> lock(shard->mutex);
+        ClientInfo* client = shard->find(fd);
+        if (!client)
+            continue;
+
+        // The kernel copies from the page cache, encrypting on the way with kTLS
+        ClientInfo& c = *client;
+        if (c.outq.empty() && !c.handshaking && (!c.ssl || c.ktls_send)) {
+            while (count > 0) {
+                ssize_t sent;
+                if (c.ssl) {
+                    ERR_clear_error();
+                    sent = SSL_sendfile(c.ssl.get(), file_fd, offset, count, 0);
+                } else {
+                    sent = ::sendfile(c.fd, file_fd, &offset, count);
+                }
+                if (sent <= 0)
+                    break;  // socket full (or sendfile unusable): queue the rest
+                if (c.ssl)
+                    offset += sent;
+                count -= sent;
+            }
+        }
+        if (count == 0)
+            return Error();
+
+        std::vector<uint8_t> data(count);
+        size_t got = 0;
+        while (got < count) {
+            ssize_t n = pread(file_fd, data.data() + got, count - got, offset + got);
+            if (n < 0 && errno == EINTR)
                 continue;
+            if (n < 0) {
+                Error err;
+                err.set_code(ErrorCode::SEND_FAILED)->set_message(strerror(errno));
+                return err;
             }
-            break;
+            if (n == 0)
+                break;  // end of file
+            got += n;
         }
-        total += sent;
+        data.resize(got);
+        if (data.empty())
+            return Error();
+        return enqueue_locked(*shard, c, lock, std::move(data));
     }
 
-    if (total == 0) {
-        err.set_code(ErrorCode::SEND_FAILED)->set_message("total send is zero");
-    }
+    Error err;
+    err.set_code(ErrorCode::NOT_CONNECTED)->set_message("unknown client fd");
     return err;
 }
 
 Error TcpServer::send(const std::string& ip, const std::vector<uint8_t>& data) {
-    // Find the client fd by IP address
-    for (const auto& client : clients_) {
-        if (client.ip == ip) {
-            return send(client.fd, data);
+    int target = -1;
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        auto it = shard->by_ip.find(ip);
+        if (it != shard->by_ip.end()) {
+            target = it->second.front();
+            break;
         }
     }
+
+    if (target >= 0)
+        return send(target, data);
+
     Error err;
     err.set_code(ErrorCode::SEND_FAILED)->set_message("ip not found: " + ip);
     return err;
@@ -3,51 +3,151 @@
 #include <arpa/inet.h>
 #include <fcntl.h>
 #include <netinet/in.h>
+#include <sys/epoll.h>
 #include <sys/socket.h>
 #include <unistd.h>
 
 #include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include "error.h"
 #include "server/server_interface.h"
+#include "socket/latency.h"
+#include "tls/tls_context.h"
 
 class TcpServer : public ServerInterface {
     struct ClientInfo {
       public:
-        int fd;
+        int fd = -1;
         std::string ip;
+
+        // Outbound bytes the socket could not take yet, flushed when it becomes writable
+        std::deque<std::vector<uint8_t>> outq;
+        size_t out_offset = 0;  // bytes of outq.front() already written
+        size_t queued_bytes = 0;
+        bool backpressured = false;  // a send was refused at the high-water mark
+
+        size_t live_index = 0;  // position in Shard::live
+
+        // TLS connections only. Used under the shard mutex, reads included.
+        TlsContext::SslPtr ssl;
+        bool handshaking = false;  // not announced to the callbacks yet
+        bool ktls_send = false;    // the kernel encrypts outgoing records
+        // OpenSSL needs the other direction first: the handshake or SSL_read() stopped on
+        // WANT_WRITE (resumed when writable), SSL_write() on WANT_READ (when readable)
+        bool read_wants_write = false;
+        bool write_wants_read = false;
+    };
+
+    // One reactor: listener, event loop thread and the connections it accepted.
+    // Only the shard's own thread inserts/erases connections; other threads look them up
+    // and append to their write queues under `mutex`. Lookup, insert and erase are O(1).
+    struct Shard {
+        int index = 0;
+        int listen_fd = -1;
+        int epoll_fd = -1;
+        int wake_fd = -1;  // eventfd used to interrupt the loop (shutdown, new select writers)
+
+        // fd-indexed slab: slots[fd] is the live connection on fd, null otherwise
+        std::vector<std::unique_ptr<ClientInfo>> slots;
+        std::vector<int> live;  // dense list of live fds, for select() and shutdown
+        std::unordered_map<std::string, std::vector<int>> by_ip;
+
+        std::mutex mutex;
+        std::thread worker;
+        LatencyHistogram latency;  // recorded by the shard's thread
+
+        ClientInfo* find(int fd) const {
+            return fd >= 0 && size_t(fd) < slots.size() ? slots[fd].get() : nullptr;
+        }
+        ClientInfo& insert(int fd, const std::string& ip);
+        std::unique_ptr<ClientInfo> erase(int fd);
     };
 
   public:
+    // Reports a connection's write queue crossing the high-water mark (active=true, the
+    // send was refused) and draining back below half of it (active=false)
+    using BackpressureCallback = std::function<void(int fd, size_t queued_bytes, bool active)>;
+
     TcpServer(ServerConfig cfg, ReceiveCallback recieveCallback,
               ClientConnectCallback clientCallback,
               ClientDisconnectCallback clientDisconnectCallback)
         : ServerInterface(cfg, recieveCallback, clientCallback, clientDisconnectCallback) {}
 
-    // Bind to port and start the server loop in a background thread
+    ~TcpServer() override { gracefull_shutdown(); }
+
+    // Bind to port and start one event loop thread per shard
     Error listen() override;
 
-    // Send data to client by fd
+    // Send data to client by fd. Never blocks: what the socket cannot take now is queued
+    // and flushed by the shard's event loop. Fails with SEND_FAILED when the connection
+    // already has send_high_water_mark bytes queued.
     Error send(int fd, const std::vector<uint8_t>& data) override;
 
-    // Send data to client by IP (linear search over clients_)
+    // Send data to client by IP (first connection from that address, hash lookup)
     Error send(const std::string& ip, const std::vector<uint8_t>& data) override;
 
-    // Stop server, close sockets, join worker thread
+    // Send up to count bytes of file_fd from offset, after what is already queued. While the
+    // queue is empty, plain connections and TLS ones with kTLS send offload go through
+    // sendfile(); the rest is read from the file (under the shard lock) and queued like send().
+    Error send_file(int fd, int file_fd, off_t offset, size_t count);
+
+    // Receive-to-callback latency over all shards, with cfg.busy_poll.measure_latency.
+    // Plain connections only: TLS records are read through OpenSSL.
+    LatencyStats latency_stats() const;
+
+    // Handshake counters; all zero without TLS
+    TlsContext::Stats tls_stats() const { return tls_ ? tls_->stats() : TlsContext::Stats{}; }
+
+    // Stop server, close sockets, join worker threads
     Error gracefull_shutdown() override;
 
+    // Index of the shard whose thread is running the current callback, -1 elsewhere
+    static int current_shard();
+
+    int shard_count() const { return static_cast<int>(shards_.size()); }
+
+    void set_backpressure_callback(BackpressureCallback callback) {
+        backpressureCallback_ = std::move(callback);
+    }
+
   private:
-    void accept_new_client();
-    void handle_client_io(fd_set& readfds);
-    void run();  // main event loop (private)
+    Error open_listener(Shard& shard);
+    Error setup_epoll(Shard& shard);
+    Error attach_cpu_steering();
+    void accept_new_client(Shard& shard);
+    void handle_client_io(Shard& shard, fd_set& readfds, fd_set& writefds);
+    bool drain_client(Shard& shard, const ClientInfo& client);  // false when the peer is gone
+    bool drain_tls_client(Shard& shard, ClientInfo& client);    // drives the handshake too
+    // Runs the TLS read and write paths on the readiness each of them is waiting for
+    bool service_tls_client(Shard& shard, ClientInfo& client, bool readable, bool writable);
+    bool flush_client(Shard& shard, int fd);                    // false when the socket failed
+    bool write_queue_locked(ClientInfo& client);                // expects shard.mutex to be held
+    Error enqueue_locked(Shard& shard, ClientInfo& client, std::unique_lock<std::mutex>& lock,
+                         std::vector<uint8_t> data);
+    void remove_client(Shard& shard, int fd);
+    void run(Shard& shard);  // main event loop (private)
+    void run_select(Shard& shard);
+    void run_epoll(Shard& shard);
+    void close_shards();
+    ssize_t receive(Shard& shard, int fd, char* buffer, size_t len);  // recv() + latency
+    bool uses_epoll() const {
+        return cfg_.event_loop == ServerConfig::EventLoopType::EPOLL || cfg_.busy_poll.enabled;
+    }
 
   private:
-    int server_fd_ = -1;
-    std::vector<ClientInfo> clients_;
+    static constexpr int kMaxEpollEvents = 1024;
+    static constexpr size_t kReadBufferSize = 16 * 1024;
 
-    std::thread worker_;
+    std::unique_ptr<TlsContext> tls_;  // declared first: connections hold its SSL objects
+    std::vector<std::unique_ptr<Shard>> shards_;
     std::atomic<bool> stop_{false};
+    BackpressureCallback backpressureCallback_;
 };
@@ -1,10 +1,88 @@
 #include "udp_server.h"
 
-UdpServer::UdpServer(int port, Callback cb) : port_(port), callback_(cb) {}
+#include <poll.h>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "udp/offload.h"
+
+UdpServer::UdpServer(int port, Callback cb, UdpServerOptions options)
+    : port_(port), options_(options) {
+    handler_ = [cb](int client_id, std::span<const uint8_t> data, UdpResponder& reply) {
+        reply.reply(cb(client_id, std::string(data.begin(), data.end())));
+    };
+}
+
+UdpServer::UdpServer(int port, DatagramHandler handler, UdpServerOptions options)
+    : port_(port), options_(options), handler_(std::move(handler)) {}
+
+UdpDeferredReply UdpResponder::defer() const {
+    return UdpDeferredReply(server_, server_->generation_, fd_, client_, client_id_);
+}
+
+Error UdpDeferredReply::send(std::span<const uint8_t> data) const {
+    Error err;
+    // Held across sendto(), so fd_ can't be closed (and its number reused) meanwhile
+    std::shared_lock<std::shared_mutex> lock(server_->sockets_mutex_);
+    if (!server_->running_ || server_->generation_ != generation_) {
+        err.set_code(ErrorCode::NOT_CONNECTED)->set_message("UDP server is stopped");
+        return err;
+    }
+
+    if (sendto(fd_, data.data(), data.size(), 0, (const sockaddr*)&client_, sizeof(client_)) <
+        0)
+        err.set_code(ErrorCode::SEND_FAILED)->set_message(strerror(errno));
+    return err;
+}
 
 Error UdpServer::start() {
-    sockfd_ = socket(AF_INET, SOCK_DGRAM, 0);
-    if (sockfd_ < 0) {
+    const unsigned workers = std::max(1u, options_.workers);
+    int port = port_;
+
+    for (unsigned i = 0; i < workers; ++i) {
+        int fd = -1;
+        Error err = open_socket(port, fd);
+        if (err.code() != ErrorCode::NO_ERROR) {
+            for (int s : socks_) close(s);
+            socks_.clear();
+            return err;
+        }
+        socks_.push_back(fd);
+
+        // Port 0: the remaining workers join whatever port the first socket got
+        if (port == 0) {
+            sockaddr_in bound{};
+            socklen_t len = sizeof(bound);
+            getsockname(fd, (sockaddr*)&bound, &len);
+            port = ntohs(bound.sin_port);
+        }
+    }
+
+    if (options_.udp_offload) {
+        gro_ = true;
+        for (int fd : socks_) gro_ = udp_offload::enable_gro(fd) && gro_;
+        gso_ = udp_offload::gso_supported(socks_.front());
+    }
+
+    running_ = true;
+
+    // Start one server thread per socket
+    for (int fd : socks_) {
+        workers_.emplace_back([this, fd]() { this->run_socket(fd); });
+        if (options_.busy_poll.enabled)
+            options_.busy_poll.pin(workers_.back(), static_cast<int>(workers_.size()) - 1);
+    }
+
+    Error ok;
+    ok.set_code(ErrorCode::NO_ERROR);
+    return ok;
+}
+
+Error UdpServer::open_socket(int port, int& fd) {
+    fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
         Error err;
         err.set_code(ErrorCode::CONNECTION_FAILED)->set_message("Failed to create UDP socket");
         return err;
@@ -14,14 +92,21 @@ Error UdpServer::start() {
     struct timeval tv;
     tv.tv_sec = 0;
     tv.tv_usec = 100000;
-    setsockopt(sockfd_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    if (options_.workers > 1) {
+        int opt = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt));
+    }
+    options_.socket_options.apply(fd);
+    options_.busy_poll.apply(fd);
 
     sockaddr_in addr{};
     addr.sin_family = AF_INET;
     addr.sin_addr.s_addr = INADDR_ANY;
-    addr.sin_port = htons(port_);
+    addr.sin_port = htons(port);
 
-    if (bind(sockfd_, (sockaddr*)&addr, sizeof(addr)) < 0) {
+    if (bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
         Error err;
         if (errno == EADDRINUSE) {
             err.set_code(ErrorCode::PORT_IN_USE)->set_message("Port is already in use");
@@ -29,48 +114,358 @@ Error UdpServer::start() {
             err.set_code(ErrorCode::CONNECTION_FAILED)
                 ->set_message("Failed to bind UDP server socket");
         }
+        close(fd);
+        fd = -1;
         return err;
     }
 
-    running_ = true;
-
-    // Start server thread
-    worker_ = std::thread([this]() { this->run(); });
-
     Error ok;
-    ok.set_code(ErrorCode::NO_ERROR);
     return ok;
 }
 
+namespace {
+    // CLOCK_MONOTONIC_COARSE costs a memory read; tick resolution is plenty for expiry
+    int64_t coarse_now_ms() {
+        timespec ts{};
+        clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+        return int64_t(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+    }
+
+    sockaddr_in key_to_address(uint64_t key) {
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = key >> 16;
+        addr.sin_port = key & 0xFFFF;
+        return addr;
+    }
+}  // namespace
+
 int UdpServer::get_or_assign_client_id(const sockaddr_in& client) {
     uint64_t key = (uint64_t(client.sin_addr.s_addr) << 16) | client.sin_port;
 
-    if (!client_map_.count(key))
-        client_map_[key] = next_client_id_++;
+    // Fibonacci hash; the top bits pick the shard
+    const int index = static_cast<int>((key * 0x9E3779B97F4A7C15ull) >> 60) % kClientShards;
+    ClientShard& shard = client_shards_[index];
+    const int64_t now = coarse_now_ms();
+
+    ClientEntry evicted{};
+    bool have_evicted = false;
+    int id;
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto [it, inserted] = shard.by_key.try_emplace(key);
+        if (!inserted) {
+            // Known client: refresh and move to the front of the LRU order
+            ClientEntry& entry = *it->second;
+            entry.last_seen_ms = now;
+            shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+            return entry.id;
+        }
+
+        const size_t shard_capacity =
+            options_.max_clients ? (options_.max_clients + kClientShards - 1) / kClientShards
+                                 : 0;
+        if (shard_capacity && shard.lru.size() >= shard_capacity) {
+            evicted = shard.lru.back();
+            have_evicted = true;
+            shard.by_key.erase(evicted.key);
+            shard.by_id.erase(evicted.id);
+            shard.lru.pop_back();
+        }
+
+        do {
+            id = static_cast<int>(shard.next_seq++ % kMaxClientSeq) * kClientShards + index + 1;
+        } while (shard.by_id.count(id));
+        shard.lru.push_front(ClientEntry{key, id, now});
+        it->second = shard.lru.begin();
+        shard.by_id[id] = shard.lru.begin();
+    }
 
-    return client_map_[key];
+    if (have_evicted && expiryCallback_)
+        expiryCallback_(evicted.id, key_to_address(evicted.key), ExpiryReason::CAPACITY);
+    return id;
+}
+
+size_t UdpServer::client_count() {
+    size_t count = 0;
+    for (auto& shard : client_shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        count += shard.lru.size();
+    }
+    return count;
+}
+
+void UdpServer::expire_idle_clients() {
+    const int64_t timeout = options_.client_idle_timeout.count();
+    if (timeout <= 0)
+        return;
+
+    // Whichever worker finds the sweep due claims it; the rest carry on receiving
+    const int64_t now = coarse_now_ms();
+    int64_t due = next_sweep_ms_.load(std::memory_order_relaxed);
+    const int64_t interval = std::clamp<int64_t>(timeout / 4, 10, 1000);
+    if (now < due || !next_sweep_ms_.compare_exchange_strong(due, now + interval))
+        return;
+
+    std::vector<ClientEntry> expired;
+    for (auto& shard : client_shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        // Oldest entries sit at the back, so the sweep stops at the first live one
+        while (!shard.lru.empty() && now - shard.lru.back().last_seen_ms >= timeout) {
+            const ClientEntry& entry = shard.lru.back();
+            expired.push_back(entry);
+            shard.by_key.erase(entry.key);
+            shard.by_id.erase(entry.id);
+            shard.lru.pop_back();
+        }
+    }
+
+    if (expiryCallback_) {
+        for (const auto& entry : expired)
+            expiryCallback_(entry.id, key_to_address(entry.key), ExpiryReason::IDLE);
+    }
 }
 
 void UdpServer::run() {
-    char buffer[1024];
+    if (!socks_.empty())
+        run_socket(socks_.front());
+}
+
+void UdpServer::run_socket(int fd) {
+    if (gro_)
+        run_offload(fd);
+    else if (options_.batch_size > 1)
+        run_batched(fd);
+    else
+        run_plain(fd);
+}
+
+void UdpServer::run_plain(int fd) {
+    char buffer[kBufferSize];
+    char control[LatencyHistogram::kControlSize];
     sockaddr_in client{};
-    socklen_t len = sizeof(client);
+    iovec iov{buffer, sizeof(buffer)};
+    std::vector<std::string> replies;
+    BusySpinner spinner(options_.busy_poll);
+    const int flags = options_.busy_poll.enabled ? MSG_DONTWAIT : 0;
+
+    while (running_) {
+        msghdr msg{};
+        msg.msg_name = &client;
+        msg.msg_namelen = sizeof(client);
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        int n = recvmsg(fd, &msg, flags);
+
+        if (!running_)
+            break;
+
+        expire_idle_clients();
+
+        if (n < 0) {
+            if (flags)
+                spinner.wait_readable(fd, 100);
+            continue;
+        }
+        spinner.update(true);
+        if (options_.busy_poll.measure_latency)
+            latency_.record_since_rx(msg);
+
+        int client_id = get_or_assign_client_id(client);
+
+        replies.clear();
+        UdpResponder responder(this, fd, client, client_id, &replies);
+        handler_(client_id, std::span<const uint8_t>((const uint8_t*)buffer, n), responder);
+
+        send_replies(fd, client, replies);
+    }
+}
+
+void UdpServer::run_batched(int fd) {
+    const unsigned batch = options_.batch_size;
+
+    std::vector<char> buffers(batch * kBufferSize);
+    std::vector<char> controls(batch * LatencyHistogram::kControlSize);
+    std::vector<sockaddr_in> addrs(batch);
+    std::vector<iovec> iovs(batch);
+    std::vector<mmsghdr> msgs(batch);
+    BusySpinner spinner(options_.busy_poll);
+    const int flags = options_.busy_poll.enabled ? MSG_DONTWAIT : MSG_WAITFORONE;
+
+    // A handler may answer a datagram any number of times; reply_to[k] indexes addrs
+    std::vector<std::string> replies;
+    std::vector<int> reply_to;
+    std::vector<iovec> reply_iovs;
+    std::vector<mmsghdr> reply_msgs;
+
+    while (running_) {
+        for (unsigned i = 0; i < batch; ++i) {
+            iovs[i] = {buffers.data() + i * kBufferSize, kBufferSize};
+            msgs[i] = {};
+            msgs[i].msg_hdr.msg_name = &addrs[i];
+            msgs[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+            msgs[i].msg_hdr.msg_control = controls.data() + i * LatencyHistogram::kControlSize;
+            msgs[i].msg_hdr.msg_controllen = LatencyHistogram::kControlSize;
+        }
+
+        // Blocks (up to SO_RCVTIMEO) for the first datagram, then takes what is queued;
+        // busy polling takes only what is queued
+        int n = recvmmsg(fd, msgs.data(), batch, flags, nullptr);
+
+        if (!running_)
+            break;
+
+        expire_idle_clients();
+
+        if (n <= 0) {
+            if (options_.busy_poll.enabled)
+                spinner.wait_readable(fd, 100);
+            continue;
+        }
+        spinner.update(true);
+
+        n = fill_batch(fd, msgs.data(), n);
+        if (options_.busy_poll.measure_latency) {
+            for (int i = 0; i < n; ++i) latency_.record_since_rx(msgs[i].msg_hdr);
+        }
+
+        replies.clear();
+        reply_to.clear();
+        for (int i = 0; i < n; ++i) {
+            int client_id = get_or_assign_client_id(addrs[i]);
+            const uint8_t* data = (const uint8_t*)buffers.data() + i * kBufferSize;
+
+            UdpResponder responder(this, fd, addrs[i], client_id, &replies);
+            handler_(client_id, std::span<const uint8_t>(data, msgs[i].msg_len), responder);
+            reply_to.resize(replies.size(), i);
+        }
+
+        const int count = static_cast<int>(replies.size());
+        reply_iovs.resize(count);
+        reply_msgs.resize(count);
+        for (int k = 0; k < count; ++k) {
+            reply_iovs[k] = {replies[k].data(), replies[k].size()};
+            reply_msgs[k] = {};
+            reply_msgs[k].msg_hdr.msg_name = &addrs[reply_to[k]];
+            reply_msgs[k].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+            reply_msgs[k].msg_hdr.msg_iov = &reply_iovs[k];
+            reply_msgs[k].msg_hdr.msg_iovlen = 1;
+        }
+
+        // sendmmsg() stops at the first message it can't send; resume after the last sent.
+        // An error concerns that one message (too big, unreachable destination) unless it
+        // is the socket's own: skip the message so the other clients still get theirs.
+        for (int sent = 0; sent < count;) {
+            int m = sendmmsg(fd, reply_msgs.data() + sent, count - sent, 0);
+            if (m >= 0) {
+                sent += m;
+            } else if (errno == EBADF || errno == ENOTSOCK || errno == EAGAIN ||
+                       errno == EWOULDBLOCK) {
+                break;
+            } else if (errno != EINTR) {
+                ++sent;
+            }
+        }
+    }
+}
+
+int UdpServer::fill_batch(int fd, mmsghdr* msgs, unsigned received) {
+    using Clock = std::chrono::steady_clock;
+    if (options_.batch_timeout.count() <= 0)
+        return received;
+
+    const auto deadline = Clock::now() + options_.batch_timeout;
+    while (received < options_.batch_size && running_) {
+        auto left = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - Clock::now());
+        if (left.count() <= 0)
+            break;
+
+        timespec ts{};
+        ts.tv_sec = left.count() / 1000000000;
+        ts.tv_nsec = left.count() % 1000000000;
+        pollfd pfd{fd, POLLIN, 0};
+        if (ppoll(&pfd, 1, &ts, nullptr) <= 0)
+            break;
+
+        int n = recvmmsg(fd, msgs + received, options_.batch_size - received, MSG_DONTWAIT,
+                        nullptr);
+        if (n > 0)
+            received += n;
+    }
+    return received;
+}
+
+void UdpServer::run_offload(int fd) {
+    std::vector<uint8_t> buffer(kOffloadBufferSize);
+    std::vector<std::string> replies;
+    BusySpinner spinner(options_.busy_poll);
+    const int flags = options_.busy_poll.enabled ? MSG_DONTWAIT : 0;
 
     while (running_) {
-        int n = recvfrom(sockfd_, buffer, sizeof(buffer), 0, (sockaddr*)&client, &len);
+        sockaddr_in client{};
+        int segment_size = 0;
+        int64_t rx_ns = 0;
+        ssize_t n = udp_offload::recv_gro(fd, buffer.data(), buffer.size(), &client,
+                                          &segment_size, flags, &rx_ns);
 
         if (!running_)
             break;
 
-        if (n < 0)
+        expire_idle_clients();
+
+        if (n < 0) {
+            if (flags)
+                spinner.wait_readable(fd, 100);
             continue;
+        }
+        spinner.update(true);
 
-        std::string req(buffer, n);
+        // GRO only merges datagrams of one flow, so every reply goes back to `client`
         int client_id = get_or_assign_client_id(client);
+        replies.clear();
+        UdpResponder responder(this, fd, client, client_id, &replies);
+        const bool measure = options_.busy_poll.measure_latency && rx_ns > 0;
+        udp_offload::for_each_segment(buffer.data(), n, segment_size,
+                                      [&](const uint8_t* data, size_t len) {
+                                          // A sample per datagram, as in the other loops
+                                          if (measure)
+                                              latency_.record(LatencyHistogram::realtime_ns() -
+                                                              rx_ns);
+                                          handler_(client_id, std::span<const uint8_t>(data, len),
+                                                   responder);
+                                      });
+
+        send_replies(fd, client, replies);
+    }
+}
 
-        std::string reply = callback_(client_id, req);
+void UdpServer::send_replies(int fd, const sockaddr_in& client,
+                             const std::vector<std::string>& replies) {
+    std::vector<iovec> iov(replies.size());
+    for (size_t i = 0; i < replies.size(); ++i)
+        iov[i] = {const_cast<char*>(replies[i].data()), replies[i].size()};
 
-        sendto(sockfd_, reply.c_str(), reply.size(), 0, (sockaddr*)&client, len);
+    size_t i = 0;
+    while (i < iov.size()) {
+        size_t run = gso_ ? udp_offload::gso_run_length(&iov[i], iov.size() - i) : 1;
+        if (run > 1) {
+            if (udp_offload::send_gso(fd, (const sockaddr*)&client, sizeof(client), &iov[i], run,
+                                      0) >= 0) {
+                i += run;
+                continue;
+            }
+            // No segmentation support on this route/device: stop trying, send one by one
+            if (errno == EIO || errno == EOPNOTSUPP || errno == ENOPROTOOPT)
+                gso_ = false;
+        }
+
+        for (size_t end = i + run; i < end; ++i)
+            sendto(fd, iov[i].iov_base, iov[i].iov_len, 0, (const sockaddr*)&client,
+                   sizeof(client));
     }
 }
 
@@ -78,19 +473,20 @@ void UdpServer::send_async(int fd, const std::string& data, std::function<void()
     sockaddr_in target{};
     bool found = false;
 
-    for (auto& kv : client_map_) {
-        if (kv.second == fd) {
-            uint64_t key = kv.first;
-            target.sin_family = AF_INET;
-            target.sin_addr.s_addr = key >> 16;
-            target.sin_port = key & 0xFFFF;
+    // The id names the shard that issued it
+    if (fd > 0) {
+        ClientShard& shard = client_shards_[(fd - 1) % kClientShards];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.by_id.find(fd);
+        if (it != shard.by_id.end()) {
+            target = key_to_address(it->second->key);
             found = true;
-            break;
         }
     }
 
-    if (found) {
-        sendto(sockfd_, data.c_str(), data.size(), 0, (sockaddr*)&target, sizeof(target));
+    if (found && !socks_.empty()) {
+        sendto(socks_.front(), data.c_str(), data.size(), 0, (sockaddr*)&target,
+               sizeof(target));
     }
 
     if (callback)
@@ -100,11 +496,15 @@ void UdpServer::send_async(int fd, const std::string& data, std::function<void()
 void UdpServer::stop() {
     running_ = false;
 
-    if (sockfd_ >= 0) {
-        close(sockfd_);
-        sockfd_ = -1;
+    // Workers notice running_ within one SO_RCVTIMEO; join before releasing the sockets
+    for (auto& worker : workers_) {
+        if (worker.joinable())
+            worker.join();
     }
+    workers_.clear();
 
-    if (worker_.joinable())
-        worker_.join();
+    std::unique_lock<std::shared_mutex> lock(sockets_mutex_);
+    ++generation_;
+    for (int fd : socks_) close(fd);
+    socks_.clear();
 }
@@ -5,36 +5,208 @@
 #include <sys/socket.h>
 #include <unistd.h>
 
+#include <array>
 #include <atomic>
+#include <chrono>
+#include <climits>
 #include <functional>
+#include <list>
+#include <mutex>
+#include <shared_mutex>
+#include <span>
 #include <string>
 #include <thread>
 #include <unordered_map>
+#include <vector>
 
 #include "error.h"
+#include "socket/busy_poll.h"
+#include "socket/latency.h"
+#include "socket/socket_options.h"
+
+struct UdpServerOptions {
+    // Datagrams pulled per recvmmsg() call; their replies leave in one sendmmsg().
+    // 1 keeps the plain recvfrom()/sendto() loop.
+    unsigned batch_size = 1;
+
+    // Once a datagram has arrived, wait up to this long for a partial batch to fill.
+    // Zero takes only what is already queued on the socket.
+    std::chrono::microseconds batch_timeout{0};
+
+    // Receive with UDP_GRO and send replies with UDP_SEGMENT. Coalesced packets are split
+    // back into datagrams for the callback, and the replies to one packet leave in as few
+    // GSO sends as possible. Falls back to the regular loops when the kernel lacks GRO.
+    bool udp_offload = false;
+
+    // Receive threads. With more than one, each owns an SO_REUSEPORT socket on the port and
+    // the kernel's flow hash keeps a given client on the same worker.
+    unsigned workers = 1;
+
+    // Client registry bounds. Past max_clients the least recently seen client of the
+    // address's shard is evicted (the limit is split evenly over the registry shards, so
+    // it is rounded up to a multiple of their count). Clients silent for longer than
+    // client_idle_timeout are expired by a periodic sweep. Zero disables either bound.
+    size_t max_clients = 0;
+    std::chrono::milliseconds client_idle_timeout{0};
+
+    // Buffer sizes, busy poll and TOS of the receive sockets (TCP-only fields are ignored)
+    SocketOptions socket_options;
+
+    // Busy-poll mode: workers read with MSG_DONTWAIT and spin instead of blocking in the
+    // receive call; busy_poll.cpu pins worker i to cpu + i. With measure_latency,
+    // latency_stats() covers every loop, one sample per datagram.
+    BusyPollOptions busy_poll;
+};
+
+class UdpServer;
+
+// Answers one datagram after its handler returned, from any thread. Cheap to copy; every
+// send() is a separate datagram. Must not outlive the server. Once the server stops, send()
+// fails with NOT_CONNECTED, also after a later start().
+class UdpDeferredReply {
+  public:
+    Error send(std::span<const uint8_t> data) const;
+    int client_id() const { return client_id_; }
+    const sockaddr_in& client() const { return client_; }
+
+  private:
+    friend class UdpResponder;
+    UdpDeferredReply(UdpServer* server, uint64_t generation, int fd, const sockaddr_in& client,
+                     int client_id)
+        : server_(server),
+          generation_(generation),
+          fd_(fd),
+          client_(client),
+          client_id_(client_id) {}
+
+    UdpServer* server_;
+    uint64_t generation_;  // run of the server that fd_ belongs to
+    int fd_;
+    sockaddr_in client_;
+    int client_id_;
+};
+
+// Passed to a DatagramHandler for the datagram being handled. reply() queues an answer that
+// leaves with the rest of the receive batch; defer() hands the answer to another thread.
+// A handler that does neither sends nothing.
+class UdpResponder {
+  public:
+    void reply(std::span<const uint8_t> data) { replies_->emplace_back(data.begin(), data.end()); }
+    void reply(std::string data) { replies_->push_back(std::move(data)); }
+
+    UdpDeferredReply defer() const;
+
+    int client_id() const { return client_id_; }
+    const sockaddr_in& client() const { return client_; }
+
+  private:
+    friend class UdpServer;
+    UdpResponder(UdpServer* server, int fd, const sockaddr_in& client, int client_id,
+                 std::vector<std::string>* replies)
+        : server_(server), fd_(fd), client_(client), client_id_(client_id), replies_(replies) {}
+
+    UdpServer* server_;
+    int fd_;
+    const sockaddr_in& client_;
+    int client_id_;
+    std::vector<std::string>* replies_;
+};
 
 class UdpServer {
   public:
+    // The returned string is sent back to the client, even when empty
     using Callback = std::function<std::string(int, const std::string&)>;
 
-    UdpServer(int port, Callback cb);
+    // `data` points into the receive buffer and is only valid during the call
+    using DatagramHandler =
+        std::function<void(int client_id, std::span<const uint8_t> data, UdpResponder& reply)>;
+
+    enum class ExpiryReason { IDLE, CAPACITY };
+    // A client id was dropped from the registry; the address gets a new id if it returns
+    using ExpiryCallback =
+        std::function<void(int id, const sockaddr_in& client, ExpiryReason reason)>;
 
-    Error start();  // starts worker thread
-    void stop();    // stops server and joins thread
+    UdpServer(int port, Callback cb, UdpServerOptions options = {});
+    UdpServer(int port, DatagramHandler handler, UdpServerOptions options = {});
 
-    void run();  // internal loop (still public but not needed externally)
+    Error start();  // opens the sockets and starts the worker threads
+    void stop();    // stops server and joins threads
+
+    void run();  // internal loop on the first socket (still public but not needed externally)
     void send_async(int fd, const std::string& data, std::function<void()> callback);
 
+    // Ids are unique across workers and stable for an address while it stays registered;
+    // safe from any thread
     int get_or_assign_client_id(const sockaddr_in& client);
 
+    // Number of registered clients
+    size_t client_count();
+
+    // Receive-to-callback latency of all workers, with options.busy_poll.measure_latency
+    LatencyStats latency_stats() const { return latency_.stats(); }
+
+    // Set before start()
+    void set_expiry_callback(ExpiryCallback callback) { expiryCallback_ = std::move(callback); }
+
   private:
+    friend class UdpDeferredReply;
+    friend class UdpResponder;
+
+    struct ClientEntry {
+        uint64_t key;  // address << 16 | port, network byte order
+        int id;
+        int64_t last_seen_ms;
+    };
+
+    // Client ids live in independently locked shards picked by address hash. A shard hands
+    // out ids congruent to its index, so shards never collide and the id names its shard.
+    // Both directions are indexed, and `lru` keeps entries ordered by last activity.
+    // Sequence numbers never come back from evicted clients, so after kMaxClientSeq new
+    // addresses a shard wraps to its first id, skipping ids still registered.
+    struct ClientShard {
+        using Iterator = std::list<ClientEntry>::iterator;
+
+        std::mutex mutex;
+        std::list<ClientEntry> lru;  // most recently seen first
+        std::unordered_map<uint64_t, Iterator> by_key;
+        std::unordered_map<int, Iterator> by_id;
+        uint64_t next_seq = 0;
+    };
+
+    void expire_idle_clients();
+
+    Error open_socket(int port, int& fd);
+    void run_socket(int fd);
+    void run_plain(int fd);
+    void run_batched(int fd);
+    int fill_batch(int fd, mmsghdr* msgs, unsigned received);
+    void run_offload(int fd);
+    void send_replies(int fd, const sockaddr_in& client, const std::vector<std::string>& replies);
+
+  private:
+    static constexpr size_t kBufferSize = 1024;
+    static constexpr size_t kOffloadBufferSize = 65536;
+    static constexpr int kClientShards = 16;
+    // Sequence numbers per shard that keep ids positive ints
+    static constexpr uint64_t kMaxClientSeq = (INT_MAX - kClientShards) / kClientShards + 1;
+
     int port_;
-    int sockfd_ = -1;
+    UdpServerOptions options_;
+    std::vector<int> socks_;  // one per worker, all bound to port_
     std::atomic<bool> running_{false};
-    Callback callback_;
 
-    std::unordered_map<uint64_t, int> client_map_;
-    int next_client_id_ = 1;
+    // Deferred replies send under a shared lock; stop() closes the sockets under the
+    // exclusive one and moves to the next generation, which retires every handle
+    std::shared_mutex sockets_mutex_;
+    uint64_t generation_ = 0;
+    DatagramHandler handler_;
+    bool gro_ = false;
+    std::atomic<bool> gso_{false};  // cleared when a GSO send is refused
+
+    std::array<ClientShard, kClientShards> client_shards_;
+    ExpiryCallback expiryCallback_;
+    std::atomic<int64_t> next_sweep_ms_{0};
+    LatencyHistogram latency_;
 
-    std::thread worker_;
+    std::vector<std::thread> workers_;
 };
@@ -6,15 +6,61 @@
 #include <vector>
 
 #include "error.h"
+#include "socket/busy_poll.h"
+#include "socket/socket_options.h"
 
 enum class ServerType { TCP, UDP };
 struct ServerConfig {
     int port;
+    // TLS is used when public_key is set (asio and POSIX TCP servers). Key material is PEM
+    // text or a path to a PEM file.
     struct SSLConfig {
-        std::string public_key;
+        std::string public_key;   // certificate chain
+        std::string private_key;  // key of the first certificate
+        bool ktls = true;         // let the kernel encrypt records when it supports kTLS
     } ssl_config;
-    enum class BackendType { ASIO, POSIX } backend_type = BackendType::POSIX;
+    enum class BackendType { ASIO, POSIX, IO_URING } backend_type = BackendType::POSIX;
     ServerType connection_type = ServerType::TCP;
+
+    // Readiness mechanism used by the POSIX TcpServer event loop.
+    // SELECT is limited to FD_SETSIZE descriptors; EPOLL registers each fd once
+    // (edge-triggered) and only pays for fds that are actually active.
+    enum class EventLoopType { SELECT, EPOLL } event_loop = EventLoopType::SELECT;
+
+    // Number of reactor threads (shards) for the POSIX TcpServer. With more than one,
+    // every shard owns an SO_REUSEPORT listener, an event loop and a connection table,
+    // and the kernel spreads incoming connections across them.
+    // TcpServerAsio runs this many I/O threads according to asio_execution.
+    int threads = 1;
+
+    // How TcpServerAsio uses its threads.
+    // CONTEXT_PER_THREAD: one io_context per thread, accepted sockets assigned round-robin.
+    //   Handlers never cross threads and need no locking, so this is normally the faster
+    //   model; a connection stays on its thread, so a few heavy connections can leave
+    //   threads unevenly loaded.
+    // SHARED_CONTEXT: one io_context run by every thread, each connection on its own strand.
+    //   Work from any connection goes to any idle thread, which balances uneven load and
+    //   tolerates slow handlers, at the cost of a shared scheduler queue and strand hops.
+    enum class AsioExecution {
+        CONTEXT_PER_THREAD,
+        SHARED_CONTEXT
+    } asio_execution = AsioExecution::CONTEXT_PER_THREAD;
+
+    // Pin shard i to CPU i and steer each connection to the shard running on the CPU
+    // that received it (reuseport CBPF program + SO_INCOMING_CPU). Needs threads > 1.
+    bool cpu_steering = false;
+
+    // Per-connection bytes the POSIX TcpServer may queue for a slow reader before send()
+    // starts failing with SEND_FAILED (and notifying the backpressure callback).
+    size_t send_high_water_mark = 4 * 1024 * 1024;
+
+    // Socket tuning for listeners and accepted connections, e.g. SocketOptions::low_latency()
+    SocketOptions socket_options;
+
+    // Busy-poll mode of the POSIX TcpServer: each shard runs the epoll loop (whatever
+    // event_loop says) and spins on it instead of sleeping; busy_poll.cpu pins shard i to
+    // cpu + i. See TcpServer::latency_stats() for measure_latency.
+    BusyPollOptions busy_poll;
 };
 
 class ServerInterface {
@@ -0,0 +1,424 @@
+#include "server/uring/tcp_server.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <iostream>
+
+Error TcpServerUring::listen() {
+    server_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (server_fd_ < 0) {
+        Error err;
+        err.set_code(ErrorCode::CONNECTION_FAILED)->set_message("Failed to create TCP socket");
+        return err;
+    }
+
+    int opt = 1;
+    setsockopt(server_fd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    cfg_.socket_options.apply(server_fd_);
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = INADDR_ANY;
+    addr.sin_port = htons(cfg_.port);
+
+    Error err;
+    if (::bind(server_fd_, (sockaddr*)&addr, sizeof(addr)) < 0) {
+        if (errno == EADDRINUSE) {
+            err.set_code(ErrorCode::PORT_IN_USE)->set_message("Port is already in use");
+        } else {
+            err.set_code(ErrorCode::CONNECTION_FAILED)->set_message("Bind failed");
+        }
+    } else if (::listen(server_fd_, SOMAXCONN) < 0) {
+        err.set_code(ErrorCode::CONNECTION_FAILED)->set_message("Listen failed");
+    } else {
+        err = ring_.init(kRingEntries);
+        if (err.code() == ErrorCode::NO_ERROR)
+            err = ring_.setup_buffer_ring(kBufferGroup, kBufferCount, kBufferSize);
+    }
+
+    if (err.code() != ErrorCode::NO_ERROR) {
+        ring_.close();
+        close(server_fd_);
+        server_fd_ = -1;
+        return err;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        arm_accept_locked();  // submitted by the first io_uring_enter() of the loop
+    }
+
+    running_ = true;
+    stop_ = false;
+    worker_ = std::thread([this]() { this->run(); });
+
+    return Error();
+}
+
+void TcpServerUring::run() {
+    while (!stop_) {
+        unsigned to_submit;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            to_submit = ring_.flush();
+        }
+
+        // One syscall submits everything queued since the last pass and waits for completions
+        int ret = ring_.enter(to_submit, 1, 200);
+        if (ret < 0 && ret != -ETIME && ret != -EINTR && ret != -EBUSY)
+            std::cerr << "[SERVER] io_uring_enter() failed: " << strerror(-ret) << std::endl;
+
+        ring_.for_each_cqe([this](const io_uring_cqe& cqe) { handle_completion(cqe); });
+    }
+}
+
+void TcpServerUring::handle_completion(const io_uring_cqe& cqe) {
+    Op op = static_cast<Op>(cqe.user_data >> 56);
+    int conn_id = static_cast<int>(cqe.user_data & 0xFFFFFFFF);
+
+    switch (op) {
+        case OP_ACCEPT:
+            on_accept(cqe);
+            break;
+        case OP_RECV:
+            on_recv(conn_id, cqe);
+            break;
+        case OP_SEND:
+            on_send(conn_id, cqe);
+            break;
+        case OP_WAKE:
+        case OP_CANCEL:
+            break;
+    }
+}
+
+void TcpServerUring::on_accept(const io_uring_cqe& cqe) {
+    if (cqe.res >= 0) {
+        int fd = cqe.res;
+        cfg_.socket_options.apply(fd);
+
+        // Multishot accept cannot return the peer address, ask the socket instead
+        sockaddr_in peer{};
+        socklen_t len = sizeof(peer);
+        getpeername(fd, reinterpret_cast<sockaddr*>(&peer), &len);
+        char ipstr[INET_ADDRSTRLEN] = {0};
+        inet_ntop(AF_INET, &peer.sin_addr, ipstr, sizeof(ipstr));
+
+        int conn_id;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            conn_id = next_conn_id_++;
+            Connection& conn = connections_[conn_id];
+            conn.fd = fd;
+            conn.ip = ipstr;
+            if (!arm_recv_locked(conn_id, conn)) {
+                connections_.erase(conn_id);
+                close(fd);
+                conn_id = -1;
+            }
+        }
+
+        if (conn_id < 0)
+            std::cerr << "[SERVER] io_uring SQ full, dropped connection from " << ipstr
+                      << std::endl;
+        else if (clientConnectionCallback_)
+            clientConnectionCallback_(conn_id, ipstr);
+    } else if (cqe.res != -ECANCELED && !stop_) {
+        std::cerr << "[SERVER] io_uring accept failed: " << strerror(-cqe.res) << std::endl;
+    }
+
+    if (!(cqe.flags & IORING_CQE_F_MORE)) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        accept_armed_ = false;
+        if (!stop_ && !arm_accept_locked())
+            std::cerr << "[SERVER] io_uring SQ full, accept not re-armed" << std::endl;
+    }
+}
+
+void TcpServerUring::on_recv(int conn_id, const io_uring_cqe& cqe) {
+    const bool more = cqe.flags & IORING_CQE_F_MORE;
+
+    std::vector<uint8_t> data;
+    if ((cqe.flags & IORING_CQE_F_BUFFER) && cqe.res > 0) {
+        uint16_t bid = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+        const uint8_t* buf = ring_.buffer(bid);
+        data.assign(buf, buf + cqe.res);
+    }
+
+    std::string ip;
+    bool deliver = false;
+    bool disconnected = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (cqe.flags & IORING_CQE_F_BUFFER)
+            ring_.recycle_buffer(static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT));
+
+        auto it = connections_.find(conn_id);
+        if (it == connections_.end())
+            return;
+        Connection& conn = it->second;
+        ip = conn.ip;
+
+        if (cqe.res > 0 && !conn.closing) {
+            cfg_.socket_options.rearm_quickack(conn.fd);
+            deliver = true;
+        } else if (cqe.res == -ENOBUFS && !conn.closing) {
+            // Buffer ring ran dry; the request ends and is re-armed below
+        } else if (!conn.closing) {
+            close_connection_locked(conn_id, conn);
+            disconnected = true;
+        }
+
+        if (!more) {
+            if (!conn.closing && !stop_ && !arm_recv_locked(conn_id, conn)) {
+                close_connection_locked(conn_id, conn);
+                disconnected = true;
+            }
+            release_op_locked(conn_id, conn);
+        }
+    }
+
+    if (deliver && recieveCallback_)
+        recieveCallback_(conn_id, ip, data);
+    if (disconnected && clientDisconnectCallback_)
+        clientDisconnectCallback_(conn_id, ip);
+}
+
+void TcpServerUring::on_send(int conn_id, const io_uring_cqe& cqe) {
+    std::string ip;
+    bool disconnected = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = connections_.find(conn_id);
+        if (it == connections_.end())
+            return;
+        Connection& conn = it->second;
+        ip = conn.ip;
+
+        if (cqe.res < 0) {
+            if (!conn.closing) {
+                close_connection_locked(conn_id, conn);
+                disconnected = true;
+            }
+        } else if (!conn.closing) {
+            conn.inflight_offset += cqe.res;
+            if (conn.inflight_offset >= conn.inflight.size()) {
+                conn.inflight.clear();
+                conn.inflight_offset = 0;
+            }
+            // Short write resumes the same buffer; otherwise the next batch goes out
+            if ((!conn.inflight.empty() || !conn.pending.empty()) &&
+                !start_send_locked(conn_id, conn)) {
+                close_connection_locked(conn_id, conn);
+                disconnected = true;
+            }
+        }
+
+        release_op_locked(conn_id, conn);
+    }
+
+    if (disconnected && clientDisconnectCallback_)
+        clientDisconnectCallback_(conn_id, ip);
+}
+
+Error TcpServerUring::send(int fd, const std::vector<uint8_t>& data) {
+    unsigned to_submit = 0;
+    bool closed = false;
+    std::string ip;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = connections_.find(fd);
+        if (it == connections_.end() || it->second.closing) {
+            return *Error().set_code(ErrorCode::NOT_CONNECTED)
+                        ->set_message("Connection not found.");
+        }
+
+        Connection& conn = it->second;
+        conn.pending.push_back(data);
+        if (conn.inflight.empty() && !start_send_locked(fd, conn)) {
+            // The batch moved to inflight can't be retried in order: drop the connection
+            ip = conn.ip;
+            close_connection_locked(fd, conn);
+            closed = true;
+        }
+
+        // Sends issued from callbacks ride along with the loop's next io_uring_enter()
+        if (std::this_thread::get_id() != worker_.get_id())
+            to_submit = ring_.flush();
+    }
+
+    if (closed) {
+        if (clientDisconnectCallback_)
+            clientDisconnectCallback_(fd, ip);
+        return *Error().set_code(ErrorCode::SEND_FAILED)->set_message("io_uring SQ full");
+    }
+    if (to_submit > 0) {
+        int ret = ring_.enter(to_submit, 0, -1);
+        if (ret < 0)
+            return *Error().set_code(ErrorCode::SEND_FAILED)->set_message(strerror(-ret));
+    }
+    return Error();
+}
+
+Error TcpServerUring::send(const std::string& ip, const std::vector<uint8_t>& data) {
+    int conn_id = -1;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& [id, conn] : connections_) {
+            if (conn.ip == ip && !conn.closing) {
+                conn_id = id;
+                break;
+            }
+        }
+    }
+    if (conn_id < 0)
+        return *Error().set_code(ErrorCode::NOT_CONNECTED)->set_message("IP not found.");
+    return send(conn_id, data);
+}
+
+Error TcpServerUring::gracefull_shutdown() {
+    if (!running_)
+        return Error();
+
+    running_ = false;
+    stop_ = true;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        wake_locked();
+    }
+    if (worker_.joinable())
+        worker_.join();
+
+    // Cancel every request and reap the completions, so the kernel is done with our send
+    // buffers and buffer ring before they are released.
+    auto outstanding = [this]() {
+        int ops = accept_armed_ ? 1 : 0;
+        for (const auto& [id, conn] : connections_) ops += conn.ops;
+        return ops;
+    };
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& [id, conn] : connections_) {
+            if (!conn.closing)
+                close_connection_locked(id, conn);
+        }
+        if (io_uring_sqe* sqe = ring_.get_sqe()) {
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            sqe->fd = server_fd_;
+            sqe->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+            sqe->user_data = user_data(OP_CANCEL, 0);
+        }
+        ring_.enter(ring_.flush(), 0, -1);
+    }
+
+    for (int i = 0; i < 50 && outstanding() > 0; ++i) {
+        ring_.enter(0, 1, 20);
+        ring_.for_each_cqe([this](const io_uring_cqe& cqe) { handle_completion(cqe); });
+    }
+
+    for (auto& [id, conn] : connections_) close(conn.fd);
+    connections_.clear();
+    ring_.close();
+
+    if (server_fd_ >= 0) {
+        close(server_fd_);
+        server_fd_ = -1;
+    }
+    return Error();
+}
+
+bool TcpServerUring::arm_accept_locked() {
+    io_uring_sqe* sqe = ring_.get_sqe_or_flush();
+    if (!sqe)
+        return false;
+
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = server_fd_;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    sqe->user_data = user_data(OP_ACCEPT, 0);
+    accept_armed_ = true;
+    return true;
+}
+
+bool TcpServerUring::arm_recv_locked(int conn_id, Connection& conn) {
+    io_uring_sqe* sqe = ring_.get_sqe_or_flush();
+    if (!sqe)
+        return false;
+
+    // Multishot: one request keeps producing a completion per received chunk
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = conn.fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = kBufferGroup;
+    sqe->user_data = user_data(OP_RECV, conn_id);
+    ++conn.ops;
+    return true;
+}
+
+bool TcpServerUring::start_send_locked(int conn_id, Connection& conn) {
+    // Gather everything queued into a single send, one write stays in flight per connection
+    if (conn.inflight.empty()) {
+        if (conn.pending.size() == 1) {
+            conn.inflight = std::move(conn.pending.front());
+        } else {
+            for (auto& chunk : conn.pending)
+                conn.inflight.insert(conn.inflight.end(), chunk.begin(), chunk.end());
+        }
+        conn.pending.clear();
+        conn.inflight_offset = 0;
+    }
+
+    io_uring_sqe* sqe = ring_.get_sqe_or_flush();
+    if (!sqe)
+        return false;
+
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = conn.fd;
+    sqe->addr = reinterpret_cast<uint64_t>(conn.inflight.data() + conn.inflight_offset);
+    sqe->len = static_cast<uint32_t>(conn.inflight.size() - conn.inflight_offset);
+    // Only the rest of a partial send can have messages queued behind it; with tcp_cork
+    // its last partial segment then waits for them
+    sqe->msg_flags = MSG_NOSIGNAL | cfg_.socket_options.more_flag(!conn.pending.empty());
+    sqe->user_data = user_data(OP_SEND, conn_id);
+    ++conn.ops;
+    return true;
+}
+
+void TcpServerUring::close_connection_locked(int conn_id, Connection& conn) {
+    conn.closing = true;
+    conn.pending.clear();
+    ::shutdown(conn.fd, SHUT_RDWR);
+
+    if (io_uring_sqe* sqe = ring_.get_sqe_or_flush()) {
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = conn.fd;
+        sqe->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+        sqe->user_data = user_data(OP_CANCEL, conn_id);
+    }
+}
+
+void TcpServerUring::release_op_locked(int conn_id, Connection& conn) {
+    --conn.ops;
+    if (conn.closing && conn.ops <= 0) {
+        close(conn.fd);
+        connections_.erase(conn_id);
+    }
+}
+
+void TcpServerUring::wake_locked() {
+    if (!ring_.valid())
+        return;
+    if (io_uring_sqe* sqe = ring_.get_sqe()) {
+        sqe->opcode = IORING_OP_NOP;
+        sqe->user_data = user_data(OP_WAKE, 0);
+    }
+    ring_.enter(ring_.flush(), 0, -1);
+}
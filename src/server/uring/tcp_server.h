@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "error.h"
+#include "server/server_interface.h"
+#include "uring/ring.h"
+
+// io_uring TCP server: one multishot accept, one multishot recv per connection fed from a
+// provided buffer ring, and sends batched into the next io_uring_enter() of the loop thread.
+class TcpServerUring : public ServerInterface {
+    struct Connection {
+        int fd = -1;
+        std::string ip;
+        std::deque<std::vector<uint8_t>> pending;  // queued while a send is in flight
+        std::vector<uint8_t> inflight;
+        size_t inflight_offset = 0;
+        int ops = 0;  // sqes owned by the kernel; the record outlives them
+        bool closing = false;
+    };
+
+  public:
+    TcpServerUring(ServerConfig cfg, ReceiveCallback receiveCallback,
+                   ClientConnectCallback clientConnectCallback,
+                   ClientDisconnectCallback clientDisconnectCallback)
+        : ServerInterface(cfg, receiveCallback, clientConnectCallback, clientDisconnectCallback) {}
+
+    ~TcpServerUring() override { gracefull_shutdown(); }
+
+    // Listen and start the completion loop
+    Error listen() override;
+
+    // Send data to client by "fd" (Here, fd is actually the internal connection id)
+    Error send(int fd, const std::vector<uint8_t>& data) override;
+
+    // Send data to client by IP (send to first matching IP)
+    Error send(const std::string& ip, const std::vector<uint8_t>& data) override;
+
+    Error gracefull_shutdown() override;
+
+  private:
+    enum Op : uint64_t { OP_WAKE = 1, OP_ACCEPT, OP_RECV, OP_SEND, OP_CANCEL };
+
+    static uint64_t user_data(Op op, int conn_id) {
+        return (uint64_t(op) << 56) | uint32_t(conn_id);
+    }
+
+    void run();
+    void handle_completion(const io_uring_cqe& cqe);
+    void on_accept(const io_uring_cqe& cqe);
+    void on_recv(int conn_id, const io_uring_cqe& cqe);
+    void on_send(int conn_id, const io_uring_cqe& cqe);
+
+    // The *_locked helpers prepare sqes and expect mutex_ to be held. They return false when
+    // the SQ is still full after submitting it.
+    bool arm_accept_locked();
+    bool arm_recv_locked(int conn_id, Connection& conn);
+    bool start_send_locked(int conn_id, Connection& conn);
+    void close_connection_locked(int conn_id, Connection& conn);
+    void release_op_locked(int conn_id, Connection& conn);
+    void wake_locked();
+
+  private:
+    static constexpr unsigned kRingEntries = 1024;
+    static constexpr unsigned kBufferCount = 1024;
+    static constexpr unsigned kBufferSize = 4096;
+    static constexpr uint16_t kBufferGroup = 0;
+
+    int server_fd_ = -1;
+    UringRing ring_;
+    std::thread worker_;
+    std::atomic<bool> stop_{false};
+
+    std::mutex mutex_;  // guards the SQ side of ring_ and connections_
+    std::unordered_map<int, Connection> connections_;
+    int next_conn_id_ = 1;
+    bool accept_armed_ = false;
+};
@@ -0,0 +1,89 @@
+#include "socket/busy_poll.h"
+
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+
+#ifndef SO_PREFER_BUSY_POLL
+#define SO_PREFER_BUSY_POLL 69
+#endif
+#ifndef SO_BUSY_POLL_BUDGET
+#define SO_BUSY_POLL_BUDGET 70
+#endif
+
+namespace {
+
+    inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield");
+#endif
+    }
+
+}  // namespace
+
+void BusyPollOptions::apply(int fd) const {
+    auto set = [fd](int name, int value) {
+        setsockopt(fd, SOL_SOCKET, name, &value, sizeof(value));
+    };
+
+    if (measure_latency)
+        set(SO_TIMESTAMPNS, 1);
+    if (!enabled)
+        return;
+    if (socket_busy_poll_us > 0)
+        set(SO_BUSY_POLL, socket_busy_poll_us);
+    if (prefer_busy_poll)
+        set(SO_PREFER_BUSY_POLL, 1);
+    if (busy_poll_budget > 0)
+        set(SO_BUSY_POLL_BUDGET, busy_poll_budget);
+}
+
+bool BusyPollOptions::pin(std::thread& thread, int offset) const {
+    if (cpu < 0)
+        return false;
+    const unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET((cpu + offset) % cpus, &set);
+    return pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set) == 0;
+}
+
+BusySpinner::BusySpinner(const BusyPollOptions& options)
+    : enabled_(options.enabled),
+      spin_forever_(options.spin_window.count() < 0),
+      window_(options.spin_window),
+      last_event_(Clock::now()),
+      spinning_(options.enabled) {}
+
+void BusySpinner::update(bool had_events) {
+    if (!enabled_)
+        return;
+    if (had_events) {
+        spinning_ = true;
+        if (!spin_forever_)
+            last_event_ = Clock::now();
+        return;
+    }
+    if (!spinning_)
+        return;
+    if (!spin_forever_ && Clock::now() - last_event_ >= window_) {
+        spinning_ = false;  // quiet period: block until the next event
+        return;
+    }
+    cpu_relax();
+}
+
+void BusySpinner::wait_readable(int fd, int block_ms) {
+    update(false);
+    const int timeout = timeout_ms(block_ms);
+    if (timeout == 0)
+        return;
+    pollfd pfd{fd, POLLIN, 0};
+    if (poll(&pfd, 1, timeout) > 0)
+        update(true);
+}
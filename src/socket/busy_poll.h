@@ -0,0 +1,57 @@
+#pragma once
+
+#include <chrono>
+#include <thread>
+
+// Busy-poll mode of the POSIX event loops (TcpServer, UdpServer, ClientReactor).
+//
+// While traffic flows the loop thread never sleeps: it polls its sockets without blocking
+// (epoll_wait() with a zero timeout, MSG_DONTWAIT reads) and the kernel spins on the device
+// queue inside each call (SO_BUSY_POLL, SO_PREFER_BUSY_POLL), so no interrupt-to-wakeup
+// latency is paid. After spin_window without traffic the loop blocks as usual until the next
+// event and spins again once woken (spin-then-block). A negative window spins forever, which
+// is meant for a dedicated core (isolcpus) selected with `cpu`.
+struct BusyPollOptions {
+    bool enabled = false;
+    std::chrono::microseconds spin_window{-1};
+    int cpu = -1;                  // pin loop thread i to cpu + i, -1 leaves it unpinned
+    int socket_busy_poll_us = 50;  // SO_BUSY_POLL on the polled sockets, 0 leaves it
+    bool prefer_busy_poll = true;  // SO_PREFER_BUSY_POLL: keep NAPI polling in the loop
+    int busy_poll_budget = 0;      // SO_BUSY_POLL_BUDGET, 0 keeps the kernel default
+
+    // Record receive-to-callback latency (kernel receive timestamp to the handler call).
+    // Works in blocking mode too, so both modes can be compared.
+    bool measure_latency = false;
+
+    // Set the socket options above on fd (SO_TIMESTAMPNS when measuring); best effort
+    void apply(int fd) const;
+
+    // Pin thread to cpu + offset; false when cpu is unset or the call failed
+    bool pin(std::thread& thread, int offset) const;
+};
+
+// Spin-then-block bookkeeping of one loop thread
+class BusySpinner {
+  public:
+    explicit BusySpinner(const BusyPollOptions& options);
+
+    // Timeout for the next wait: 0 while spinning, block_ms otherwise (always when
+    // busy polling is off)
+    int timeout_ms(int block_ms) const { return spinning_ ? 0 : block_ms; }
+
+    // Report whether the last wait or read found work
+    void update(bool had_events);
+
+    // After a non-blocking read found nothing: returns at once while spinning, otherwise
+    // waits in poll() up to block_ms for fd to become readable
+    void wait_readable(int fd, int block_ms);
+
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    bool enabled_;
+    bool spin_forever_;
+    Clock::duration window_;
+    Clock::time_point last_event_;
+    bool spinning_;
+};
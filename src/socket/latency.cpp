@@ -0,0 +1,100 @@
+#include "socket/latency.h"
+
+#include <time.h>
+
+#include <algorithm>
+#include <cstring>
+
+int LatencyHistogram::bucket_of(uint64_t ns) {
+    constexpr uint64_t kSub = 1u << kSubBits;
+    if (ns < kSub)
+        return static_cast<int>(ns);
+    const int msb = 63 - __builtin_clzll(ns);
+    const int shift = msb - kSubBits;
+    return ((shift + 1) << kSubBits) + static_cast<int>((ns >> shift) & (kSub - 1));
+}
+
+uint64_t LatencyHistogram::value_of(int bucket) {
+    constexpr int kSub = 1 << kSubBits;
+    if (bucket < kSub)
+        return bucket;
+    const int shift = bucket / kSub - 1;
+    const uint64_t low = uint64_t(kSub + bucket % kSub) << shift;
+    return low + (uint64_t(1) << shift) / 2;
+}
+
+void LatencyHistogram::record(int64_t ns) {
+    if (ns < 0)
+        ns = 0;  // clock adjustments
+    counts_[bucket_of(ns)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+
+    int64_t seen = max_.load(std::memory_order_relaxed);
+    while (ns > seen && !max_.compare_exchange_weak(seen, ns, std::memory_order_relaxed)) {
+    }
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (int i = 0; i < kBuckets; ++i) {
+        uint64_t n = other.counts_[i].load(std::memory_order_relaxed);
+        if (n)
+            counts_[i].fetch_add(n, std::memory_order_relaxed);
+    }
+    count_.fetch_add(other.count_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+    int64_t theirs = other.max_.load(std::memory_order_relaxed);
+    int64_t seen = max_.load(std::memory_order_relaxed);
+    while (theirs > seen &&
+           !max_.compare_exchange_weak(seen, theirs, std::memory_order_relaxed)) {
+    }
+}
+
+LatencyStats LatencyHistogram::stats() const {
+    LatencyStats out;
+    uint64_t total = 0;
+    for (const auto& c : counts_) total += c.load(std::memory_order_relaxed);
+    out.count = total;
+    out.max = std::chrono::nanoseconds(max_.load(std::memory_order_relaxed));
+    if (total == 0)
+        return out;
+
+    // Smallest bucket whose cumulative count reaches the rank, capped by the exact maximum
+    auto percentile = [&](double p) {
+        const uint64_t rank = std::max<uint64_t>(1, uint64_t(p * total + 0.999999));
+        uint64_t seen = 0;
+        for (int i = 0; i < kBuckets; ++i) {
+            seen += counts_[i].load(std::memory_order_relaxed);
+            if (seen >= rank)
+                return std::min(std::chrono::nanoseconds(value_of(i)), out.max);
+        }
+        return out.max;
+    };
+    out.p50 = percentile(0.50);
+    out.p99 = percentile(0.99);
+    out.p999 = percentile(0.999);
+    return out;
+}
+
+int64_t LatencyHistogram::rx_timestamp_ns(const msghdr& msg) {
+    auto* m = const_cast<msghdr*>(&msg);
+    for (cmsghdr* cm = CMSG_FIRSTHDR(m); cm; cm = CMSG_NXTHDR(m, cm)) {
+        if (cm->cmsg_level == SOL_SOCKET && cm->cmsg_type == SCM_TIMESTAMPNS) {
+            timespec ts;
+            std::memcpy(&ts, CMSG_DATA(cm), sizeof(ts));
+            return int64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+        }
+    }
+    return 0;
+}
+
+int64_t LatencyHistogram::realtime_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return int64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+void LatencyHistogram::record_since_rx(const msghdr& msg) {
+    const int64_t rx = rx_timestamp_ns(msg);
+    if (rx > 0)
+        record(realtime_ns() - rx);
+}
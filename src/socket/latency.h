@@ -0,0 +1,52 @@
+#pragma once
+
+#include <sys/socket.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Receive-to-callback latency percentiles, see BusyPollOptions::measure_latency
+struct LatencyStats {
+    uint64_t count = 0;
+    std::chrono::nanoseconds p50{0};
+    std::chrono::nanoseconds p99{0};
+    std::chrono::nanoseconds p999{0};
+    std::chrono::nanoseconds max{0};
+};
+
+// Log-linear histogram of nanosecond samples: 16 buckets per power of two, so percentiles
+// are within ~3%. Recording is a relaxed atomic increment; any thread may record or read.
+class LatencyHistogram {
+  public:
+    void record(int64_t ns);
+
+    // Add the samples of other into this histogram
+    void merge(const LatencyHistogram& other);
+
+    LatencyStats stats() const;
+
+    // Kernel receive time (SO_TIMESTAMPNS) of a recvmsg() result, 0 when absent
+    static int64_t rx_timestamp_ns(const msghdr& msg);
+
+    // Now on the clock of rx_timestamp_ns()
+    static int64_t realtime_ns();
+
+    // Records realtime_ns() - the message's receive time, when it carries one
+    void record_since_rx(const msghdr& msg);
+
+    // Control buffer size for a recvmsg() that should carry the timestamp
+    static constexpr size_t kControlSize = CMSG_SPACE(sizeof(timespec));
+
+  private:
+    static constexpr int kSubBits = 4;
+    static constexpr int kBuckets = 64 << kSubBits;
+
+    static int bucket_of(uint64_t ns);
+    static uint64_t value_of(int bucket);  // midpoint of the bucket's range
+
+    std::array<std::atomic<uint64_t>, kBuckets> counts_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<int64_t> max_{0};
+};
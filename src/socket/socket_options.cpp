@@ -0,0 +1,78 @@
+#include "socket/socket_options.h"
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+SocketOptions SocketOptions::low_latency() {
+    SocketOptions opts;
+    opts.tcp_nodelay = true;
+    opts.tcp_quickack = true;
+    opts.busy_poll_us = 50;
+    opts.notsent_lowat = 16 * 1024;
+    opts.tos = 0x80;  // CS4
+    return opts;
+}
+
+SocketOptions SocketOptions::bulk_throughput() {
+    SocketOptions opts;
+    opts.tcp_cork = true;
+    opts.send_buffer = 4 * 1024 * 1024;
+    opts.receive_buffer = 4 * 1024 * 1024;
+    opts.tos = 0x20;  // CS1
+    return opts;
+}
+
+bool SocketOptions::apply(int fd) const {
+    int type = 0;
+    int domain = 0;
+    socklen_t len = sizeof(type);
+    if (getsockopt(fd, SOL_SOCKET, SO_TYPE, &type, &len) != 0)
+        return false;
+    len = sizeof(domain);
+    if (getsockopt(fd, SOL_SOCKET, SO_DOMAIN, &domain, &len) != 0)
+        return false;
+
+    bool ok = true;
+    auto set = [&](int level, int name, int value) {
+        if (setsockopt(fd, level, name, &value, sizeof(value)) != 0)
+            ok = false;
+    };
+
+    if (send_buffer > 0)
+        set(SOL_SOCKET, SO_SNDBUF, send_buffer);
+    if (receive_buffer > 0)
+        set(SOL_SOCKET, SO_RCVBUF, receive_buffer);
+    if (busy_poll_us > 0)
+        set(SOL_SOCKET, SO_BUSY_POLL, busy_poll_us);
+    if (tos >= 0) {
+        if (domain == AF_INET6)
+            set(IPPROTO_IPV6, IPV6_TCLASS, tos);
+        else
+            set(IPPROTO_IP, IP_TOS, tos);
+    }
+
+    if (type != SOCK_STREAM)
+        return ok;
+
+    if (tcp_nodelay)
+        set(IPPROTO_TCP, TCP_NODELAY, 1);
+    if (tcp_quickack)
+        set(IPPROTO_TCP, TCP_QUICKACK, 1);
+    if (notsent_lowat > 0)
+        set(IPPROTO_TCP, TCP_NOTSENT_LOWAT, notsent_lowat);
+    if (user_timeout_ms > 0)
+        set(IPPROTO_TCP, TCP_USER_TIMEOUT, user_timeout_ms);
+    return ok;
+}
+
+void SocketOptions::rearm_quickack(int fd) const {
+    if (!tcp_quickack)
+        return;
+    int on = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_QUICKACK, &on, sizeof(on));
+}
+
+int SocketOptions::more_flag(bool more_follows) const {
+    return tcp_cork && more_follows ? MSG_MORE : 0;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+// Socket tuning shared by NetworkConfig and ServerConfig.
+//
+// Every backend applies the profile to the sockets it creates: client sockets before
+// connect(), listeners before listen() (accepted sockets inherit the buffer sizes, which
+// also sizes the window scale of the handshake) and each accepted socket. Zero / false /
+// -1 leaves the kernel default. Options the kernel refuses (e.g. SO_BUSY_POLL above the
+// sysctl without CAP_NET_ADMIN) are skipped, the others still apply.
+struct SocketOptions {
+    bool tcp_nodelay = false;   // TCP_NODELAY: send small writes at once instead of Nagle
+    bool tcp_quickack = false;  // TCP_QUICKACK, re-armed after every read (Linux drops it)
+    bool tcp_cork = false;      // MSG_MORE on queued writes that have more queued behind them
+    int send_buffer = 0;        // SO_SNDBUF bytes, 0 keeps autotuning
+    int receive_buffer = 0;     // SO_RCVBUF bytes, 0 keeps autotuning
+    int busy_poll_us = 0;       // SO_BUSY_POLL: spin on the device queue before sleeping
+    int notsent_lowat = 0;      // TCP_NOTSENT_LOWAT: bytes unsent before writable again
+    int user_timeout_ms = 0;    // TCP_USER_TIMEOUT: drop when data stays unacked this long
+    int tos = -1;               // IP_TOS / IPV6_TCLASS (DSCP << 2)
+
+    // Request/response traffic: no Nagle, immediate ACKs, short busy poll, a small unsent
+    // backlog so queued replies are not stuck behind bulk data, low-delay DSCP (CS4)
+    static SocketOptions low_latency();
+
+    // Streaming: large buffers and corked queue flushes so the kernel sends full segments
+    static SocketOptions bulk_throughput();
+
+    // Set the options on fd; false when any of them was refused
+    bool apply(int fd) const;
+
+    // Call after a read when tcp_quickack is set
+    void rearm_quickack(int fd) const;
+
+    // send() flags for one of several queued writes. tcp_cork is honored by the POSIX and
+    // io_uring TCP backends; asio's async_write takes no send flags, so it is ignored there
+    int more_flag(bool more_follows) const;
+};
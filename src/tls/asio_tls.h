@@ -0,0 +1,16 @@
+#pragma once
+
+#include <asio.hpp>
+#include <asio/ssl.hpp>
+
+#include "tls/tls_context.h"
+
+// asio::ssl::context over the SSL_CTX of tls, so asio streams share its session cache.
+// Holds its own reference; tls must outlive the streams since the callbacks reach into it.
+inline asio::ssl::context make_asio_context(TlsContext& tls) {
+    SSL_CTX_up_ref(tls.native());
+    return asio::ssl::context(tls.native());
+}
+
+// Stream over a socket owned elsewhere (the socket outlives it)
+using AsioTlsStream = asio::ssl::stream<asio::ip::tcp::socket&>;
@@ -0,0 +1,212 @@
+#include "tls/tls_context.h"
+
+#include <openssl/err.h>
+#include <openssl/pem.h>
+#include <openssl/x509v3.h>
+
+#include <arpa/inet.h>
+
+namespace {
+
+    // Index of the owning TlsContext in SSL_CTX ex data, and of the peer key in SSL ex data
+    int context_index() {
+        static const int index = SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+        return index;
+    }
+
+    int peer_index() {
+        static const int index = SSL_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+        return index;
+    }
+
+    struct BioDeleter {
+        void operator()(BIO* bio) const { BIO_free(bio); }
+    };
+    using BioPtr = std::unique_ptr<BIO, BioDeleter>;
+
+    // Config values hold either PEM text or the path of a PEM file
+    BioPtr open_pem(const std::string& value) {
+        if (value.rfind("-----BEGIN", 0) == 0)
+            return BioPtr(BIO_new_mem_buf(value.data(), static_cast<int>(value.size())));
+        return BioPtr(BIO_new_file(value.c_str(), "r"));
+    }
+
+    bool is_ip_address(const std::string& host) {
+        in6_addr addr;
+        return inet_pton(AF_INET, host.c_str(), &addr) == 1 ||
+               inet_pton(AF_INET6, host.c_str(), &addr) == 1;
+    }
+
+}  // namespace
+
+TlsContext::~TlsContext() {
+    for (auto& [peer, session] : sessions_) {
+        if (session)
+            SSL_SESSION_free(session);
+    }
+    if (ctx_)
+        SSL_CTX_free(ctx_);
+}
+
+Error TlsContext::last_error(const std::string& what) {
+    std::string message = what;
+    while (unsigned long code = ERR_get_error()) {
+        char buf[256];
+        ERR_error_string_n(code, buf, sizeof(buf));
+        message += ": ";
+        message += buf;
+    }
+    Error err;
+    err.set_code(ErrorCode::SSL_ERROR)->set_message(message);
+    return err;
+}
+
+Error TlsContext::init_client(const NetworkConfig::SSLConfig& cfg) {
+    ctx_ = SSL_CTX_new(TLS_client_method());
+    if (!ctx_)
+        return last_error("SSL_CTX_new failed");
+    SSL_CTX_set_ex_data(ctx_, context_index(), this);
+    SSL_CTX_set_min_proto_version(ctx_, TLS1_2_VERSION);
+    SSL_CTX_set_mode(ctx_, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+    if (cfg.ktls)
+        SSL_CTX_set_options(ctx_, SSL_OP_ENABLE_KTLS);
+
+    // Sessions are kept per peer by on_new_session(), not in OpenSSL's internal cache
+    SSL_CTX_set_session_cache_mode(ctx_,
+                                   SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(ctx_, &TlsContext::on_new_session);
+
+    if (!cfg.verify_peer)
+        return Error();
+
+    BioPtr bio = open_pem(cfg.public_key);
+    if (!bio)
+        return last_error("Cannot open " + cfg.public_key);
+
+    X509_STORE* store = SSL_CTX_get_cert_store(ctx_);
+    int trusted = 0;
+    while (X509* cert = PEM_read_bio_X509(bio.get(), nullptr, nullptr, nullptr)) {
+        X509_STORE_add_cert(store, cert);
+        X509_free(cert);
+        ++trusted;
+    }
+    ERR_clear_error();  // end of input
+    if (trusted == 0) {
+        Error err;
+        err.set_code(ErrorCode::SSL_ERROR)->set_message("No certificate in public_key");
+        return err;
+    }
+    SSL_CTX_set_verify(ctx_, SSL_VERIFY_PEER, nullptr);
+    return Error();
+}
+
+Error TlsContext::init_server(const ServerConfig::SSLConfig& cfg) {
+    ctx_ = SSL_CTX_new(TLS_server_method());
+    if (!ctx_)
+        return last_error("SSL_CTX_new failed");
+    SSL_CTX_set_ex_data(ctx_, context_index(), this);
+    SSL_CTX_set_min_proto_version(ctx_, TLS1_2_VERSION);
+    SSL_CTX_set_mode(ctx_, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+    if (cfg.ktls)
+        SSL_CTX_set_options(ctx_, SSL_OP_ENABLE_KTLS);
+
+    // Stateless tickets (on by default) resume TLS 1.3; the id cache serves TLS 1.2
+    static const unsigned char kSessionContext[] = "network_armory";
+    SSL_CTX_set_session_id_context(ctx_, kSessionContext, sizeof(kSessionContext) - 1);
+    SSL_CTX_set_session_cache_mode(ctx_, SSL_SESS_CACHE_SERVER);
+    // Clients keep one session per peer; a second ticket is a separate small write that
+    // Nagle holds back behind the first until the peer's delayed ACK (~40ms per handshake)
+    SSL_CTX_set_num_tickets(ctx_, 1);
+
+    BioPtr bio = open_pem(cfg.public_key);
+    if (!bio)
+        return last_error("Cannot open " + cfg.public_key);
+    X509* leaf = PEM_read_bio_X509(bio.get(), nullptr, nullptr, nullptr);
+    if (!leaf || SSL_CTX_use_certificate(ctx_, leaf) != 1) {
+        X509_free(leaf);
+        return last_error("Invalid certificate in public_key");
+    }
+    X509_free(leaf);
+    while (X509* cert = PEM_read_bio_X509(bio.get(), nullptr, nullptr, nullptr)) {
+        if (SSL_CTX_add0_chain_cert(ctx_, cert) != 1) {
+            X509_free(cert);
+            return last_error("Invalid chain certificate in public_key");
+        }
+    }
+    ERR_clear_error();  // end of input
+
+    bio = open_pem(cfg.private_key);
+    if (!bio)
+        return last_error("Cannot open private_key");
+    EVP_PKEY* key = PEM_read_bio_PrivateKey(bio.get(), nullptr, nullptr, nullptr);
+    const bool key_ok = key && SSL_CTX_use_PrivateKey(ctx_, key) == 1;
+    EVP_PKEY_free(key);
+    if (!key_ok || SSL_CTX_check_private_key(ctx_) != 1)
+        return last_error("Invalid private_key");
+    return Error();
+}
+
+Error TlsContext::prepare_client(SSL* ssl, const std::string& host, const std::string& peer) {
+    if (SSL_CTX_get_verify_mode(ctx_) & SSL_VERIFY_PEER) {
+        const bool ok = is_ip_address(host)
+                            ? X509_VERIFY_PARAM_set1_ip_asc(SSL_get0_param(ssl), host.c_str())
+                            : SSL_set1_host(ssl, host.c_str());
+        if (ok != 1)
+            return last_error("Cannot verify host " + host);
+    }
+    if (!is_ip_address(host))
+        SSL_set_tlsext_host_name(ssl, host.c_str());
+
+    std::lock_guard<std::mutex> lock(sessions_mutex_);
+    auto it = sessions_.try_emplace(peer, nullptr).first;
+    // The map node, and with it the key, lives as long as the context
+    SSL_set_ex_data(ssl, peer_index(), const_cast<std::string*>(&it->first));
+    if (it->second && SSL_SESSION_is_resumable(it->second))
+        SSL_set_session(ssl, it->second);
+    return Error();
+}
+
+TlsContext::SslPtr TlsContext::accept(int fd) {
+    SslPtr ssl(SSL_new(ctx_));
+    if (!ssl || SSL_set_fd(ssl.get(), fd) != 1)
+        return nullptr;
+    SSL_set_accept_state(ssl.get());
+    return ssl;
+}
+
+bool TlsContext::on_handshake(SSL* ssl) {
+    if (SSL_session_reused(ssl))
+        ++resumed_handshakes_;
+    else
+        ++full_handshakes_;
+
+    BIO* wbio = SSL_get_wbio(ssl);
+    const bool ktls = wbio && BIO_get_ktls_send(wbio);
+    if (ktls)
+        ++ktls_send_;
+    return ktls;
+}
+
+TlsContext::Stats TlsContext::stats() const {
+    Stats out;
+    out.full_handshakes = full_handshakes_;
+    out.resumed_handshakes = resumed_handshakes_;
+    out.ktls_send = ktls_send_;
+    return out;
+}
+
+int TlsContext::on_new_session(SSL* ssl, SSL_SESSION* session) {
+    auto* self =
+        static_cast<TlsContext*>(SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), context_index()));
+    auto* peer = static_cast<const std::string*>(SSL_get_ex_data(ssl, peer_index()));
+    if (!self || !peer)
+        return 0;
+
+    // Keep the newest ticket; returning 1 hands our reference of session to the cache
+    std::lock_guard<std::mutex> lock(self->sessions_mutex_);
+    SSL_SESSION*& slot = self->sessions_[*peer];
+    if (slot)
+        SSL_SESSION_free(slot);
+    slot = session;
+    return 1;
+}
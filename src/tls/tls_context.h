@@ -0,0 +1,74 @@
+#pragma once
+
+#include <openssl/ssl.h>
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "client/client_interface.h"
+#include "error.h"
+#include "server/server_interface.h"
+
+// OpenSSL context shared by every connection of one client or server.
+//
+// Reconnects skip the full handshake: a client keeps the last session (TLS 1.3 ticket) per
+// peer and offers it on the next connect, a server accepts tickets issued under its context.
+// With kTLS enabled, connections on a plain socket BIO (SSL_set_fd) move record encryption
+// into the kernel after the handshake, so sendfile() and plain send() work on them; the
+// asio backends run OpenSSL over memory BIOs and always encrypt in user space.
+class TlsContext {
+  public:
+    struct Stats {
+        uint64_t full_handshakes = 0;
+        uint64_t resumed_handshakes = 0;
+        uint64_t ktls_send = 0;  // connections whose records the kernel encrypts
+    };
+
+    struct SslDeleter {
+        void operator()(SSL* ssl) const { SSL_free(ssl); }
+    };
+    using SslPtr = std::unique_ptr<SSL, SslDeleter>;
+
+    TlsContext() = default;
+    ~TlsContext();
+
+    TlsContext(const TlsContext&) = delete;
+    TlsContext& operator=(const TlsContext&) = delete;
+
+    Error init_client(const NetworkConfig::SSLConfig& cfg);
+    Error init_server(const ServerConfig::SSLConfig& cfg);
+
+    SSL_CTX* native() const { return ctx_; }
+
+    // Client side: SNI, certificate name check and the cached session for `peer` (any key
+    // naming the endpoint, e.g. "ip:port"). New sessions the peer issues are cached under it.
+    Error prepare_client(SSL* ssl, const std::string& host, const std::string& peer);
+
+    // Server side connection over a socket, ready for SSL_do_handshake()
+    SslPtr accept(int fd);
+
+    // Call once per completed handshake; counts it and reports kTLS send offload
+    bool on_handshake(SSL* ssl);
+
+    Stats stats() const;
+
+    // SSL_ERROR with OpenSSL's error queue appended to what
+    static Error last_error(const std::string& what);
+
+  private:
+    static int on_new_session(SSL* ssl, SSL_SESSION* session);
+
+  private:
+    SSL_CTX* ctx_ = nullptr;
+
+    std::mutex sessions_mutex_;
+    std::map<std::string, SSL_SESSION*> sessions_;  // client: last session per peer
+
+    std::atomic<uint64_t> full_handshakes_{0};
+    std::atomic<uint64_t> resumed_handshakes_{0};
+    std::atomic<uint64_t> ktls_send_{0};
+};
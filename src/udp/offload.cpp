@@ -0,0 +1,102 @@
+#include "udp/offload.h"
+
+#include <netinet/udp.h>
+
+#include <cstring>
+
+#include "socket/latency.h"
+
+namespace udp_offload {
+
+    bool enable_gro(int fd) {
+        int on = 1;
+        return setsockopt(fd, IPPROTO_UDP, UDP_GRO, &on, sizeof(on)) == 0;
+    }
+
+    bool gso_supported(int fd) {
+        int size = 0;
+        socklen_t len = sizeof(size);
+        return getsockopt(fd, IPPROTO_UDP, UDP_SEGMENT, &size, &len) == 0;
+    }
+
+    size_t gso_run_length(const iovec* iov, size_t count) {
+        if (count == 0)
+            return 0;
+
+        const size_t segment = iov[0].iov_len;
+        if (segment == 0)
+            return 1;
+
+        size_t total = segment;
+        size_t n = 1;
+        while (n < count && n < kMaxSegments) {
+            const size_t len = iov[n].iov_len;
+            if (len == 0 || len > segment || total + len > kMaxPayload)
+                break;
+            total += len;
+            ++n;
+            if (len < segment)
+                break;  // a short datagram can only end the run
+        }
+        return n;
+    }
+
+    ssize_t send_gso(int fd, const sockaddr* to, socklen_t to_len, const iovec* iov, size_t count,
+                     int flags) {
+        char control[CMSG_SPACE(sizeof(uint16_t))] = {};
+
+        msghdr msg{};
+        msg.msg_name = const_cast<sockaddr*>(to);
+        msg.msg_namelen = to_len;
+        msg.msg_iov = const_cast<iovec*>(iov);
+        msg.msg_iovlen = count;
+
+        if (count > 1) {
+            msg.msg_control = control;
+            msg.msg_controllen = sizeof(control);
+
+            cmsghdr* cm = CMSG_FIRSTHDR(&msg);
+            cm->cmsg_level = IPPROTO_UDP;
+            cm->cmsg_type = UDP_SEGMENT;
+            cm->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+            uint16_t segment = static_cast<uint16_t>(iov[0].iov_len);
+            std::memcpy(CMSG_DATA(cm), &segment, sizeof(segment));
+        }
+
+        return sendmsg(fd, &msg, flags);
+    }
+
+    ssize_t recv_gro(int fd, uint8_t* buf, size_t len, sockaddr_in* from, int* segment_size,
+                     int flags, int64_t* rx_timestamp_ns) {
+        // Room for an SO_TIMESTAMPNS cmsg too: the kernel puts it first, and a truncated
+        // control buffer would lose the segment size
+        char control[CMSG_SPACE(sizeof(int)) + LatencyHistogram::kControlSize] = {};
+        iovec iov{buf, len};
+
+        msghdr msg{};
+        msg.msg_name = from;
+        msg.msg_namelen = sizeof(sockaddr_in);
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        ssize_t n = recvmsg(fd, &msg, flags);
+        *segment_size = 0;
+        if (rx_timestamp_ns)
+            *rx_timestamp_ns = 0;
+        if (n <= 0)
+            return n;
+
+        for (cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm)) {
+            if (cm->cmsg_level == IPPROTO_UDP && cm->cmsg_type == UDP_GRO) {
+                std::memcpy(segment_size, CMSG_DATA(cm), sizeof(int));
+                break;
+            }
+        }
+        if (rx_timestamp_ns)
+            *rx_timestamp_ns = LatencyHistogram::rx_timestamp_ns(msg);
+        return n;
+    }
+
+}  // namespace udp_offload
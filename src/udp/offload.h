@@ -0,0 +1,54 @@
+#pragma once
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <cstddef>
+#include <cstdint>
+
+// UDP segmentation offload helpers (UDP_SEGMENT on send, UDP_GRO on receive).
+//
+// With GSO one sendmsg() carries several equally sized datagrams for the same destination
+// and the kernel (or NIC) cuts them apart; with GRO the kernel hands a socket several
+// datagrams of one flow as a single super-packet plus the segment size.
+namespace udp_offload {
+
+    // Largest payload of one GSO send / GRO read (IPv4 UDP limit)
+    constexpr size_t kMaxPayload = 65507;
+    constexpr size_t kMaxSegments = 64;  // UDP_MAX_SEGMENTS
+
+    // Turn on GRO for fd, false when the kernel does not support it
+    bool enable_gro(int fd);
+
+    // Whether the kernel accepts UDP_SEGMENT on fd
+    bool gso_supported(int fd);
+
+    // Number of leading buffers (at least 1 when count > 0) that can go out as one GSO send:
+    // same non-zero size, only the last may be shorter, within kMaxSegments and kMaxPayload
+    size_t gso_run_length(const iovec* iov, size_t count);
+
+    // sendmsg() of iov[0..count) as datagrams of iov[0].iov_len bytes each
+    ssize_t send_gso(int fd, const sockaddr* to, socklen_t to_len, const iovec* iov, size_t count,
+                     int flags);
+
+    // recvmsg() one (possibly coalesced) packet. `segment_size` receives the GRO segment size,
+    // or 0 when the packet was not coalesced. `rx_timestamp_ns`, if set, receives the kernel
+    // receive time when the socket has SO_TIMESTAMPNS on, else 0.
+    ssize_t recv_gro(int fd, uint8_t* buf, size_t len, sockaddr_in* from, int* segment_size,
+                     int flags, int64_t* rx_timestamp_ns = nullptr);
+
+    // Call fn(data, len) for every datagram of a packet returned by recv_gro()
+    template <typename F>
+    void for_each_segment(const uint8_t* data, size_t len, int segment_size, F&& fn) {
+        if (segment_size <= 0) {
+            fn(data, len);
+            return;
+        }
+        for (size_t off = 0; off < len; off += segment_size) {
+            size_t n = len - off < size_t(segment_size) ? len - off : size_t(segment_size);
+            fn(data + off, n);
+        }
+    }
+
+}  // namespace udp_offload
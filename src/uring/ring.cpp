@@ -0,0 +1,294 @@
+#include "uring/ring.h"
+
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+
+Error UringRing::init(unsigned entries) {
+    io_uring_params p{};
+    int fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &p));
+    if (fd < 0) {
+        Error err;
+        err.set_code(ErrorCode::NOT_IMPLEMENTED)
+            ->set_message(std::string("io_uring_setup failed: ") + strerror(errno));
+        return err;
+    }
+    ring_fd_ = fd;
+
+    if (!(p.features & IORING_FEAT_EXT_ARG)) {
+        close();
+        Error err;
+        err.set_code(ErrorCode::NOT_IMPLEMENTED)->set_message("kernel io_uring lacks EXT_ARG");
+        return err;
+    }
+
+    sq_size_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    cq_size_ = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP)
+        sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+
+    sq_ptr_ = mmap(nullptr, sq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                   IORING_OFF_SQ_RING);
+    if (sq_ptr_ == MAP_FAILED) {
+        sq_ptr_ = nullptr;
+        close();
+        Error err;
+        err.set_code(ErrorCode::INTERNAL_ERROR)->set_message("io_uring SQ mmap failed");
+        return err;
+    }
+
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        cq_ptr_ = sq_ptr_;
+    } else {
+        cq_ptr_ = mmap(nullptr, cq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                       IORING_OFF_CQ_RING);
+        if (cq_ptr_ == MAP_FAILED) {
+            cq_ptr_ = nullptr;
+            close();
+            Error err;
+            err.set_code(ErrorCode::INTERNAL_ERROR)->set_message("io_uring CQ mmap failed");
+            return err;
+        }
+    }
+
+    sqes_size_ = p.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                      IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        close();
+        Error err;
+        err.set_code(ErrorCode::INTERNAL_ERROR)->set_message("io_uring SQE mmap failed");
+        return err;
+    }
+    sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+    auto* sq = static_cast<uint8_t*>(sq_ptr_);
+    sq_head_ = reinterpret_cast<unsigned*>(sq + p.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+    sq_mask_ = reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+    sq_entries_ = p.sq_entries;
+    sqe_tail_ = *sq_tail_;
+
+    // Identity mapping: sqe slot i is always array entry i
+    auto* array = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+    for (unsigned i = 0; i < sq_entries_; ++i) array[i] = i;
+
+    auto* cq = static_cast<uint8_t*>(cq_ptr_);
+    cq_head_ = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+    cq_mask_ = reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+
+    Error ok;
+    return ok;
+}
+
+void UringRing::close() {
+    if (buf_ring_) {
+        munmap(buf_ring_, buf_ring_size_);
+        buf_ring_ = nullptr;
+    }
+    if (sqes_) {
+        munmap(sqes_, sqes_size_);
+        sqes_ = nullptr;
+    }
+    if (cq_ptr_ && cq_ptr_ != sq_ptr_)
+        munmap(cq_ptr_, cq_size_);
+    cq_ptr_ = nullptr;
+    if (sq_ptr_) {
+        munmap(sq_ptr_, sq_size_);
+        sq_ptr_ = nullptr;
+    }
+    if (ring_fd_ >= 0) {
+        ::close(ring_fd_);
+        ring_fd_ = -1;
+    }
+    buffers_.clear();
+}
+
+io_uring_sqe* UringRing::get_sqe() {
+    unsigned head = load_acquire(sq_head_);
+    if (sqe_tail_ - head >= sq_entries_)
+        return nullptr;
+
+    io_uring_sqe* sqe = &sqes_[sqe_tail_ & *sq_mask_];
+    ++sqe_tail_;
+    std::memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+unsigned UringRing::flush() {
+    unsigned published = *sq_tail_;
+    if (published == sqe_tail_)
+        return 0;
+    store_release(sq_tail_, sqe_tail_);
+    return sqe_tail_ - published;
+}
+
+int UringRing::enter(unsigned to_submit, unsigned wait_nr, int timeout_ms) {
+    unsigned flags = wait_nr ? IORING_ENTER_GETEVENTS : 0;
+
+    __kernel_timespec ts{};
+    io_uring_getevents_arg arg{};
+    arg.sigmask_sz = _NSIG / 8;
+    if (wait_nr && timeout_ms >= 0) {
+        ts.tv_sec = timeout_ms / 1000;
+        ts.tv_nsec = static_cast<long long>(timeout_ms % 1000) * 1000000;
+        arg.ts = reinterpret_cast<uint64_t>(&ts);
+    }
+    flags |= IORING_ENTER_EXT_ARG;
+
+    long ret =
+        syscall(__NR_io_uring_enter, ring_fd_, to_submit, wait_nr, flags, &arg, sizeof(arg));
+    return ret < 0 ? -errno : static_cast<int>(ret);
+}
+
+Error UringRing::setup_buffer_ring(uint16_t group, unsigned entries, unsigned buffer_size) {
+    buf_group_ = group;
+    buf_entries_ = entries;
+    buffer_size_ = buffer_size;
+    buffers_.resize(static_cast<size_t>(entries) * buffer_size);
+
+    if (register_buffer_ring(group, entries)) {
+        buf_tail_ = 0;
+        for (unsigned i = 0; i < entries; ++i) recycle_buffer(static_cast<uint16_t>(i));
+        if (probe_buffer_select())
+            return Error();
+
+        // Registered but never handed out: drop it and fall back to provided buffers
+        io_uring_buf_reg reg{};
+        reg.bgid = group;
+        syscall(__NR_io_uring_register, ring_fd_, IORING_UNREGISTER_PBUF_RING, &reg, 1);
+        munmap(buf_ring_, buf_ring_size_);
+        buf_ring_ = nullptr;
+    }
+
+    // Legacy provided buffers: one sqe hands the whole pool to the kernel
+    io_uring_sqe* sqe = get_sqe_or_flush();
+    if (!sqe) {
+        Error err;
+        err.set_code(ErrorCode::INTERNAL_ERROR)->set_message("io_uring SQ full");
+        return err;
+    }
+    sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+    sqe->fd = static_cast<int>(entries);
+    sqe->addr = reinterpret_cast<uint64_t>(buffers_.data());
+    sqe->len = buffer_size;
+    sqe->off = 0;
+    sqe->buf_group = group;
+    sqe->user_data = kInternalUserData;
+    enter(flush(), 0, -1);
+
+    if (!probe_buffer_select()) {
+        Error err;
+        err.set_code(ErrorCode::NOT_IMPLEMENTED)->set_message("io_uring buffer select unsupported");
+        return err;
+    }
+    return Error();
+}
+
+void UringRing::recycle_buffer(uint16_t bid) {
+    uint8_t* addr = buffers_.data() + bid * buffer_size_;
+
+    if (!buf_ring_) {
+        io_uring_sqe* sqe = get_sqe_or_flush();
+        if (!sqe)
+            return;
+        sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+        sqe->fd = 1;
+        sqe->addr = reinterpret_cast<uint64_t>(addr);
+        sqe->len = buffer_size_;
+        sqe->off = bid;
+        sqe->buf_group = buf_group_;
+        sqe->user_data = kInternalUserData;
+        return;
+    }
+
+    // Not buf_ring_->bufs: in C++ the empty struct in __DECLARE_FLEX_ARRAY takes a byte and
+    // shifts the array by 8, entries start at the ring base as in the kernel's layout.
+    auto* bufs = reinterpret_cast<io_uring_buf*>(buf_ring_);
+    io_uring_buf& buf = bufs[buf_tail_ & (buf_entries_ - 1)];
+    buf.addr = reinterpret_cast<uint64_t>(addr);
+    buf.len = buffer_size_;
+    buf.bid = bid;
+    ++buf_tail_;
+    std::atomic_ref<uint16_t>(buf_ring_->tail).store(buf_tail_, std::memory_order_release);
+}
+
+bool UringRing::register_buffer_ring(uint16_t group, unsigned entries) {
+    buf_ring_size_ = entries * sizeof(io_uring_buf);
+    void* mem = mmap(nullptr, buf_ring_size_, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE,
+                     -1, 0);
+    if (mem == MAP_FAILED)
+        return false;
+
+    io_uring_buf_reg reg{};
+    reg.ring_addr = reinterpret_cast<uint64_t>(mem);
+    reg.ring_entries = entries;
+    reg.bgid = group;
+    if (syscall(__NR_io_uring_register, ring_fd_, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        munmap(mem, buf_ring_size_);
+        return false;
+    }
+    buf_ring_ = static_cast<io_uring_buf_ring*>(mem);
+    return true;
+}
+
+bool UringRing::probe_buffer_select() {
+    // Receive one byte through the buffer group on a private socketpair
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) < 0)
+        return false;
+
+    bool ok = false;
+    io_uring_sqe* sqe = get_sqe_or_flush();
+    if (sqe && ::write(sv[1], "p", 1) == 1) {
+        sqe->opcode = IORING_OP_RECV;
+        sqe->fd = sv[0];
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = buf_group_;
+        sqe->user_data = kInternalUserData;
+
+        unsigned head = *cq_head_;
+        enter(flush(), 1, 1000);
+        while (head != load_acquire(cq_tail_)) {
+            const io_uring_cqe& cqe = cqes_[head & *cq_mask_];
+            if (cqe.res > 0 && (cqe.flags & IORING_CQE_F_BUFFER) &&
+                cqe.user_data == kInternalUserData) {
+                ok = true;
+                recycle_buffer(static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT));
+            }
+            store_release(cq_head_, ++head);
+        }
+        enter(flush(), 0, -1);
+    }
+
+    ::close(sv[0]);
+    ::close(sv[1]);
+    return ok;
+}
+
+io_uring_sqe* UringRing::get_sqe_or_flush() {
+    io_uring_sqe* sqe = get_sqe();
+    if (!sqe) {
+        enter(flush(), 0, -1);
+        sqe = get_sqe();
+    }
+    return sqe;
+}
+
+unsigned UringRing::load_acquire(const unsigned* p) {
+    return std::atomic_ref<unsigned>(*const_cast<unsigned*>(p)).load(std::memory_order_acquire);
+}
+
+void UringRing::store_release(unsigned* p, unsigned v) {
+    std::atomic_ref<unsigned>(*p).store(v, std::memory_order_release);
+}
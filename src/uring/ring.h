@@ -0,0 +1,105 @@
+#pragma once
+
+#include <linux/io_uring.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "error.h"
+
+// Minimal io_uring wrapper over the raw syscalls (no liburing dependency).
+//
+// SQ access (get_sqe/flush) is not thread-safe; callers serialise it themselves.
+// enter() may be called from any thread, and completions are reaped by one thread only.
+class UringRing {
+  public:
+    UringRing() = default;
+    ~UringRing() { close(); }
+
+    UringRing(const UringRing&) = delete;
+    UringRing& operator=(const UringRing&) = delete;
+
+    Error init(unsigned entries);
+    void close();
+    bool valid() const { return ring_fd_ >= 0; }
+
+    // Zeroed sqe, or nullptr when the submission queue is full
+    io_uring_sqe* get_sqe();
+
+    // get_sqe(), submitting the queue to make room when it is full; nullptr only when the
+    // kernel still hasn't consumed any of it
+    io_uring_sqe* get_sqe_or_flush();
+
+    // Publish prepared sqes to the kernel, returns how many were published
+    unsigned flush();
+
+    // io_uring_enter(): submit `to_submit` sqes and wait for `wait_nr` completions.
+    // A negative timeout waits forever. Returns submitted count or -errno (-ETIME on timeout).
+    int enter(unsigned to_submit, unsigned wait_nr, int timeout_ms);
+
+    int submit() { return enter(flush(), 0, -1); }
+
+    // Visit every ready completion, returns how many were consumed. Completions tagged
+    // kInternalUserData belong to the ring itself and are skipped.
+    template <typename F>
+    unsigned for_each_cqe(F&& fn) {
+        unsigned head = *cq_head_;
+        unsigned tail = load_acquire(cq_tail_);
+        unsigned count = 0;
+        while (head != tail) {
+            const io_uring_cqe& cqe = cqes_[head & *cq_mask_];
+            if (cqe.user_data != kInternalUserData)
+                fn(cqe);
+            ++head;
+            ++count;
+            store_release(cq_head_, head);
+            tail = load_acquire(cq_tail_);
+        }
+        return count;
+    }
+
+    // Buffers for IOSQE_BUFFER_SELECT reads (entries must be a power of two). Uses a
+    // registered buffer ring, or IORING_OP_PROVIDE_BUFFERS when the kernel does not honour
+    // the ring. In that mode recycle_buffer() needs an sqe, so serialise it like get_sqe().
+    Error setup_buffer_ring(uint16_t group, unsigned entries, unsigned buffer_size);
+    const uint8_t* buffer(uint16_t bid) const { return buffers_.data() + bid * buffer_size_; }
+    void recycle_buffer(uint16_t bid);
+    bool uses_buffer_ring() const { return buf_ring_ != nullptr; }
+
+    static constexpr uint64_t kInternalUserData = 0;
+
+  private:
+    bool register_buffer_ring(uint16_t group, unsigned entries);
+    bool probe_buffer_select();
+    static unsigned load_acquire(const unsigned* p);
+    static void store_release(unsigned* p, unsigned v);
+
+  private:
+    int ring_fd_ = -1;
+
+    void* sq_ptr_ = nullptr;
+    size_t sq_size_ = 0;
+    void* cq_ptr_ = nullptr;
+    size_t cq_size_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    size_t sqes_size_ = 0;
+
+    unsigned* sq_head_ = nullptr;
+    unsigned* sq_tail_ = nullptr;
+    unsigned* sq_mask_ = nullptr;
+    unsigned sq_entries_ = 0;
+    unsigned sqe_tail_ = 0;  // prepared but not yet published
+
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    unsigned* cq_mask_ = nullptr;
+    io_uring_cqe* cqes_ = nullptr;
+
+    io_uring_buf_ring* buf_ring_ = nullptr;
+    size_t buf_ring_size_ = 0;
+    unsigned buf_entries_ = 0;
+    uint16_t buf_group_ = 0;
+    unsigned buffer_size_ = 0;
+    uint16_t buf_tail_ = 0;
+    std::vector<uint8_t> buffers_;
+};
@@ -1,17 +1,57 @@
+#include <fcntl.h>
 #include <gtest/gtest.h>
+#include <netinet/tcp.h>
+#include <openssl/pem.h>
+#include <openssl/ssl.h>
+#include <openssl/x509v3.h>
+#include <poll.h>
+#include <sys/resource.h>
 
 #include <asio.hpp>
 #include <atomic>
+#include <cstdlib>
+#include <future>
+#include <mutex>
+#include <set>
+#include <span>
 #include <string>
 #include <thread>
 #include <vector>
 
+#include "buffer/buffer_pool.h"
+#include "client/asio/tcp_client.h"
 #include "client/asio/udp_client.h"
 #include "client/client_interface.h"
+#include "client/client_runtime.h"
+#include "client/posix/tcp_client.h"
+#include "client/posix/udp_client.h"
 #include "factory.h"
+#include "rpc/rpc_client.h"
+#include "rpc/rpc_server.h"
+#include "server/asio/tcp_server.h"
 #include "server/posix/tcp_server.h"
 #include "server/posix/udp_server.h"
 #include "server/server_interface.h"
+#include "server/uring/tcp_server.h"
+#include "udp/offload.h"
+
+// Counts every global operator new, for the steady-state allocation test
+static std::atomic<size_t> g_allocations{0};
+
+void* operator new(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
 
 // ====================== Test 1: Construct TCP Client via factory ======================
 
@@ -168,21 +208,22 @@ TEST(NetworkFeatureTest, UDPAsyncSendReceive) {
     NetworkConfig cfg{"127.0.0.1", port};
     cfg.connection_type = ClientType::UDP;
 
-    UdpClient udp(cfg, io);
-    Error err = udp.connect();
+    // UdpClient keeps itself alive through shared_from_this(), so it must be owned by one
+    auto udp = std::make_shared<UdpClient>(cfg, io);
+    Error err = udp->connect();
     ASSERT_EQ(err.code(), ErrorCode::NO_ERROR);
 
     std::atomic<bool> done{false};
     std::string final_result;
 
-    udp.recieve_async([&](const std::vector<uint8_t>& data, Error e) {
+    udp->recieve_async([&](const std::vector<uint8_t>& data, Error e) {
         ASSERT_EQ(e.code(), ErrorCode::NO_ERROR);
         final_result.assign(data.begin(), data.end());
         done = true;
     });
 
     std::vector<uint8_t> msg = {'T', 'e', 's', 't'};
-    udp.send_async(msg, [&](Error e) { ASSERT_EQ(e.code(), ErrorCode::NO_ERROR); });
+    udp->send_async(msg, [&](Error e) { ASSERT_EQ(e.code(), ErrorCode::NO_ERROR); });
 
     io->run();
 
@@ -298,3 +339,2294 @@ TEST(NetworkFeatureTest, TCPAsyncSendReceive) {
 
     server.gracefull_shutdown();
 }
+
+// ====================== Test 13: TCP Echo Over Epoll Event Loop ========================
+
+TEST(NetworkFeatureTest, TCPEpollSendReceive) {
+    ServerConfig cfg;
+    cfg.port = 60882;
+    cfg.event_loop = ServerConfig::EventLoopType::EPOLL;
+
+    TcpServer* srv_ptr = nullptr;
+    auto rx_cb = [&](int fd, const std::string&, const std::vector<uint8_t>& data) {
+        std::vector<uint8_t> resp{'E', 'c', 'h', 'o', ':'};
+        resp.insert(resp.end(), data.begin(), data.end());
+        srv_ptr->send(fd, resp);
+    };
+
+    auto on_con = [](int, const std::string&) {};
+    auto on_disc = [](int, const std::string&) {};
+
+    TcpServer server(cfg, rx_cb, on_con, on_disc);
+    srv_ptr = &server;
+
+    Error err = server.listen();
+    ASSERT_EQ(err.code(), ErrorCode::NO_ERROR);
+
+    NetworkConfig client_cfg{"127.0.0.1", cfg.port};
+    auto conn = ClientFactory::create(client_cfg);
+    ASSERT_NE(conn, nullptr);
+
+    err = conn->connect();
+    ASSERT_EQ(err.code(), ErrorCode::NO_ERROR);
+
+    err = conn->send_sync(std::vector<uint8_t>{'E', 'T'});
+    ASSERT_EQ(err.code(), ErrorCode::NO_ERROR);
+
+    std::vector<uint8_t> out;
+    err = conn->recieve_sync(out);
+    ASSERT_EQ(err.code(), ErrorCode::NO_ERROR);
+    ASSERT_EQ(std::string(out.begin(), out.end()), "Echo:ET");
+
+    server.gracefull_shutdown();
+}
+
+// ====================== Test 14: Epoll Serves More Than FD_SETSIZE Clients ============
+
+TEST(NetworkFeatureTest, TCPEpollBeyondFdSetSize) {
+    ServerConfig cfg;
+    cfg.port = 60883;
+    cfg.event_loop = ServerConfig::EventLoopType::EPOLL;
+
+    std::atomic<int> connected{0};
+    std::atomic<int> received{0};
+    std::atomic<int> disconnected{0};
+
+    auto rx = [&](int, const std::string&, const std::vector<uint8_t>& data) {
+        received += static_cast<int>(data.size());
+    };
+    auto on_con = [&](int, const std::string&) { ++connected; };
+    auto on_disc = [&](int, const std::string&) { ++disconnected; };
+
+    TcpServer server(cfg, rx, on_con, on_disc);
+    ASSERT_EQ(server.listen().code(), ErrorCode::NO_ERROR);
+
+    const int kClients = FD_SETSIZE + 100;
+
+    // Each client costs two descriptors in this process (client + accepted socket)
+    rlimit lim{};
+    getrlimit(RLIMIT_NOFILE, &lim);
+    if (lim.rlim_cur < rlim_t(2 * kClients + 64)) {
+        lim.rlim_cur = std::min<rlim_t>(lim.rlim_max, 2 * kClients + 64);
+        setrlimit(RLIMIT_NOFILE, &lim);
+    }
+    if (lim.rlim_cur < rlim_t(2 * kClients + 64))
+        GTEST_SKIP() << "RLIMIT_NOFILE too low for " << kClients << " clients";
+
+    std::vector<int> socks;
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(cfg.port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+
+    for (int i = 0; i < kClients; ++i) {
+        int s = socket(AF_INET, SOCK_STREAM, 0);
+        ASSERT_GE(s, 0);
+        ASSERT_EQ(::connect(s, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+        socks.push_back(s);
+    }
+
+    for (int s : socks) ASSERT_EQ(::send(s, "x", 1, 0), 1);
+
+    for (int i = 0; i < 400 && received < kClients; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    ASSERT_EQ(connected.load(), kClients);
+    ASSERT_EQ(received.load(), kClients);
+
+    // Abortive close so a thousand TIME_WAIT ports do not collide with later test ports
+    linger lg{1, 0};
+    for (int s : socks) {
+        setsockopt(s, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+        close(s);
+    }
+
+    for (int i = 0; i < 400 && disconnected < kClients; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ASSERT_EQ(disconnected.load(), kClients);
+
+    server.gracefull_shutdown();
+}
+
+// ====================== Test 15: Sharded TcpServer Reports Delivering Shard ===========
+
+TEST(NetworkFeatureTest, TCPShardedReusePort) {
+    // Hashed by SO_REUSEPORT, then steered to the CPU's shard (one shard on a 1-CPU box)
+    int port = 60884;
+    for (bool steering : {false, true}) {
+        ServerConfig cfg;
+        cfg.port = port;
+        cfg.event_loop = ServerConfig::EventLoopType::EPOLL;
+        cfg.threads = 4;
+        cfg.cpu_steering = steering;
+        port = 60918;
+
+        std::atomic<int> received{0};
+        std::atomic<bool> shard_in_range{true};
+        std::mutex shards_mutex;
+        std::set<int> shards_seen;
+        TcpServer* srv_ptr = nullptr;
+
+        auto rx = [&](int fd, const std::string&, const std::vector<uint8_t>& data) {
+            int shard = TcpServer::current_shard();
+            if (shard < 0 || shard >= cfg.threads)
+                shard_in_range = false;
+            srv_ptr->send(fd, data);
+            ++received;
+        };
+        auto on_con = [&](int, const std::string&) {
+            std::lock_guard<std::mutex> lock(shards_mutex);
+            shards_seen.insert(TcpServer::current_shard());
+        };
+        auto on_disc = [](int, const std::string&) {};
+
+        TcpServer server(cfg, rx, on_con, on_disc);
+        srv_ptr = &server;
+        ASSERT_EQ(server.listen().code(), ErrorCode::NO_ERROR);
+        ASSERT_EQ(server.shard_count(), 4);
+        ASSERT_EQ(TcpServer::current_shard(), -1);
+
+        const int kClients = 32;
+        std::vector<std::shared_ptr<ClientInterface>> clients;
+        for (int i = 0; i < kClients; ++i) {
+            auto conn = ClientFactory::create(NetworkConfig{"127.0.0.1", cfg.port});
+            ASSERT_EQ(conn->connect().code(), ErrorCode::NO_ERROR);
+            ASSERT_EQ(conn->send_sync(std::vector<uint8_t>{'S'}).code(), ErrorCode::NO_ERROR);
+            clients.push_back(conn);
+        }
+
+        for (auto& conn : clients) {
+            std::vector<uint8_t> out;
+            ASSERT_EQ(conn->recieve_sync(out).code(), ErrorCode::NO_ERROR);
+            ASSERT_EQ(std::string(out.begin(), out.end()), "S");
+        }
+
+        ASSERT_EQ(received.load(), kClients);
+        ASSERT_TRUE(shard_in_range);
+
+        // 32 connections hashed over 4 shards all landing on one: odds of 4 in 2^64
+        std::lock_guard<std::mutex> lock(shards_mutex);
+        EXPECT_FALSE(shards_seen.count(-1));
+        if (!steering) {
+            EXPECT_GE(shards_seen.size(), 2u);
+        }
+
+        server.gracefull_shutdown();
+    }
+}
+
+// ====================== Test 16: io_uring Server/Client Async Echo ====================
+
+TEST(NetworkFeatureTest, TCPUringSendReceive) {
+    ServerConfig cfg;
+    cfg.port = 60885;
+    cfg.backend_type = ServerConfig::BackendType::IO_URING;
+
+    TcpServerUring* srv_ptr = nullptr;
+    auto rx_cb = [&](int fd, const std::string&, const std::vector<uint8_t>& data) {
+        std::vector<uint8_t> resp{'E', 'c', 'h', 'o', ':'};
+        resp.insert(resp.end(), data.begin(), data.end());
+        srv_ptr->send(fd, resp);
+    };
+    auto on_con = [](int, const std::string&) {};
+    auto on_disc = [](int, const std::string&) {};
+
+    TcpServerUring server(cfg, rx_cb, on_con, on_disc);
+    srv_ptr = &server;
+
+    Error err = server.listen();
+    if (err.code() == ErrorCode::NOT_IMPLEMENTED)
+        GTEST_SKIP() << "io_uring unavailable: " << err.message();
+    ASSERT_EQ(err.code(), ErrorCode::NO_ERROR);
+
+    NetworkConfig client_cfg{"127.0.0.1", cfg.port};
+    client_cfg.backend_type = NetworkConfig::BackendType::IO_URING;
+    auto conn = ClientFactory::create(client_cfg);
+    ASSERT_NE(conn, nullptr);
+    ASSERT_EQ(conn->connect().code(), ErrorCode::NO_ERROR);
+
+    std::mutex mtx;
+    std::string received;
+    conn->recieve_async([&](const std::vector<uint8_t>& data, Error e) {
+        if (e.code() != ErrorCode::NO_ERROR)
+            return;
+        std::lock_guard<std::mutex> lock(mtx);
+        received.append(data.begin(), data.end());
+    });
+
+    std::atomic<int> sent{0};
+    for (char c : std::string("xyz")) {
+        conn->send_async(std::vector<uint8_t>{uint8_t(c)}, [&](Error e) {
+            if (e.code() == ErrorCode::NO_ERROR)
+                ++sent;
+        });
+    }
+
+    // The sends may be coalesced into fewer reads, but bytes and order are preserved
+    auto payload = [&]() {
+        std::lock_guard<std::mutex> lock(mtx);
+        std::string out;
+        for (char c : received)
+            if (c == 'x' || c == 'y' || c == 'z')
+                out += c;
+        return out;
+    };
+    for (int i = 0; i < 200 && payload().size() < 3; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+    ASSERT_EQ(sent.load(), 3);
+    ASSERT_EQ(payload(), "xyz");
+
+    conn->disconnect();
+    server.gracefull_shutdown();
+}
+
+// ====================== Test 17: Slow Reader Hits Write Queue High-Water Mark =========
+
+TEST(NetworkFeatureTest, TCPSendBackpressure) {
+    ServerConfig cfg;
+    cfg.port = 60886;
+    cfg.event_loop = ServerConfig::EventLoopType::EPOLL;
+    cfg.send_high_water_mark = 256 * 1024;
+
+    std::atomic<int> client_fd{-1};
+    std::atomic<int> engaged{0};
+    std::atomic<int> released{0};
+
+    auto rx = [](int, const std::string&, const std::vector<uint8_t>&) {};
+    auto on_con = [&](int fd, const std::string&) { client_fd = fd; };
+    auto on_disc = [](int, const std::string&) {};
+
+    TcpServer server(cfg, rx, on_con, on_disc);
+    server.set_backpressure_callback([&](int, size_t, bool active) {
+        if (active)
+            ++engaged;
+        else
+            ++released;
+    });
+    ASSERT_EQ(server.listen().code(), ErrorCode::NO_ERROR);
+
+    int s = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_GE(s, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(cfg.port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    ASSERT_EQ(::connect(s, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+
+    for (int i = 0; i < 200 && client_fd < 0; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ASSERT_GE(client_fd.load(), 0);
+
+    // The client never reads, so sends must start failing instead of blocking
+    const std::vector<uint8_t> chunk(64 * 1024, 'b');
+    size_t accepted = 0;
+    bool refused = false;
+    for (int i = 0; i < 4096 && !refused; ++i) {
+        Error err = server.send(client_fd, chunk);
+        if (err.code() == ErrorCode::NO_ERROR)
+            accepted += chunk.size();
+        else
+            refused = err.code() == ErrorCode::SEND_FAILED;
+    }
+    ASSERT_TRUE(refused);
+    ASSERT_EQ(engaged.load(), 1);
+
+    // Draining the socket lets the reactor flush the queue and lift the backpressure
+    std::vector<uint8_t> buf(64 * 1024);
+    size_t total = 0;
+    while (total < accepted) {
+        ssize_t n = recv(s, buf.data(), buf.size(), 0);
+        ASSERT_GT(n, 0);
+        total += n;
+    }
+    ASSERT_EQ(total, accepted);
+
+    for (int i = 0; i < 200 && released == 0; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ASSERT_EQ(released.load(), 1);
+
+    close(s);
+    server.gracefull_shutdown();
+}
+
+// ====================== Test 18: Connection Table Survives Disconnect Churn ===========
+
+TEST(NetworkFeatureTest, TCPConnectionTableChurn) {
+    ServerConfig cfg;
+    cfg.port = 60887;
+    cfg.event_loop = ServerConfig::EventLoopType::EPOLL;
+
+    std::mutex mtx;
+    std::vector<int> fds;
+    std::atomic<int> disconnected{0};
+
+    auto rx = [](int, const std::string&, const std::vector<uint8_t>&) {};
+    auto on_con = [&](int fd, const std::string&) {
+        std::lock_guard<std::mutex> lock(mtx);
+        fds.push_back(fd);
+    };
+    auto on_disc = [&](int, const std::string&) { ++disconnected; };
+
+    TcpServer server(cfg, rx, on_con, on_disc);
+    ASSERT_EQ(server.listen().code(), ErrorCode::NO_ERROR);
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(cfg.port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+
+    const int kClients = 64;
+    std::vector<int> socks;
+    for (int i = 0; i < kClients; ++i) {
+        int s = socket(AF_INET, SOCK_STREAM, 0);
+        ASSERT_GE(s, 0);
+        ASSERT_EQ(::connect(s, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+        socks.push_back(s);
+    }
+    for (int i = 0; i < 200; ++i) {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (fds.size() == size_t(kClients))
+                break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    // Drop every client but the last one
+    linger lg{1, 0};
+    for (int i = 0; i < kClients - 1; ++i) {
+        setsockopt(socks[i], SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+        close(socks[i]);
+    }
+    for (int i = 0; i < 200 && disconnected < kClients - 1; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ASSERT_EQ(disconnected.load(), kClients - 1);
+
+    // The address index now resolves to the one remaining connection
+    ASSERT_EQ(server.send("127.0.0.1", std::vector<uint8_t>{'o', 'k'}).code(),
+              ErrorCode::NO_ERROR);
+    char buf[2];
+    ASSERT_EQ(recv(socks.back(), buf, sizeof(buf), MSG_WAITALL), 2);
+    ASSERT_EQ(std::string(buf, 2), "ok");
+
+    ASSERT_EQ(server.send("10.0.0.1", std::vector<uint8_t>{'x'}).code(), ErrorCode::SEND_FAILED);
+
+    close(socks.back());
+    server.gracefull_shutdown();
+}
+
+// ====================== Test 19: UdpServer Batched recvmmsg/sendmmsg Echo =============
+
+TEST(NetworkFeatureTest, UDPBatchedEcho) {
+    UdpServerOptions options;
+    options.batch_size = 16;
+    options.batch_timeout = std::chrono::microseconds(500);
+
+    int port = 60888;
+    UdpServer server(port, [](int, const std::string& req) { return "Echo:" + req; }, options);
+    ASSERT_EQ(server.start().code(), ErrorCode::NO_ERROR);
+
+    int s = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_GE(s, 0);
+    timeval tv{2, 0};
+    setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+
+    // More datagrams than one batch holds, sent back to back
+    const int kDatagrams = 40;
+    for (int i = 0; i < kDatagrams; ++i) {
+        std::string msg = std::to_string(i);
+        ASSERT_EQ(sendto(s, msg.data(), msg.size(), 0, reinterpret_cast<sockaddr*>(&addr),
+                         sizeof(addr)),
+                  ssize_t(msg.size()));
+    }
+
+    std::vector<bool> seen(kDatagrams, false);
+    for (int i = 0; i < kDatagrams; ++i) {
+        char buf[64];
+        ssize_t n = recv(s, buf, sizeof(buf), 0);
+        ASSERT_GT(n, 5);
+        std::string reply(buf, n);
+        ASSERT_EQ(reply.substr(0, 5), "Echo:");
+        seen[std::stoi(reply.substr(5))] = true;
+    }
+    for (int i = 0; i < kDatagrams; ++i) ASSERT_TRUE(seen[i]) << i;
+
+    close(s);
+    server.stop();
+}
+
+// ====================== Test 20: UDP GSO/GRO Offload Round Trip =======================
+
+TEST(NetworkFeatureTest, UDPOffloadEcho) {
+    UdpServerOptions options;
+    options.udp_offload = true;
+
+    int port = 60889;
+    UdpServer server(port, [](int, const std::string& req) { return "E" + req; }, options);
+    ASSERT_EQ(server.start().code(), ErrorCode::NO_ERROR);
+
+    auto io = std::make_shared<asio::io_context>();
+    NetworkConfig cfg{"127.0.0.1", port};
+    cfg.connection_type = ClientType::UDP;
+    cfg.udp_offload = true;
+
+    auto udp = std::make_shared<UdpClient>(cfg, io);
+    ASSERT_EQ(udp->connect().code(), ErrorCode::NO_ERROR);
+
+    // Equal-sized datagrams queued back to back: candidates for one GSO send each way.
+    // Without kernel support both sides fall back to one datagram per syscall.
+    const int kDatagrams = 8;
+    std::atomic<int> sent{0};
+    for (int i = 0; i < kDatagrams; ++i) {
+        std::vector<uint8_t> msg(100, uint8_t('a' + i));
+        udp->send_async(msg, [&](Error e) {
+            ASSERT_EQ(e.code(), ErrorCode::NO_ERROR);
+            ++sent;
+        });
+    }
+
+    // One datagram per recieve_async(), even when GRO coalesced several into one packet
+    std::vector<std::string> replies;
+    for (int attempt = 0; attempt < 20 && replies.size() < size_t(kDatagrams); ++attempt) {
+        const size_t before = replies.size();
+        udp->recieve_async([&](const std::vector<uint8_t>& data, Error e) {
+            ASSERT_EQ(e.code(), ErrorCode::NO_ERROR);
+            replies.emplace_back(data.begin(), data.end());
+        });
+        io->restart();
+        io->run();
+        ASSERT_EQ(replies.size(), before + 1);
+    }
+
+    ASSERT_EQ(sent.load(), kDatagrams);
+    ASSERT_EQ(replies.size(), size_t(kDatagrams));
+    for (int i = 0; i < kDatagrams; ++i)
+        ASSERT_EQ(replies[i], "E" + std::string(100, char('a' + i)));
+
+    udp->disconnect();
+    server.stop();
+}
+
+// ====================== Test 21: UdpServer SO_REUSEPORT Workers =======================
+
+TEST(NetworkFeatureTest, UDPReusePortWorkers) {
+    UdpServerOptions options;
+    options.workers = 4;
+
+    std::mutex mtx;
+    std::set<std::thread::id> threads;
+
+    int port = 60890;
+    UdpServer server(
+        port,
+        [&](int id, const std::string&) {
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                threads.insert(std::this_thread::get_id());
+            }
+            return std::to_string(id);
+        },
+        options);
+    ASSERT_EQ(server.start().code(), ErrorCode::NO_ERROR);
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+
+    auto request = [&](int s) {
+        sendto(s, "?", 1, 0, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        char buf[32];
+        ssize_t n = recv(s, buf, sizeof(buf), 0);
+        return n > 0 ? std::stoi(std::string(buf, n)) : -1;
+    };
+
+    const int kClients = 32;
+    std::vector<int> socks;
+    std::set<int> ids;
+    for (int i = 0; i < kClients; ++i) {
+        int s = socket(AF_INET, SOCK_DGRAM, 0);
+        ASSERT_GE(s, 0);
+        timeval tv{2, 0};
+        setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        socks.push_back(s);
+
+        int id = request(s);
+        ASSERT_GT(id, 0);
+        ids.insert(id);
+    }
+
+    // Unique per client, and the same id again on a second request
+    ASSERT_EQ(ids.size(), size_t(kClients));
+    for (int s : socks) ASSERT_TRUE(ids.count(request(s)));
+
+    // Flow hashing spread the clients over more than one worker
+    ASSERT_GT(threads.size(), 1u);
+
+    for (int s : socks) close(s);
+    server.stop();
+}
+
+// ====================== Test 22: UdpServer Client Registry Capacity and Idle Expiry ===
+
+TEST(NetworkFeatureTest, UDPClientRegistryExpiry) {
+    UdpServerOptions options;
+    options.max_clients = 32;
+    options.client_idle_timeout = std::chrono::milliseconds(200);
+
+    std::atomic<int> evicted{0};
+    std::atomic<int> idle{0};
+
+    int port = 60891;
+    UdpServer server(port, [](int id, const std::string&) { return std::to_string(id); }, options);
+    server.set_expiry_callback([&](int, const sockaddr_in&, UdpServer::ExpiryReason reason) {
+        if (reason == UdpServer::ExpiryReason::CAPACITY)
+            ++evicted;
+        else
+            ++idle;
+    });
+
+    // A flood of distinct source addresses never grows the registry past its bound
+    const int kSources = 1000;
+    for (int i = 0; i < kSources; ++i) {
+        sockaddr_in c{};
+        c.sin_family = AF_INET;
+        c.sin_addr.s_addr = htonl(0x0A000000 + i);
+        c.sin_port = htons(4000);
+        ASSERT_GT(server.get_or_assign_client_id(c), 0);
+    }
+    ASSERT_LE(server.client_count(), options.max_clients);
+    ASSERT_EQ(size_t(evicted.load()) + server.client_count(), size_t(kSources));
+
+    // Silent clients are swept by the running workers
+    ASSERT_EQ(server.start().code(), ErrorCode::NO_ERROR);
+    for (int i = 0; i < 100 && server.client_count() > 0; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ASSERT_EQ(server.client_count(), 0u);
+    ASSERT_EQ(size_t(idle.load() + evicted.load()), size_t(kSources));
+
+    server.stop();
+}
+
+// ====================== Test 23: UdpServer Inline, Deferred and No Reply ==============
+
+TEST(NetworkFeatureTest, UDPReplyModes) {
+    std::vector<std::thread> deferred;
+    std::vector<UdpDeferredReply> kept;
+    std::mutex mtx;
+
+    auto handler = [&](int, std::span<const uint8_t> data, UdpResponder& reply) {
+        if (data.empty())
+            return;
+        switch (data[0]) {
+            case 'i':
+                reply.reply(std::vector<uint8_t>{'I'});
+                break;
+            case 'd': {
+                // Answer later from another thread without holding up the receive loop
+                UdpDeferredReply later = reply.defer();
+                std::lock_guard<std::mutex> lock(mtx);
+                deferred.emplace_back([later]() {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                    later.send(std::vector<uint8_t>{'D'});
+                });
+                break;
+            }
+            case 'k': {
+                std::lock_guard<std::mutex> lock(mtx);
+                kept.push_back(reply.defer());
+                break;
+            }
+            default:
+                break;  // no reply at all
+        }
+    };
+
+    int port = 60892;
+    UdpServer server(port, handler);
+    ASSERT_EQ(server.start().code(), ErrorCode::NO_ERROR);
+
+    int s = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_GE(s, 0);
+    timeval tv{1, 0};
+    setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    auto send = [&](char c) {
+        sendto(s, &c, 1, 0, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    };
+
+    char buf[16];
+    send('n');
+    send('d');
+    send('i');
+    ASSERT_EQ(recv(s, buf, sizeof(buf), 0), 1);
+    ASSERT_EQ(buf[0], 'I');
+    ASSERT_EQ(recv(s, buf, sizeof(buf), 0), 1);
+    ASSERT_EQ(buf[0], 'D');
+
+    // 'n' produced nothing, not even an empty datagram
+    tv = {0, 200000};
+    setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    ASSERT_LT(recv(s, buf, sizeof(buf), 0), 0);
+
+    // A handle kept past stop() is retired, even once the server runs again on new sockets
+    send('k');
+    for (int i = 0; i < 100; ++i) {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (!kept.empty())
+                break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        ASSERT_EQ(kept.size(), 1u);
+    }
+    server.stop();
+    EXPECT_EQ(kept[0].send(std::vector<uint8_t>{'K'}).code(), ErrorCode::NOT_CONNECTED);
+    ASSERT_EQ(server.start().code(), ErrorCode::NO_ERROR);
+    EXPECT_EQ(kept[0].send(std::vector<uint8_t>{'K'}).code(), ErrorCode::NOT_CONNECTED);
+
+    for (auto& t : deferred) t.join();
+    close(s);
+    server.stop();
+}
+
+// ====================== Test 24: TcpServerAsio Thread Pool Execution Models ===========
+
+static void run_asio_pool_echo(ServerConfig::AsioExecution model, int port) {
+    ServerConfig cfg;
+    cfg.port = port;
+    cfg.threads = 4;
+    cfg.asio_execution = model;
+
+    std::mutex mtx;
+    std::set<int> ids;
+    std::atomic<int> disconnected{0};
+    TcpServerAsio* srv_ptr = nullptr;
+
+    auto rx = [&](int fd, const std::string&, const std::vector<uint8_t>& data) {
+        srv_ptr->send(fd, data);
+    };
+    auto on_con = [&](int fd, const std::string&) {
+        std::lock_guard<std::mutex> lock(mtx);
+        ids.insert(fd);
+    };
+    auto on_disc = [&](int, const std::string&) { ++disconnected; };
+
+    TcpServerAsio server(cfg, rx, on_con, on_disc);
+    srv_ptr = &server;
+    ASSERT_EQ(server.listen().code(), ErrorCode::NO_ERROR);
+
+    const int kClients = 16;
+    std::vector<std::shared_ptr<ClientInterface>> clients;
+    for (int i = 0; i < kClients; ++i) {
+        auto conn = ClientFactory::create(NetworkConfig{"127.0.0.1", port});
+        ASSERT_EQ(conn->connect().code(), ErrorCode::NO_ERROR);
+        clients.push_back(conn);
+    }
+
+    for (int i = 0; i < kClients; ++i) {
+        std::string msg = "m" + std::to_string(i);
+        ASSERT_EQ(clients[i]->send_sync(std::vector<uint8_t>(msg.begin(), msg.end())).code(),
+                  ErrorCode::NO_ERROR);
+        std::vector<uint8_t> out;
+        ASSERT_EQ(clients[i]->recieve_sync(out).code(), ErrorCode::NO_ERROR);
+        ASSERT_EQ(std::string(out.begin(), out.end()), msg);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        ASSERT_EQ(ids.size(), size_t(kClients));
+    }
+
+    for (auto& c : clients) c->disconnect();
+    for (int i = 0; i < 200 && disconnected < kClients; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ASSERT_EQ(disconnected.load(), kClients);
+
+    server.gracefull_shutdown();
+}
+
+TEST(NetworkFeatureTest, TCPAsioContextPerThread) {
+    run_asio_pool_echo(ServerConfig::AsioExecution::CONTEXT_PER_THREAD, 60893);
+}
+
+TEST(NetworkFeatureTest, TCPAsioSharedContextStrands) {
+    run_asio_pool_echo(ServerConfig::AsioExecution::SHARED_CONTEXT, 60894);
+}
+
+// ====================== Test 25: TcpServerAsio Sends Keep Order and Drain =============
+
+TEST(NetworkFeatureTest, TCPAsioOrderedWriteQueue) {
+    ServerConfig cfg;
+    cfg.port = 60895;
+    cfg.threads = 4;
+    cfg.asio_execution = ServerConfig::AsioExecution::SHARED_CONTEXT;
+
+    std::atomic<int> conn_id{-1};
+    auto rx = [](int, const std::string&, const std::vector<uint8_t>&) {};
+    auto on_con = [&](int fd, const std::string&) { conn_id = fd; };
+    auto on_disc = [](int, const std::string&) {};
+
+    TcpServerAsio server(cfg, rx, on_con, on_disc);
+    ASSERT_EQ(server.listen().code(), ErrorCode::NO_ERROR);
+
+    int s = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_GE(s, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(cfg.port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    ASSERT_EQ(::connect(s, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+
+    for (int i = 0; i < 200 && conn_id < 0; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ASSERT_GT(conn_id.load(), 0);
+
+    // Fixed-size numbered records sent back to back must arrive whole and in order
+    const int kMessages = 2000;
+    for (int i = 0; i < kMessages; ++i) {
+        char rec[9];
+        snprintf(rec, sizeof(rec), "%08d", i);
+        ASSERT_EQ(server.send(conn_id, std::vector<uint8_t>(rec, rec + 8)).code(),
+                  ErrorCode::NO_ERROR);
+    }
+
+    std::string stream;
+    char buf[4096];
+    while (stream.size() < size_t(kMessages) * 8) {
+        ssize_t n = recv(s, buf, sizeof(buf), 0);
+        ASSERT_GT(n, 0);
+        stream.append(buf, n);
+    }
+    for (int i = 0; i < kMessages; ++i) ASSERT_EQ(std::stoi(stream.substr(i * 8, 8)), i);
+
+    for (int i = 0; i < 200 && server.queued_bytes(conn_id) > 0; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ASSERT_EQ(server.queued_bytes(conn_id), 0u);
+
+    close(s);
+    server.gracefull_shutdown();
+}
+
+// ====================== Test 26: TcpServerAsio Send By IP and Session Stats ===========
+
+TEST(NetworkFeatureTest, TCPAsioSendByIpAndStats) {
+    ServerConfig cfg;
+    cfg.port = 60896;
+    cfg.threads = 2;
+
+    std::atomic<int> conn_id{-1};
+    std::atomic<int> received{0};
+    auto rx = [&](int, const std::string&, const std::vector<uint8_t>& data) {
+        received += static_cast<int>(data.size());
+    };
+    auto on_con = [&](int fd, const std::string&) { conn_id = fd; };
+    auto on_disc = [](int, const std::string&) {};
+
+    TcpServerAsio server(cfg, rx, on_con, on_disc);
+    ASSERT_EQ(server.listen().code(), ErrorCode::NO_ERROR);
+
+    auto conn = ClientFactory::create(NetworkConfig{"127.0.0.1", cfg.port});
+    ASSERT_EQ(conn->connect().code(), ErrorCode::NO_ERROR);
+    ASSERT_EQ(conn->send_sync(std::vector<uint8_t>{'a', 'b', 'c'}).code(), ErrorCode::NO_ERROR);
+
+    for (int i = 0; i < 200 && received < 3; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ASSERT_EQ(received.load(), 3);
+
+    // Used to re-lock the registry mutex inside send(fd) and hang
+    ASSERT_EQ(server.send("127.0.0.1", std::vector<uint8_t>{'h', 'i'}).code(),
+              ErrorCode::NO_ERROR);
+    std::vector<uint8_t> out;
+    ASSERT_EQ(conn->recieve_sync(out).code(), ErrorCode::NO_ERROR);
+    ASSERT_EQ(std::string(out.begin(), out.end()), "hi");
+
+    // The write handler may still be finishing when the client already has the bytes
+    TcpServerAsio::SessionStats stats;
+    for (int i = 0; i < 200; ++i) {
+        ASSERT_EQ(server.session_stats(conn_id, stats).code(), ErrorCode::NO_ERROR);
+        if (stats.bytes_sent == 2)
+            break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_EQ(stats.ip, "127.0.0.1");
+    ASSERT_EQ(stats.bytes_received, 3u);
+    ASSERT_EQ(stats.bytes_sent, 2u);
+    ASSERT_EQ(stats.queued_bytes, 0u);
+
+    ASSERT_EQ(server.send("10.1.2.3", std::vector<uint8_t>{'x'}).code(),
+              ErrorCode::NOT_CONNECTED);
+
+    conn->disconnect();
+    server.gracefull_shutdown();
+}
+
+// ====================== Test 27: Receive Buffer Pool Recycles Buffers =================
+
+TEST(NetworkFeatureTest, BufferPoolRecycles) {
+    buffer_pool::Stats before = buffer_pool::stats();
+    {
+        auto first = buffer_pool::acquire(3000);
+        ASSERT_EQ(first.size(), 3000u);
+    }
+    {
+        // Same size class, served from this thread's cache
+        auto second = buffer_pool::acquire(4096);
+        ASSERT_EQ(second.size(), 4096u);
+    }
+    {
+        auto huge = buffer_pool::acquire(buffer_pool::kMaxClassSize * 4);
+        ASSERT_EQ(huge.size(), buffer_pool::kMaxClassSize * 4);
+    }
+    buffer_pool::Stats after = buffer_pool::stats();
+    ASSERT_GE(after.hits, before.hits + 1);
+    ASSERT_GE(after.misses, before.misses + 1);
+    ASSERT_GE(after.dropped, before.dropped + 1);
+
+    // A receive loop that re-arms from its callback reuses one buffer per round trip
+    int port = 60897;
+    UdpServer server(port, [](int, const std::string& req) { return req; });
+    ASSERT_EQ(server.start().code(), ErrorCode::NO_ERROR);
+    std::thread srv_thread([&]() { server.run(); });
+
+    auto io = std::make_shared<asio::io_context>();
+    NetworkConfig cfg{"127.0.0.1", port};
+    cfg.connection_type = ClientType::UDP;
+    auto udp = std::make_shared<UdpClient>(cfg, io);
+    ASSERT_EQ(udp->connect().code(), ErrorCode::NO_ERROR);
+
+    constexpr int kRounds = 20;
+    int received = 0;
+    std::vector<uint8_t> msg = {'p', 'o', 'o', 'l'};
+    ClientInterface::ReceiveCallback on_receive = [&](const std::vector<uint8_t>& data, Error e) {
+        ASSERT_EQ(e.code(), ErrorCode::NO_ERROR);
+        ASSERT_EQ(data, msg);
+        if (++received < kRounds) {
+            udp->recieve_async(on_receive);
+            udp->send_async(msg, [](Error) {});
+        }
+    };
+
+    before = buffer_pool::stats();
+    udp->recieve_async(on_receive);
+    udp->send_async(msg, [](Error) {});
+    io->run();
+    after = buffer_pool::stats();
+
+    ASSERT_EQ(received, kRounds);
+    ASSERT_GE(after.hits, before.hits + kRounds - 1);
+
+    server.stop();
+    srv_thread.join();
+}
+
+// ====================== Test 28: Asio Echo Loop Does Not Allocate =====================
+
+namespace {
+
+    // Client side of an echo loop: one message out, wait for all of it back, repeat
+    struct AsioEchoLoop {
+        std::shared_ptr<TcpClientAsio> client;
+        std::vector<uint8_t> msg = std::vector<uint8_t>(64, 'e');
+        size_t pending = 0;
+        int rounds = 0;
+        int target = 0;
+        bool failed = false;
+
+        void start_round() {
+            pending = msg.size();
+            client->send_async(msg, [](Error) {});
+            client->recieve_async(
+                [this](const std::vector<uint8_t>& data, Error e) { on_receive(data, e); });
+        }
+
+        void on_receive(const std::vector<uint8_t>& data, Error e) {
+            if (e.code() != ErrorCode::NO_ERROR || data.size() > pending) {
+                failed = true;
+                return;
+            }
+            pending -= data.size();
+            if (pending > 0)
+                client->recieve_async(
+                    [this](const std::vector<uint8_t>& d, Error err) { on_receive(d, err); });
+            else if (++rounds < target)
+                start_round();
+        }
+
+        void run(asio::io_context& io, int count) {
+            rounds = 0;
+            target = count;
+            start_round();
+            io.restart();
+            io.run();
+        }
+    };
+
+}  // namespace
+
+TEST(NetworkFeatureTest, TCPAsioEchoLoopNoAllocation) {
+    ServerConfig cfg;
+    cfg.port = 60898;
+    cfg.threads = 1;
+
+    TcpServerAsio* server_ptr = nullptr;
+    auto rx = [&](int fd, const std::string&, const std::vector<uint8_t>& data) {
+        server_ptr->send(fd, data);
+    };
+    auto on_con = [](int, const std::string&) {};
+    auto on_disc = [](int, const std::string&) {};
+
+    TcpServerAsio server(cfg, rx, on_con, on_disc);
+    server_ptr = &server;
+    ASSERT_EQ(server.listen().code(), ErrorCode::NO_ERROR);
+
+    auto io = std::make_shared<asio::io_context>();
+    NetworkConfig client_cfg{"127.0.0.1", cfg.port};
+    AsioEchoLoop loop;
+    loop.client = std::make_shared<TcpClientAsio>(client_cfg, io);
+    ASSERT_EQ(loop.client->connect().code(), ErrorCode::NO_ERROR);
+
+    // Warm up the pools, arenas and asio's own per-thread caches
+    loop.run(*io, 200);
+    ASSERT_FALSE(loop.failed);
+    ASSERT_EQ(loop.rounds, 200);
+
+    // Both ends of the loop: client handlers, server reads, queued sends and writes
+    size_t before = g_allocations.load();
+    loop.run(*io, 2000);
+    size_t after = g_allocations.load();
+    ASSERT_FALSE(loop.failed);
+    ASSERT_EQ(loop.rounds, 2000);
+    EXPECT_EQ(after - before, 0u);
+
+    loop.client->disconnect();
+    server.gracefull_shutdown();
+}
+
+// ====================== Test 29: Coroutine Clients and Session Handlers ===============
+
+TEST(NetworkFeatureTest, AsioCoroutineApi) {
+    ServerConfig cfg;
+    cfg.port = 60899;
+    cfg.threads = 2;
+
+    std::atomic<int> disconnects{0};
+    auto rx = [](int, const std::string&, const std::vector<uint8_t>&) {};
+    auto on_con = [](int, const std::string&) {};
+    auto on_disc = [&](int, const std::string&) { ++disconnects; };
+
+    TcpServerAsio server(cfg, rx, on_con, on_disc);
+    server.set_session_handler([](TcpServerAsio::SessionStream stream) -> asio::awaitable<void> {
+        std::vector<uint8_t> buf;
+        while ((co_await stream.receive(buf)).code() == ErrorCode::NO_ERROR) {
+            if ((co_await stream.send(buf)).code() != ErrorCode::NO_ERROR)
+                break;
+        }
+    });
+    ASSERT_EQ(server.listen().code(), ErrorCode::NO_ERROR);
+
+    auto io = std::make_shared<asio::io_context>();
+    auto tcp = std::make_shared<TcpClientAsio>(NetworkConfig{"127.0.0.1", cfg.port}, io);
+    ASSERT_EQ(tcp->connect().code(), ErrorCode::NO_ERROR);
+
+    // Pipelined: every request goes out before the first reply is read
+    std::string expected, echoed;
+    auto pipeline = [&]() -> asio::awaitable<void> {
+        for (int i = 0; i < 50; ++i) {
+            std::string line = "req" + std::to_string(i) + ";";
+            expected += line;
+            auto bytes = reinterpret_cast<const uint8_t*>(line.data());
+            if ((co_await tcp->send({bytes, line.size()})).code() != ErrorCode::NO_ERROR)
+                co_return;
+        }
+        std::vector<uint8_t> buf;
+        while (echoed.size() < expected.size()) {
+            if ((co_await tcp->receive(buf)).code() != ErrorCode::NO_ERROR)
+                co_return;
+            echoed.append(buf.begin(), buf.end());
+        }
+    };
+    asio::co_spawn(tcp->executor(), pipeline(), asio::detached);
+    io->run();
+    ASSERT_EQ(echoed, expected);
+
+    // Closing the client ends the session coroutine, which closes the session
+    tcp->disconnect();
+    for (int i = 0; i < 200 && disconnects == 0; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ASSERT_EQ(disconnects.load(), 1);
+    server.gracefull_shutdown();
+
+    // UDP request/reply as straight-line code
+    int udp_port = 60900;
+    UdpServer udp_server(udp_port, [](int, const std::string& req) { return "re:" + req; });
+    ASSERT_EQ(udp_server.start().code(), ErrorCode::NO_ERROR);
+    std::thread srv_thread([&]() { udp_server.run(); });
+
+    NetworkConfig udp_cfg{"127.0.0.1", udp_port};
+    udp_cfg.connection_type = ClientType::UDP;
+    auto udp = std::make_shared<UdpClient>(udp_cfg, io);
+    ASSERT_EQ(udp->connect().code(), ErrorCode::NO_ERROR);
+
+    int replies = 0;
+    auto exchange = [&]() -> asio::awaitable<void> {
+        const std::vector<uint8_t> ping = {'p', 'i', 'n', 'g'};
+        const std::vector<uint8_t> expect = {'r', 'e', ':', 'p', 'i', 'n', 'g'};
+        std::vector<uint8_t> reply;
+        for (int i = 0; i < 5; ++i) {
+            if ((co_await udp->send(ping)).code() != ErrorCode::NO_ERROR)
+                co_return;
+            if ((co_await udp->receive(reply)).code() != ErrorCode::NO_ERROR || reply != expect)
+                co_return;
+            ++replies;
+        }
+    };
+    asio::co_spawn(*io, exchange(), asio::detached);
+    io->restart();
+    io->run();
+    ASSERT_EQ(replies, 5);
+
+    udp_server.stop();
+    srv_thread.join();
+}
+
+// ====================== Test 30: TLS on the POSIX Server, Session Resumption ===============
+
+namespace {
+
+    // Self-signed P-256 certificate for 127.0.0.1, as PEM text {certificate, private key}.
+    // padding adds a comment extension of that many bytes, for a large handshake.
+    std::pair<std::string, std::string> make_test_certificate(size_t padding = 0) {
+        EVP_PKEY* key = EVP_EC_gen("P-256");
+        X509* cert = X509_new();
+        ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+        X509_gmtime_adj(X509_getm_notBefore(cert), -60);
+        X509_gmtime_adj(X509_getm_notAfter(cert), 3600);
+        X509_set_pubkey(cert, key);
+        X509_NAME* name = X509_get_subject_name(cert);
+        X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+                                   reinterpret_cast<const unsigned char*>("127.0.0.1"), -1, -1, 0);
+        X509_set_issuer_name(cert, name);
+        X509V3_CTX ctx;
+        X509V3_set_ctx_nodb(&ctx);
+        X509V3_set_ctx(&ctx, cert, cert, nullptr, nullptr, 0);
+        X509_EXTENSION* san =
+            X509V3_EXT_conf_nid(nullptr, &ctx, NID_subject_alt_name, "IP:127.0.0.1");
+        X509_add_ext(cert, san, -1);
+        X509_EXTENSION_free(san);
+        if (padding > 0) {
+            std::string comment(padding, 'p');
+            X509_EXTENSION* pad =
+                X509V3_EXT_conf_nid(nullptr, &ctx, NID_netscape_comment, comment.c_str());
+            X509_add_ext(cert, pad, -1);
+            X509_EXTENSION_free(pad);
+        }
+        X509_sign(cert, key, EVP_sha256());
+
+        auto to_pem = [](auto write) {
+            BIO* bio = BIO_new(BIO_s_mem());
+            write(bio);
+            char* data = nullptr;
+            long len = BIO_get_mem_data(bio, &data);
+            std::string pem(data, len);
+            BIO_free(bio);
+            return pem;
+        };
+        std::string cert_pem = to_pem([&](BIO* bio) { PEM_write_bio_X509(bio, cert); });
+        std::string key_pem = to_pem([&](BIO* bio) {
+            PEM_write_bio_PrivateKey(bio, key, nullptr, nullptr, 0, nullptr, nullptr);
+        });
+        X509_free(cert);
+        EVP_PKEY_free(key);
+        return {cert_pem, key_pem};
+    }
+
+    // Reads from a connected client until `size` bytes arrived or a read fails
+    std::string read_exactly(TcpClientAsio& client, size_t size) {
+        std::string out;
+        std::vector<uint8_t> chunk;
+        while (out.size() < size && client.recieve_sync(chunk).code() == ErrorCode::NO_ERROR)
+            out.append(chunk.begin(), chunk.end());
+        return out;
+    }
+
+}  // namespace
+
+TEST(NetworkFeatureTest, TLSPosixServerResumesSessions) {
+    auto [cert, key] = make_test_certificate();
+
+    ServerConfig cfg;
+    cfg.port = 60901;
+    cfg.event_loop = ServerConfig::EventLoopType::EPOLL;
+    cfg.ssl_config.public_key = cert;
+    cfg.ssl_config.private_key = key;
+
+    TcpServer* server_ptr = nullptr;
+    std::atomic<int> connected_fd{-1};
+    auto rx = [&](int fd, const std::string&, const std::vector<uint8_t>& data) {
+        server_ptr->send(fd, data);
+    };
+    auto on_con = [&](int fd, const std::string&) { connected_fd = fd; };
+    auto on_disc = [](int, const std::string&) {};
+
+    TcpServer server(cfg, rx, on_con, on_disc);
+    server_ptr = &server;
+    ASSERT_EQ(server.listen().code(), ErrorCode::NO_ERROR);
+
+    auto io = std::make_shared<asio::io_context>();
+    NetworkConfig client_cfg{"127.0.0.1", cfg.port};
+    client_cfg.ssl_config.public_key = cert;
+    auto client = std::make_shared<TcpClientAsio>(client_cfg, io);
+
+    // First connection: full handshake, echo, then a file through send_file()
+    ASSERT_EQ(client->connect().code(), ErrorCode::NO_ERROR);
+    ASSERT_EQ(client->send_sync({'h', 'e', 'l', 'l', 'o'}).code(), ErrorCode::NO_ERROR);
+    EXPECT_EQ(read_exactly(*client, 5), "hello");
+
+    for (int i = 0; i < 100 && connected_fd < 0; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    char path[] = "/tmp/network_armory_tls_XXXXXX";
+    int file_fd = mkstemp(path);
+    ASSERT_GE(file_fd, 0);
+    unlink(path);
+    std::string content(100000, 'f');
+    ASSERT_EQ(write(file_fd, content.data(), content.size()), ssize_t(content.size()));
+    ASSERT_EQ(server.send_file(connected_fd, file_fd, 0, content.size()).code(),
+              ErrorCode::NO_ERROR);
+    EXPECT_EQ(read_exactly(*client, content.size()), content);
+    close(file_fd);
+    client->disconnect();
+
+    // Reconnect: the ticket from the first connection skips the full handshake
+    ASSERT_EQ(client->connect().code(), ErrorCode::NO_ERROR);
+    ASSERT_EQ(client->send_sync({'a', 'g', 'a', 'i', 'n'}).code(), ErrorCode::NO_ERROR);
+    EXPECT_EQ(read_exactly(*client, 5), "again");
+    client->disconnect();
+
+    EXPECT_EQ(client->tls_stats().full_handshakes, 1u);
+    EXPECT_EQ(client->tls_stats().resumed_handshakes, 1u);
+    EXPECT_EQ(server.tls_stats().resumed_handshakes, 1u);
+
+    server.gracefull_shutdown();
+}
+
+// ====================== Test 31: TLS on the Asio Server ===============
+
+TEST(NetworkFeatureTest, TLSAsioServerEchoAndUntrustedCertificate) {
+    auto [cert, key] = make_test_certificate();
+
+    ServerConfig cfg;
+    cfg.port = 60902;
+    cfg.threads = 2;
+    cfg.ssl_config.public_key = cert;
+    cfg.ssl_config.private_key = key;
+
+    TcpServerAsio* server_ptr = nullptr;
+    std::atomic<int> connects{0};
+    auto rx = [&](int fd, const std::string&, const std::vector<uint8_t>& data) {
+        server_ptr->send(fd, data);
+    };
+    auto on_con = [&](int, const std::string&) { ++connects; };
+    auto on_disc = [](int, const std::string&) {};
+
+    TcpServerAsio server(cfg, rx, on_con, on_disc);
+    server_ptr = &server;
+    ASSERT_EQ(server.listen().code(), ErrorCode::NO_ERROR);
+
+    auto io = std::make_shared<asio::io_context>();
+    NetworkConfig client_cfg{"127.0.0.1", cfg.port};
+    client_cfg.ssl_config.public_key = cert;
+    auto client = std::make_shared<TcpClientAsio>(client_cfg, io);
+
+    std::promise<Error> connected;
+    client->connect_async([&](Error err) { connected.set_value(err); });
+    io->run();
+    ASSERT_EQ(connected.get_future().get().code(), ErrorCode::NO_ERROR);
+
+    std::string echoed;
+    client->send_async({'p', 'i', 'n', 'g'}, [](Error) {});
+    std::function<void(const std::vector<uint8_t>&, Error)> on_read =
+        [&](const std::vector<uint8_t>& data, Error err) {
+            if (err.code() != ErrorCode::NO_ERROR)
+                return;
+            echoed.append(data.begin(), data.end());
+            if (echoed.size() < 4)
+                client->recieve_async(on_read);
+        };
+    client->recieve_async(on_read);
+    io->restart();
+    io->run();
+    EXPECT_EQ(echoed, "ping");
+    client->disconnect();
+
+    // A client trusting another certificate fails the handshake and is never announced
+    NetworkConfig other_cfg{"127.0.0.1", cfg.port};
+    other_cfg.ssl_config.public_key = make_test_certificate().first;
+    auto other = std::make_shared<TcpClientAsio>(other_cfg, io);
+    EXPECT_EQ(other->connect().code(), ErrorCode::SSL_ERROR);
+    other->disconnect();
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(connects.load(), 1);
+    EXPECT_EQ(server.tls_stats().full_handshakes, 1u);
+
+    server.gracefull_shutdown();
+}
+
+// ====================== Test 32: Socket Options Profile ===============
+
+TEST(NetworkFeatureTest, SocketOptionsPresetAppliedToAcceptedConnections) {
+    ServerConfig cfg;
+    cfg.port = 60903;
+    cfg.event_loop = ServerConfig::EventLoopType::EPOLL;
+    cfg.socket_options = SocketOptions::low_latency();
+
+    TcpServer* server_ptr = nullptr;
+    std::atomic<int> nodelay{-1};
+    std::atomic<int> tos{-1};
+    auto rx = [&](int fd, const std::string&, const std::vector<uint8_t>& data) {
+        server_ptr->send(fd, data);
+    };
+    auto on_con = [&](int fd, const std::string&) {
+        int value = 0;
+        socklen_t len = sizeof(value);
+        getsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &value, &len);
+        nodelay = value;
+        len = sizeof(value);
+        getsockopt(fd, IPPROTO_IP, IP_TOS, &value, &len);
+        tos = value;
+    };
+    auto on_disc = [](int, const std::string&) {};
+
+    TcpServer server(cfg, rx, on_con, on_disc);
+    server_ptr = &server;
+    ASSERT_EQ(server.listen().code(), ErrorCode::NO_ERROR);
+
+    auto io = std::make_shared<asio::io_context>();
+    NetworkConfig client_cfg{"127.0.0.1", cfg.port};
+    client_cfg.socket_options = SocketOptions::low_latency();
+    auto client = std::make_shared<TcpClientAsio>(client_cfg, io);
+    ASSERT_EQ(client->connect().code(), ErrorCode::NO_ERROR);
+
+    // Small request/response round trips still arrive intact with quick ACKs re-armed
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_EQ(client->send_sync({'p', 'i', 'n', 'g'}).code(), ErrorCode::NO_ERROR);
+        EXPECT_EQ(read_exactly(*client, 4), "ping");
+    }
+    client->disconnect();
+
+    EXPECT_EQ(nodelay.load(), 1);
+    EXPECT_EQ(tos.load(), 0x80);
+
+    server.gracefull_shutdown();
+}
+
+// ====================== Test 33: Asio Client Send Queue ===============
+
+TEST(NetworkFeatureTest, TCPAsioClientSendQueueKeepsOrderAndCoalesces) {
+    ServerConfig cfg;
+    cfg.port = 60904;
+    cfg.event_loop = ServerConfig::EventLoopType::EPOLL;
+
+    std::mutex mutex;
+    std::string received;
+    auto rx = [&](int, const std::string&, const std::vector<uint8_t>& data) {
+        std::lock_guard<std::mutex> lock(mutex);
+        received.append(data.begin(), data.end());
+    };
+    auto on_con = [](int, const std::string&) {};
+    auto on_disc = [](int, const std::string&) {};
+
+    TcpServer server(cfg, rx, on_con, on_disc);
+    ASSERT_EQ(server.listen().code(), ErrorCode::NO_ERROR);
+
+    auto io = std::make_shared<asio::io_context>();
+    NetworkConfig client_cfg{"127.0.0.1", cfg.port};
+    auto client = std::make_shared<TcpClientAsio>(client_cfg, io);
+    ASSERT_EQ(client->connect().code(), ErrorCode::NO_ERROR);
+
+    // Queued before the io_context runs: alternating copied and moved-in messages, the
+    // caller's buffers are gone by the time anything is written
+    std::string expected;
+    int callbacks = 0;
+    for (int i = 0; i < 100; ++i) {
+        std::string text = "<" + std::to_string(i) + ">";
+        expected += text;
+        std::vector<uint8_t> msg(text.begin(), text.end());
+        auto on_sent = [&](Error err) {
+            if (err.code() == ErrorCode::NO_ERROR)
+                ++callbacks;
+        };
+        if (i % 2 == 0)
+            client->send_async(msg, on_sent);
+        else
+            client->send_async(std::move(msg), on_sent);
+    }
+    bool flushed = false;
+    client->flush([&](Error err) { flushed = err.code() == ErrorCode::NO_ERROR; });
+    io->run();
+
+    EXPECT_TRUE(flushed);
+    EXPECT_EQ(callbacks, 100);
+    EXPECT_EQ(client->queued_bytes(), 0u);
+    EXPECT_EQ(client->send_stats().messages, 100u);
+    EXPECT_LT(client->send_stats().writes, 10u);
+
+    for (int i = 0; i < 100; ++i) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (received.size() >= expected.size())
+                break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        EXPECT_EQ(received, expected);
+    }
+    client->disconnect();
+    server.gracefull_shutdown();
+}
+
+// ====================== Test 34: Streaming Receive Across Reconnects ===============
+
+TEST(NetworkFeatureTest, TCPAsioClientStreamingReceiveSurvivesReconnect) {
+    ServerConfig cfg;
+    cfg.port = 60905;
+    cfg.event_loop = ServerConfig::EventLoopType::EPOLL;
+
+    std::atomic<int> client_fd{-1};
+    std::atomic<int> connects{0};
+    auto rx = [](int, const std::string&, const std::vector<uint8_t>&) {};
+    auto on_con = [&](int fd, const std::string&) {
+        client_fd = fd;
+        ++connects;
+    };
+    auto on_disc = [](int, const std::string&) {};
+
+    TcpServer server(cfg, rx, on_con, on_disc);
+    ASSERT_EQ(server.listen().code(), ErrorCode::NO_ERROR);
+
+    auto io = std::make_shared<asio::io_context>();
+    NetworkConfig client_cfg{"127.0.0.1", cfg.port};
+    auto client = std::make_shared<TcpClientAsio>(client_cfg, io);
+    ASSERT_EQ(client->connect().code(), ErrorCode::NO_ERROR);
+
+    std::mutex mutex;
+    std::string received;
+    std::atomic<int> errors{0};
+    client->start_receiving(
+        [&](const std::vector<uint8_t>& data, Error err) {
+            if (err.code() != ErrorCode::NO_ERROR) {
+                ++errors;
+                return;
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            received.append(data.begin(), data.end());
+        },
+        true);
+
+    auto work = asio::make_work_guard(*io);
+    std::thread runner([&]() { io->run(); });
+
+    auto wait_for_text = [&](const std::string& text) {
+        for (int i = 0; i < 500; ++i) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (received == text)
+                    return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return false;
+    };
+
+    // Many messages, one re-armed read: nothing is missed between reads
+    for (int i = 0; i < 100 && connects < 1; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    for (int i = 0; i < 10; ++i)
+        ASSERT_EQ(server.send(client_fd, {'a'}).code(), ErrorCode::NO_ERROR);
+    EXPECT_TRUE(wait_for_text(std::string(10, 'a')));
+
+    // Server drops the connection; the client reconnects and keeps receiving by itself
+    ::shutdown(client_fd, SHUT_RDWR);
+    for (int i = 0; i < 500 && connects < 2; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ASSERT_EQ(connects.load(), 2);
+    ASSERT_EQ(server.send(client_fd, {'b', 'c'}).code(), ErrorCode::NO_ERROR);
+    EXPECT_TRUE(wait_for_text(std::string(10, 'a') + "bc"));
+    EXPECT_EQ(errors.load(), 1);
+
+    client->disconnect();
+    work.reset();
+    io->stop();
+    runner.join();
+    server.gracefull_shutdown();
+}
+
+// ====================== Test 35: UDP Streaming Receive ===============
+
+TEST(NetworkFeatureTest, UDPClientStreamingReceiveDrainsBursts) {
+    int port = 60906;
+    UdpServer server(port, [](int, const std::string& req) { return "E" + req; });
+    ASSERT_EQ(server.start().code(), ErrorCode::NO_ERROR);
+
+    auto io = std::make_shared<asio::io_context>();
+    NetworkConfig cfg{"127.0.0.1", port};
+    cfg.connection_type = ClientType::UDP;
+    auto client = std::make_shared<UdpClient>(cfg, io);
+
+    // Armed before connect: the read starts once the socket is open
+    std::atomic<int> replies{0};
+    client->start_receiving(
+        [&](const std::vector<uint8_t>& data, Error err) {
+            if (err.code() == ErrorCode::NO_ERROR && !data.empty() && data[0] == 'E')
+                ++replies;
+        },
+        true);
+    ASSERT_EQ(client->connect().code(), ErrorCode::NO_ERROR);
+
+    auto work = asio::make_work_guard(*io);
+    std::thread runner([&]() { io->run(); });
+
+    const int kDatagrams = 20;
+    for (int i = 0; i < kDatagrams; ++i) client->send_async({'x'}, [](Error) {});
+    for (int i = 0; i < 300 && replies < kDatagrams; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_EQ(replies.load(), kDatagrams);
+
+    client->stop_receiving();
+    client->disconnect();
+    work.reset();
+    io->stop();
+    runner.join();
+    server.stop();
+}
+
+// ====================== Test 36: POSIX Clients On The Shared Reactor ===============
+
+TEST(NetworkFeatureTest, PosixClientsShareReactorThreads) {
+    ServerConfig cfg;
+    cfg.port = 60907;
+    cfg.event_loop = ServerConfig::EventLoopType::EPOLL;
+
+    TcpServer* server_ptr = nullptr;
+    auto rx = [&](int fd, const std::string&, const std::vector<uint8_t>& data) {
+        server_ptr->send(fd, data);
+    };
+    auto on_con = [](int, const std::string&) {};
+    auto on_disc = [](int, const std::string&) {};
+    TcpServer server(cfg, rx, on_con, on_disc);
+    server_ptr = &server;
+    ASSERT_EQ(server.listen().code(), ErrorCode::NO_ERROR);
+
+    NetworkConfig client_cfg{"127.0.0.1", cfg.port};
+    client_cfg.backend_type = NetworkConfig::BackendType::POSIX;
+    client_cfg.auto_connect.retry_time_ms = 50;
+    client_cfg.socket_options = SocketOptions::low_latency();
+
+    // Receiving before connect: the reactor connects every client itself
+    const int kClients = 64;
+    std::atomic<int> bytes{0};
+    std::vector<std::shared_ptr<ClientInterface>> clients;
+    for (int i = 0; i < kClients; ++i) {
+        auto client = ClientFactory::create(client_cfg);
+        ASSERT_NE(client, nullptr);
+        client->recieve_async([&](const std::vector<uint8_t>& data, Error err) {
+            if (err.code() == ErrorCode::NO_ERROR)
+                bytes += data.size();
+        });
+        clients.push_back(client);
+    }
+    EXPECT_LE(ClientReactor::shared()->threads(), 4u);
+
+    auto all_connected = [&]() {
+        for (auto& c : clients)
+            if (!c->is_connected())
+                return false;
+        return true;
+    };
+    for (int i = 0; i < 300 && !all_connected(); ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ASSERT_TRUE(all_connected());
+
+    for (auto& c : clients)
+        ASSERT_EQ(c->send_sync({'p', 'i', 'n', 'g'}).code(), ErrorCode::NO_ERROR);
+    for (int i = 0; i < 300 && bytes < kClients * 4; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_EQ(bytes.load(), kClients * 4);
+
+    // Replies are delivered on arrival, not on a polling tick: 100 sequential round trips
+    // used to take at least 100 x 30 ms
+    const int kRounds = 100;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < kRounds; ++round) {
+        const int expected = bytes + 1;
+        ASSERT_EQ(clients[0]->send_sync({'x'}).code(), ErrorCode::NO_ERROR);
+        auto deadline = start + std::chrono::seconds(5);
+        while (bytes < expected && std::chrono::steady_clock::now() < deadline)
+            std::this_thread::yield();
+    }
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+    EXPECT_EQ(bytes.load(), kClients * 4 + kRounds);
+    clients.clear();
+
+    // Connected UDP client on the same reactor
+    UdpServer udp_server(cfg.port, [](int, const std::string& req) { return "E" + req; });
+    ASSERT_EQ(udp_server.start().code(), ErrorCode::NO_ERROR);
+    client_cfg.connection_type = ClientType::UDP;
+    auto udp = ClientFactory::create(client_cfg);
+    ASSERT_NE(udp, nullptr);
+    std::atomic<int> replies{0};
+    udp->recieve_async([&](const std::vector<uint8_t>& data, Error err) {
+        if (err.code() == ErrorCode::NO_ERROR && !data.empty() && data[0] == 'E')
+            ++replies;
+    });
+    ASSERT_EQ(udp->connect().code(), ErrorCode::NO_ERROR);
+    for (int i = 0; i < 10; ++i) ASSERT_EQ(udp->send_sync({'u'}).code(), ErrorCode::NO_ERROR);
+    for (int i = 0; i < 300 && replies < 10; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_EQ(replies.load(), 10);
+
+    udp->disconnect();
+    udp_server.stop();
+    server.gracefull_shutdown();
+}
+
+// ====================== Test 37: Busy-Poll Mode And Receive Latency ===============
+
+TEST(NetworkFeatureTest, BusyPollLoopsReportReceiveLatency) {
+    LatencyHistogram histogram;
+    for (int us = 1; us <= 1000; ++us) histogram.record(us * 1000);
+    LatencyStats uniform = histogram.stats();
+    EXPECT_EQ(uniform.count, 1000u);
+    EXPECT_NEAR(uniform.p50.count(), 500000, 500000 * 0.04);
+    EXPECT_NEAR(uniform.p99.count(), 990000, 990000 * 0.04);
+    EXPECT_EQ(uniform.max.count(), 1000000);
+
+    // Spin-then-block: spin 2 ms after the last event, then block again
+    BusyPollOptions busy;
+    busy.enabled = true;
+    busy.spin_window = std::chrono::microseconds(2000);
+    busy.measure_latency = true;
+
+    ServerConfig cfg;
+    cfg.port = 60908;
+    cfg.busy_poll = busy;
+    TcpServer* server_ptr = nullptr;
+    auto rx = [&](int fd, const std::string&, const std::vector<uint8_t>& data) {
+        server_ptr->send(fd, data);
+    };
+    auto on_con = [](int, const std::string&) {};
+    auto on_disc = [](int, const std::string&) {};
+    TcpServer server(cfg, rx, on_con, on_disc);
+    server_ptr = &server;
+    ASSERT_EQ(server.listen().code(), ErrorCode::NO_ERROR);
+
+    NetworkConfig client_cfg{"127.0.0.1", cfg.port};
+    client_cfg.socket_options.tcp_nodelay = true;
+    client_cfg.busy_poll = busy;
+    TcpClientPosix client(client_cfg);
+    std::atomic<int> echoed{0};
+    client.recieve_async([&](const std::vector<uint8_t>& data, Error err) {
+        if (err.code() == ErrorCode::NO_ERROR)
+            echoed += data.size();
+    });
+    ASSERT_EQ(client.connect().code(), ErrorCode::NO_ERROR);
+
+    const int kRounds = 50;
+    for (int round = 0; round < kRounds; ++round) {
+        ASSERT_EQ(client.send_sync({'b'}).code(), ErrorCode::NO_ERROR);
+        for (int i = 0; i < 2000 && echoed <= round; ++i)
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+        // Every other round waits past the spin window, so both spin and block paths run
+        if (round % 2)
+            std::this_thread::sleep_for(std::chrono::milliseconds(3));
+    }
+    ASSERT_EQ(echoed.load(), kRounds);
+
+    LatencyStats server_stats = server.latency_stats();
+    LatencyStats client_stats = client.latency_stats();
+    for (const LatencyStats& stats : {server_stats, client_stats}) {
+        EXPECT_EQ(stats.count, uint64_t(kRounds));
+        EXPECT_LE(stats.p50, stats.p99);
+        EXPECT_LE(stats.p99, stats.p999);
+        EXPECT_LE(stats.p999, stats.max);
+        EXPECT_LT(stats.p50, std::chrono::milliseconds(50));
+    }
+    client.disconnect();
+    server.gracefull_shutdown();
+
+    UdpServerOptions udp_options;
+    udp_options.busy_poll = busy;
+    UdpServer udp_server(cfg.port, [](int, const std::string& req) { return req; }, udp_options);
+    ASSERT_EQ(udp_server.start().code(), ErrorCode::NO_ERROR);
+    client_cfg.connection_type = ClientType::UDP;
+    UdpClientPosix udp(client_cfg);
+    std::atomic<int> replies{0};
+    udp.recieve_async([&](const std::vector<uint8_t>&, Error err) {
+        if (err.code() == ErrorCode::NO_ERROR)
+            ++replies;
+    });
+    ASSERT_EQ(udp.connect().code(), ErrorCode::NO_ERROR);
+    for (int i = 0; i < 20; ++i) ASSERT_EQ(udp.send_sync({'u'}).code(), ErrorCode::NO_ERROR);
+    for (int i = 0; i < 300 && replies < 20; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_EQ(replies.load(), 20);
+    EXPECT_EQ(udp_server.latency_stats().count, 20u);
+
+    udp.disconnect();
+    udp_server.stop();
+}
+
+// ====================== Test 38: Client Runtime ===============
+
+TEST(NetworkFeatureTest, ClientRuntimeSpreadsConnectionsOverThreads) {
+    ServerConfig cfg;
+    cfg.port = 60909;
+    cfg.event_loop = ServerConfig::EventLoopType::EPOLL;
+    TcpServer* server_ptr = nullptr;
+    auto rx = [&](int fd, const std::string&, const std::vector<uint8_t>& data) {
+        server_ptr->send(fd, data);
+    };
+    auto on_con = [](int, const std::string&) {};
+    auto on_disc = [](int, const std::string&) {};
+    TcpServer server(cfg, rx, on_con, on_disc);
+    server_ptr = &server;
+    ASSERT_EQ(server.listen().code(), ErrorCode::NO_ERROR);
+
+    ClientRuntimeOptions options;
+    options.io_threads = 4;
+    options.cpus = {0};
+    auto runtime = std::make_shared<ClientRuntime>(options);
+    EXPECT_EQ(runtime->io_threads(), 4u);
+
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    bool pinned = true;
+    std::atomic<int> replies{0};
+
+    const int kClients = 40;
+    std::vector<std::shared_ptr<ClientInterface>> clients;
+    for (int i = 0; i < kClients; ++i) {
+        auto client = ClientFactory::create(NetworkConfig{"127.0.0.1", cfg.port}, runtime);
+        ASSERT_EQ(client->connect().code(), ErrorCode::NO_ERROR);
+        client->recieve_async([&](const std::vector<uint8_t>&, Error err) {
+            if (err.code() != ErrorCode::NO_ERROR)
+                return;
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            pthread_getaffinity_np(pthread_self(), sizeof(set), &set);
+            std::lock_guard<std::mutex> lock(mutex);
+            threads.insert(std::this_thread::get_id());
+            pinned = pinned && CPU_COUNT(&set) == 1 && CPU_ISSET(0, &set);
+            ++replies;
+        });
+        clients.push_back(client);
+    }
+
+    for (auto& c : clients) c->send_async({'r', 't'}, [](Error) {});
+    for (int i = 0; i < 300 && replies < kClients; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_EQ(replies.load(), kClients);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        EXPECT_EQ(threads.size(), 4u);  // round-robin: every thread carries connections
+        EXPECT_TRUE(pinned);
+    }
+
+    for (auto& c : clients) c->disconnect();
+    runtime->shutdown();
+    runtime->shutdown();  // idempotent
+    clients.clear();
+    runtime.reset();
+    server.gracefull_shutdown();
+}
+
+// ====================== Test 39: Connected UDP And Batched Sends ===============
+
+TEST(NetworkFeatureTest, ConnectedUdpClientBatchesAndReportsUnreachable) {
+    const int port = 60910;
+    std::atomic<int> received{0};
+    UdpServer server(port, [&](int, std::span<const uint8_t>, UdpResponder&) { ++received; });
+    ASSERT_EQ(server.start().code(), ErrorCode::NO_ERROR);
+
+    auto io = std::make_shared<asio::io_context>();
+    auto work = asio::make_work_guard(*io);
+    std::thread runner([&]() { io->run(); });
+
+    const int kBatch = 200;
+    std::vector<std::vector<uint8_t>> batch(kBatch, std::vector<uint8_t>{'b'});
+    int expected = 0;
+    for (bool connected : {false, true}) {
+        NetworkConfig cfg{"127.0.0.1", port};
+        cfg.connection_type = ClientType::UDP;
+        cfg.udp_connected = connected;
+        auto client = std::make_shared<UdpClient>(cfg, io);
+        ASSERT_EQ(client->connect().code(), ErrorCode::NO_ERROR);
+
+        std::promise<Error> sent;
+        client->send_async({'a'}, [&](Error err) { sent.set_value(err); });
+        EXPECT_EQ(sent.get_future().get().code(), ErrorCode::NO_ERROR);
+        size_t handed = 0;
+        EXPECT_EQ(client->send_batch(batch, &handed).code(), ErrorCode::NO_ERROR);
+        EXPECT_EQ(handed, size_t(kBatch));
+        expected += 1 + kBatch;
+        client->disconnect();
+    }
+    for (int i = 0; i < 300 && received < expected; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_EQ(received.load(), expected);
+    server.stop();
+
+    // Nothing listens on port + 1: only the connected socket learns about it
+    for (bool connected : {false, true}) {
+        NetworkConfig cfg{"127.0.0.1", port + 1};
+        cfg.connection_type = ClientType::UDP;
+        cfg.udp_connected = connected;
+        auto client = std::make_shared<UdpClient>(cfg, io);
+        ASSERT_EQ(client->connect().code(), ErrorCode::NO_ERROR);
+        EXPECT_EQ(client->send_batch(batch).code(), ErrorCode::NO_ERROR);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        EXPECT_EQ(client->send_batch(batch).code(),
+                  connected ? ErrorCode::SERVER_UNAVAILABLE : ErrorCode::NO_ERROR);
+        client->disconnect();
+    }
+
+    work.reset();
+    io->stop();
+    runner.join();
+}
+
+// ====================== Test 40: Pipelined RPC ===============
+
+TEST(NetworkFeatureTest, RpcClientPipelinesCallsAndMatchesRepliesById) {
+    ServerConfig cfg;
+    cfg.port = 60912;
+    cfg.backend_type = ServerConfig::BackendType::ASIO;
+
+    // "late" is answered after every other call, "never" not at all
+    std::promise<RpcServer::Responder> late;
+    RpcServer rpc_server([&](int, std::span<const uint8_t> request, RpcServer::Responder reply) {
+        std::string req(request.begin(), request.end());
+        if (req == "late")
+            late.set_value(reply);
+        else if (req != "never")
+            reply.reply(std::vector<uint8_t>(request.begin(), request.end()));
+    });
+    auto on_con = [](int, const std::string&) {};
+    TcpServerAsio server(cfg, rpc_server.receive_callback(), on_con,
+                         rpc_server.disconnect_callback());
+    rpc_server.attach(&server);
+    ASSERT_EQ(server.listen().code(), ErrorCode::NO_ERROR);
+
+    auto io = std::make_shared<asio::io_context>();
+    auto work = asio::make_work_guard(*io);
+    std::thread runner([&]() { io->run(); });
+
+    auto tcp = std::make_shared<TcpClientAsio>(NetworkConfig{"127.0.0.1", cfg.port}, io);
+    ASSERT_EQ(tcp->connect().code(), ErrorCode::NO_ERROR);
+    auto rpc = RpcClient::create(tcp);
+
+    auto bytes = [](const std::string& s) { return std::vector<uint8_t>(s.begin(), s.end()); };
+    auto late_reply = rpc->call(bytes("late"));
+
+    // All calls are in flight at once on the one connection
+    const int kCalls = 300;
+    std::vector<std::future<RpcReply>> replies;
+    for (int i = 0; i < kCalls; ++i) replies.push_back(rpc->call(bytes(std::to_string(i))));
+    for (int i = 0; i < kCalls; ++i) {
+        RpcReply reply = replies[i].get();
+        ASSERT_EQ(reply.error.code(), ErrorCode::NO_ERROR);
+        ASSERT_EQ(reply.payload, bytes(std::to_string(i)));
+    }
+
+    // Answered out of order, still matched to its call
+    EXPECT_EQ(rpc->in_flight(), 1u);
+    late.get_future().get().reply(bytes("late:done"));
+    RpcReply reply = late_reply.get();
+    EXPECT_EQ(reply.error.code(), ErrorCode::NO_ERROR);
+    EXPECT_EQ(reply.payload, bytes("late:done"));
+
+    reply = rpc->call(bytes("never"), std::chrono::milliseconds(50)).get();
+    EXPECT_EQ(reply.error.code(), ErrorCode::TIMEOUT);
+
+    auto request = bytes("co");
+    auto co_reply = asio::co_spawn(*io, rpc->co_call(request), asio::use_future).get();
+    EXPECT_EQ(co_reply.error.code(), ErrorCode::NO_ERROR);
+    EXPECT_EQ(co_reply.payload, request);
+    EXPECT_EQ(rpc->in_flight(), 0u);
+    EXPECT_EQ(rpc_server.malformed_connections(), 0u);
+
+    rpc.reset();
+    tcp->disconnect();
+    server.gracefull_shutdown();
+    work.reset();
+    io->stop();
+    runner.join();
+}
+
+// ====================== Test 41: TLS Handshake Into A Full Socket ===============
+
+TEST(NetworkFeatureTest, TLSHandshakeResumesWhenSocketDrains) {
+    // 64 KB certificate: the server's first flight can't fit the small buffers below, so
+    // SSL_do_handshake() stops on WANT_WRITE until the client starts reading
+    auto [cert, key] = make_test_certificate(64 * 1024);
+
+    int port = 60913;
+    for (auto loop : {ServerConfig::EventLoopType::SELECT, ServerConfig::EventLoopType::EPOLL}) {
+        ServerConfig cfg;
+        cfg.port = port++;
+        cfg.event_loop = loop;
+        cfg.ssl_config.public_key = cert;
+        cfg.ssl_config.private_key = key;
+        cfg.socket_options.send_buffer = 4096;
+
+        TcpServer* server_ptr = nullptr;
+        std::atomic<int> connected{0};
+        auto rx = [&](int fd, const std::string&, const std::vector<uint8_t>& data) {
+            server_ptr->send(fd, data);
+        };
+        auto on_con = [&](int, const std::string&) { ++connected; };
+        auto on_disc = [](int, const std::string&) {};
+        TcpServer server(cfg, rx, on_con, on_disc);
+        server_ptr = &server;
+        ASSERT_EQ(server.listen().code(), ErrorCode::NO_ERROR);
+
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        int rcvbuf = 4096;
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(cfg.port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        ASSERT_EQ(::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+        SSL_CTX* ctx = SSL_CTX_new(TLS_client_method());
+        SSL_CTX_set_verify(ctx, SSL_VERIFY_NONE, nullptr);
+        SSL_CTX_set_max_cert_list(ctx, 1 << 20);
+        SSL* ssl = SSL_new(ctx);
+        SSL_set_fd(ssl, fd);
+
+        // ClientHello out, then leave the server's flight unread for a while
+        int ret = SSL_connect(ssl);
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+        // Drives an OpenSSL call on the non-blocking socket, for up to 5 s
+        auto drive = [&](auto op) {
+            const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+            int r = op();
+            while (r <= 0 && std::chrono::steady_clock::now() < deadline) {
+                int status = SSL_get_error(ssl, r);
+                if (status != SSL_ERROR_WANT_READ && status != SSL_ERROR_WANT_WRITE)
+                    break;
+                pollfd pfd{fd, short(status == SSL_ERROR_WANT_READ ? POLLIN : POLLOUT), 0};
+                poll(&pfd, 1, 100);
+                r = op();
+            }
+            return r;
+        };
+        ret = drive([&]() { return SSL_connect(ssl); });
+        EXPECT_EQ(ret, 1);
+
+        if (ret == 1) {
+            EXPECT_EQ(drive([&]() { return SSL_write(ssl, "ping", 4); }), 4);
+            char echo[4] = {};
+            EXPECT_EQ(drive([&]() { return SSL_read(ssl, echo, sizeof(echo)); }), 4);
+            EXPECT_EQ(std::string(echo, 4), "ping");
+        }
+        EXPECT_EQ(connected.load(), 1);
+
+        SSL_free(ssl);
+        SSL_CTX_free(ctx);
+        close(fd);
+        server.gracefull_shutdown();
+    }
+}
+
+// ====================== Test 42: POSIX Client Sends Into A Stalled Peer ===============
+
+TEST(NetworkFeatureTest, PosixClientQueuesSendsForStalledPeer) {
+    // Peer that accepts and then doesn't read
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    int rcvbuf = 4096;
+    setsockopt(listener, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(60915);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_EQ(bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+    ASSERT_EQ(listen(listener, 1), 0);
+
+    NetworkConfig client_cfg{"127.0.0.1", 60915};
+    client_cfg.backend_type = NetworkConfig::BackendType::POSIX;
+    client_cfg.socket_options.send_buffer = 4096;
+    auto stalled = std::make_shared<TcpClientPosix>(client_cfg);
+    ASSERT_EQ(stalled->connect().code(), ErrorCode::NO_ERROR);
+    int peer = accept(listener, nullptr, nullptr);
+    ASSERT_GE(peer, 0);
+
+    // Sends return at once; what the socket can't take is queued up to the cap
+    const size_t kChunk = 64 * 1024;
+    size_t accepted = 0;
+    bool refused = false;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 128 && !refused; ++i) {
+        std::vector<uint8_t> chunk(kChunk, static_cast<uint8_t>(i));
+        if (stalled->send_sync(chunk).code() == ErrorCode::NO_ERROR)
+            accepted += kChunk;
+        else
+            refused = true;
+    }
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+    EXPECT_TRUE(refused);
+    EXPECT_GT(accepted + kChunk, TcpClientPosix::kMaxQueuedBytes);
+
+    // The shared reactor thread isn't held up by the stalled client
+    ServerConfig cfg;
+    cfg.port = 60916;
+    cfg.event_loop = ServerConfig::EventLoopType::EPOLL;
+    TcpServer* server_ptr = nullptr;
+    auto rx = [&](int fd, const std::string&, const std::vector<uint8_t>& data) {
+        server_ptr->send(fd, data);
+    };
+    TcpServer server(cfg, rx, [](int, const std::string&) {}, [](int, const std::string&) {});
+    server_ptr = &server;
+    ASSERT_EQ(server.listen().code(), ErrorCode::NO_ERROR);
+
+    client_cfg.port = cfg.port;
+    client_cfg.auto_connect.retry_time_ms = 50;
+    auto echo = std::make_shared<TcpClientPosix>(client_cfg);
+    std::atomic<int> echoed{0};
+    echo->recieve_async([&](const std::vector<uint8_t>& data, Error err) {
+        if (err.code() == ErrorCode::NO_ERROR)
+            echoed += data.size();
+    });
+    for (int i = 0; i < 300 && !echo->is_connected(); ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ASSERT_EQ(echo->send_sync({'p', 'i', 'n', 'g'}).code(), ErrorCode::NO_ERROR);
+    for (int i = 0; i < 300 && echoed < 4; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_EQ(echoed.load(), 4);
+
+    // Once the peer reads, the reactor writes out the queue in order
+    std::vector<uint8_t> received;
+    received.reserve(accepted);
+    std::vector<uint8_t> buf(kChunk);
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (received.size() < accepted && std::chrono::steady_clock::now() < deadline) {
+        pollfd pfd{peer, POLLIN, 0};
+        if (poll(&pfd, 1, 100) <= 0)
+            continue;
+        ssize_t n = read(peer, buf.data(), buf.size());
+        if (n <= 0)
+            break;
+        received.insert(received.end(), buf.begin(), buf.begin() + n);
+    }
+    ASSERT_EQ(received.size(), accepted);
+    for (size_t i = 0; i < received.size(); i += kChunk)
+        ASSERT_EQ(received[i], static_cast<uint8_t>(i / kChunk));
+
+    // Queue drained: sends are accepted again
+    EXPECT_EQ(stalled->send_sync({'x'}).code(), ErrorCode::NO_ERROR);
+
+    start = std::chrono::steady_clock::now();
+    stalled->disconnect();
+    echo->disconnect();
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+
+    close(peer);
+    close(listener);
+    server.gracefull_shutdown();
+}
+
+// ====================== Test 43: RPC Over A TcpServer That Reuses Fds ===============
+
+TEST(NetworkFeatureTest, RpcServerDropsConnectionBeforeFdIsReused) {
+    ServerConfig cfg;
+    cfg.port = 60917;
+    cfg.event_loop = ServerConfig::EventLoopType::EPOLL;
+
+    RpcServer rpc_server([](int, std::span<const uint8_t> request, RpcServer::Responder reply) {
+        reply.reply(request);
+    });
+    std::atomic<int> disconnects{0};
+    std::atomic<int> closed_before_report{0};
+    auto on_disc = [&](int fd, const std::string&) {
+        if (fcntl(fd, F_GETFD) < 0)
+            ++closed_before_report;
+        ++disconnects;
+    };
+    auto on_con = [](int, const std::string&) {};
+    TcpServer server(cfg, rpc_server.receive_callback(), on_con,
+                     rpc_server.disconnect_callback(on_disc));
+    rpc_server.attach(&server);
+    ASSERT_EQ(server.listen().code(), ErrorCode::NO_ERROR);
+
+    auto io = std::make_shared<asio::io_context>();
+    auto work = asio::make_work_guard(*io);
+    std::thread runner([&]() { io->run(); });
+
+    // Each connection leaves half a frame behind; the next one, which usually gets the same
+    // fd, must start from a clean decoder
+    const std::vector<uint8_t> request{'r', 'p', 'c'};
+    for (int round = 0; round < 20; ++round) {
+        auto tcp = std::make_shared<TcpClientAsio>(NetworkConfig{"127.0.0.1", cfg.port}, io);
+        ASSERT_EQ(tcp->connect().code(), ErrorCode::NO_ERROR);
+        auto rpc = RpcClient::create(tcp);
+        RpcReply reply = rpc->call(request).get();
+        ASSERT_EQ(reply.error.code(), ErrorCode::NO_ERROR);
+        ASSERT_EQ(reply.payload, request);
+
+        ASSERT_EQ(tcp->send_sync({0, 0}).code(), ErrorCode::NO_ERROR);
+        rpc.reset();
+        tcp->disconnect();
+        for (int i = 0; i < 300 && disconnects <= round; ++i)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        ASSERT_EQ(disconnects.load(), round + 1);
+    }
+    EXPECT_EQ(closed_before_report.load(), 0);
+    EXPECT_EQ(rpc_server.malformed_connections(), 0u);
+
+    server.gracefull_shutdown();
+    work.reset();
+    io->stop();
+    runner.join();
+}
+
+// ====================== Test 44: GRO Receive With Latency Timestamps ===============
+
+TEST(NetworkFeatureTest, UDPOffloadWithLatencyTimestampsKeepsSegments) {
+    UdpServerOptions options;
+    options.udp_offload = true;
+    options.busy_poll.measure_latency = true;  // SO_TIMESTAMPNS cmsg ahead of UDP_GRO
+
+    std::mutex mutex;
+    std::vector<size_t> sizes;
+    UdpServer::DatagramHandler handler = [&](int, std::span<const uint8_t> data,
+                                             UdpResponder&) {
+        std::lock_guard<std::mutex> lock(mutex);
+        sizes.push_back(data.size());
+    };
+    UdpServer server(60919, handler, options);
+    ASSERT_EQ(server.start().code(), ErrorCode::NO_ERROR);
+
+    // One GSO send: 8 datagrams of 100 bytes, which GRO may hand over as one packet
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(60919);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    const int kDatagrams = 8;
+    std::vector<uint8_t> payload(kDatagrams * 100, 'g');
+    std::vector<iovec> iov(kDatagrams);
+    for (int i = 0; i < kDatagrams; ++i) iov[i] = {payload.data() + i * 100, 100};
+    if (udp_offload::gso_supported(fd)) {
+        ASSERT_GE(udp_offload::send_gso(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr),
+                                        iov.data(), iov.size(), 0),
+                  0);
+    } else {
+        for (auto& v : iov)
+            sendto(fd, v.iov_base, v.iov_len, 0, reinterpret_cast<sockaddr*>(&addr),
+                   sizeof(addr));
+    }
+
+    for (int i = 0; i < 300; ++i) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (sizes.size() >= size_t(kDatagrams))
+                break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    server.stop();
+    close(fd);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    EXPECT_EQ(sizes, std::vector<size_t>(kDatagrams, 100));
+    EXPECT_EQ(server.latency_stats().count, uint64_t(kDatagrams));
+}
+
+// ====================== Test 45: Batched Replies Past A Failing One ===============
+
+TEST(NetworkFeatureTest, UDPBatchedRepliesSkipFailedMessage) {
+    UdpServerOptions options;
+    options.batch_size = 16;
+    options.batch_timeout = std::chrono::milliseconds(20);
+
+    // "big" gets a reply no UDP datagram can carry (EMSGSIZE), the rest an echo
+    UdpServer::DatagramHandler handler = [](int, std::span<const uint8_t> data,
+                                            UdpResponder& reply) {
+        std::string req(data.begin(), data.end());
+        reply.reply(req == "big" ? std::string(70000, 'x') : "Echo:" + req);
+    };
+    UdpServer server(60920, handler, options);
+    ASSERT_EQ(server.start().code(), ErrorCode::NO_ERROR);
+
+    int s = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_GE(s, 0);
+    timeval tv{2, 0};
+    setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(60920);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+
+    // Back to back, so the failing reply leads the batch's sendmmsg()
+    for (std::string msg : {"big", "1", "2", "3"})
+        sendto(s, msg.data(), msg.size(), 0, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+
+    std::set<std::string> replies;
+    for (int i = 0; i < 3; ++i) {
+        char buf[64];
+        ssize_t n = recv(s, buf, sizeof(buf), 0);
+        ASSERT_GT(n, 0);
+        replies.emplace(buf, n);
+    }
+    EXPECT_EQ(replies, (std::set<std::string>{"Echo:1", "Echo:2", "Echo:3"}));
+
+    close(s);
+    server.stop();
+}
+
+// ====================== Test 46: io_uring Client Completes Sends On Disconnect ===============
+
+TEST(NetworkFeatureTest, TCPUringDisconnectCompletesQueuedSends) {
+    // Peer that accepts and then doesn't read, so sends pile up behind a full socket
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(60921);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_EQ(bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+    ASSERT_EQ(listen(listener, 1), 0);
+
+    NetworkConfig client_cfg{"127.0.0.1", 60921};
+    client_cfg.backend_type = NetworkConfig::BackendType::IO_URING;
+    client_cfg.socket_options.send_buffer = 4096;
+    auto conn = ClientFactory::create(client_cfg);
+    ASSERT_NE(conn, nullptr);
+    Error err = conn->connect();
+    if (err.code() == ErrorCode::NOT_IMPLEMENTED) {
+        close(listener);
+        GTEST_SKIP() << "io_uring unavailable: " << err.message();
+    }
+    ASSERT_EQ(err.code(), ErrorCode::NO_ERROR);
+    int peer = accept(listener, nullptr, nullptr);
+    ASSERT_GE(peer, 0);
+
+    const int kSends = 32;
+    std::atomic<int> completed{0};
+    for (int i = 0; i < kSends; ++i) {
+        conn->send_async(std::vector<uint8_t>(64 * 1024, 'q'), [&](Error) { ++completed; });
+    }
+
+    // A trickle of reads keeps partial sends completing while disconnect() runs
+    std::atomic<bool> draining{true};
+    std::thread reader([&]() {
+        char buf[4096];
+        while (draining) {
+            recv(peer, buf, sizeof(buf), MSG_DONTWAIT);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_LT(completed.load(), kSends);
+
+    // Every callback runs, with an error for the sends that never went out
+    conn->disconnect();
+    EXPECT_EQ(completed.load(), kSends);
+
+    draining = false;
+    reader.join();
+    close(peer);
+    close(listener);
+}
+
+// ====================== Test 47: Corked Client Queue Flushes ===============
+
+TEST(NetworkFeatureTest, TCPCorkedClientsDeliverQueuedSends) {
+    const std::pair<NetworkConfig::BackendType, int> backends[] = {
+        {NetworkConfig::BackendType::POSIX, 60922},
+        {NetworkConfig::BackendType::IO_URING, 60923},
+    };
+    for (const auto& [backend, port] : backends) {
+        // Peer that only reads once everything is queued, so sends pile up behind it
+        int listener = socket(AF_INET, SOCK_STREAM, 0);
+        int one = 1;
+        setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        ASSERT_EQ(bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+        ASSERT_EQ(listen(listener, 1), 0);
+
+        NetworkConfig client_cfg{"127.0.0.1", port};
+        client_cfg.backend_type = backend;
+        client_cfg.socket_options.tcp_cork = true;
+        client_cfg.socket_options.send_buffer = 4096;
+        auto conn = ClientFactory::create(client_cfg);
+        ASSERT_NE(conn, nullptr);
+        Error err = conn->connect();
+        if (err.code() == ErrorCode::NOT_IMPLEMENTED) {
+            close(listener);
+            continue;  // io_uring unavailable
+        }
+        ASSERT_EQ(err.code(), ErrorCode::NO_ERROR);
+        int peer = accept(listener, nullptr, nullptr);
+        ASSERT_GE(peer, 0);
+
+        // Odd-sized messages leave partial segments, the last one must still go out
+        const int kSends = 16;
+        const size_t kChunk = 16 * 1024 + 7;
+        std::atomic<int> completed{0};
+        for (int i = 0; i < kSends; ++i) {
+            conn->send_async(std::vector<uint8_t>(kChunk, static_cast<uint8_t>(i)),
+                             [&](Error e) {
+                                 if (e.code() == ErrorCode::NO_ERROR)
+                                     ++completed;
+                             });
+        }
+
+        std::vector<uint8_t> received;
+        std::vector<uint8_t> buf(kChunk);
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (received.size() < kChunk * kSends && std::chrono::steady_clock::now() < deadline) {
+            pollfd pfd{peer, POLLIN, 0};
+            if (poll(&pfd, 1, 100) <= 0)
+                continue;
+            ssize_t n = read(peer, buf.data(), buf.size());
+            if (n <= 0)
+                break;
+            received.insert(received.end(), buf.begin(), buf.begin() + n);
+        }
+        ASSERT_EQ(received.size(), kChunk * kSends);
+        for (size_t i = 0; i < received.size(); i += kChunk)
+            ASSERT_EQ(received[i], static_cast<uint8_t>(i / kChunk));
+        for (int i = 0; i < 300 && completed < kSends; ++i)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        EXPECT_EQ(completed.load(), kSends);
+
+        conn->disconnect();
+        close(peer);
+        close(listener);
+    }
+}